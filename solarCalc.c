@@ -1,1193 +1,10902 @@
-/**
- * todo:
- **/
-#include <math.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <ctype.h>
-
-#define MAXDECIMALS 6
-#define DEGCODE 248
-
-#define DEG2RAD (M_PI / 180)
-#define RAD2DEG (180 / M_PI)
-
-#define LONGRANGE 180
-#define LATRANGE 90
-
-#define DAYSINYEAR 365
-#define DAYSINMONTH 28
-#define DAYSMEDMONTH 30
-#define DAYSLONGMONTH 31
-#define NUMMONTHS 12
-#define JAN 1
-#define FEB 2
-#define MAR 3
-#define APR 4
-#define MAY 5
-#define JUN 6
-#define JUL 7
-#define AUG 8
-#define SEP 9
-#define OCT 10
-#define NOV 11
-#define DEC 12
-
-#define JDATE2000 2451544.5
-#define HRSINDAY 24
-#define MININHR 60
-#define HRS12HR 12
-
-#define JULCENTURY 36525
-#define LOCTIME 0.5
-#define BEGINDAY 0
-#define ENDDAY (1 - (1 / (HRSINDAY * MININHR)))
-
-#define TWILIGHTANGLE -0.833
-
-// function declarations
-
-// math functions
-
-double cosd(double);
-double sind(double);
-double tand(double);
-double acosd(double);
-double asind(double);
-int numDecimals(double);
-
-// input functions
-
-void getCoords(double *, double *);
-double getTimeZone(void);
-void getDate(int *, int *, int *);
-int getMonth(void);
-int goAgain(void);
-
-// time functions
-
-int isLeapYear(int);
-int monthLen(int, int);
-int getDay(int, int);
-int cumDaysInYr(int, int, int);
-int cumLpYrs(int);
-int cumDays(int, int, int);
-double calcJDate(int, int, int, double);
-void calcDate(double, double, int *, int *, int *);
-double roundToMin(double);
-int hours(double);
-int minutes(double);
-int hours12Hr(double);
-char hrType12Hr(double);
-
-// sunrise/sunset functions
-
-double calcEventApprox(double, double, double, double, double, int);
-double calcEvent(double, double, double, double, int);
-double calcEventDay(double, double, double, double, int);
-
-// output functions
-
-void printCoords(double, double);
-void printDate(double);
-void dispTime(double);
-void nominalOutput(double, double, double, double);
-void extremeLatOutput(double, double, double, double, int);
-void printAll(double, double, double, double);
-
-int main(void)
-{
-    double latitude;  // latitude (deg, - is south, + is north)
-    double longitude; // longitude (deg, - is west, + is east)
-    double timeZone;  // time zone in UTC offset.
-    int year;         // years in standard calendar
-    int month;        // month number (1-indexed)
-    int day;          // day number of the month (1-indexed)
-    double jDate;     // Julian date
-    int iterate;      // whether to keep iterating
-
-    printf("\n\n\tSolar Calculations");
-    do
-    {
-        printf("\n\n");
-
-        // get position
-        getCoords(&longitude, &latitude);
-        timeZone = getTimeZone();
-
-        // get time
-        getDate(&year, &month, &day);
-
-        jDate = calcJDate(day, month, year, timeZone);
-
-        printAll(jDate, timeZone, longitude, latitude);
-
-        // prompt to go again
-        iterate = goAgain();
-    } while (iterate == 1);
-
-    return 0;
-}
-
-// MATH FUNCTIONS
-
-/**
- * Cosine function in degrees
- *
- *  Inputs:
- * angleDeg: the angle, in degrees. Domain of all real numbers
- *
- *  Output:
- * The value of the cosine, between -1 and +1 inclusive of both
- **/
-double cosd(double angleDeg)
-{
-    return cos(angleDeg * DEG2RAD);
-}
-
-/**
- * Sine function in degrees
- *
- *  Inputs:
- * angleDeg: the angle, in degrees. Domain of all real numbers
- *
- *  Output:
- * The value of the sine, between -1 and +1 inclusive of both
- **/
-double sind(double angleDeg)
-{
-    return sin(angleDeg * DEG2RAD);
-}
-
-/**
- * Tangent function in degrees
- *
- *  Inputs:
- * angleDeg: the angle, in degrees. Domain of all real numbers excluding the vertical angles
- *
- *  Output:
- * The value of the tangent, domain of all real numbers
- **/
-double tand(double angleDeg)
-{
-    return tan(angleDeg * DEG2RAD);
-}
-
-/**
- * Arccosine written to work in degrees
- *
- *  Inputs:
- * ratio: the cosine of an unknown angle (adjacent / hypotenuse). Must be between -1 and 1.
- *
- *  Output:
- * The angle in degrees. The output will be between 0 and 180 degrees.
- **/
-double acosd(double ratio)
-{
-    return (acos(ratio) * RAD2DEG);
-}
-
-/**
- * Arcsine written to work in degrees
- *
- *  Inputs:
- * ratio: the sine of an unknown angle (opposite / hypotenuse). Must be between -1 and 1.
- *
- *  Output:
- * The angle in degrees. The output will be between -90 and 90 degrees.
- **/
-double asind(double ratio)
-{
-    return (asin(ratio) * RAD2DEG);
-}
-
-/**
- * Calculates the number of nonzero decimal places that a number has
- *
- *  Inputs:
- * number: the number to check
- *
- *  Output:
- * The angle, in degrees. Range: (-180, 180]
- **/
-int numDecimals(double number)
-{
-    int decimals = 0; // the number of decimals
-
-    while (fmod(number, 1) != 0 && decimals < MAXDECIMALS)
-    {
-        number *= 10;
-        number = fmod(number, 1);
-        decimals++;
-    }
-
-    return decimals;
-}
-
-// USER INPUT FUNCTIONS
-
-/**
- * Prompts the user whether to iterate the program again (validates input as upper or lower case Y/N
- * )
- *
- *  Inputs:
- * None
- *
- *  Output:
- * Binary whether to loop again
- **/
-int goAgain(void)
-{
-    char userInput;     // what the user inputted
-    int scanInputs = 0; // number of scanf inputs
-
-    printf("\n\n\n");
-    do
-    {
-        fflush(stdin);
-        printf("Calculate again [Y/N]? ");
-        scanInputs = scanf("%c", &userInput);
-        userInput = toupper(userInput);
-    } while (scanInputs != 1 && !(userInput == 'Y' || userInput == 'N'));
-
-    return userInput == 'Y' ? 1 : 0;
-}
-
-/**
- * Prompts the user to enter coordinates, and validates the input. Longitude must have magnitude no greater than 180. Latitude must be between -90 and 90.
- *
- *  Inputs:
- * longitude pointer: variable in which to store user-entered longitude. Positive values are east, negative are west.
- * latitude pointer: variable in which to store latitude. Positive values are north, negative are south.
- *
- *  Output:
- * None
- **/
-void getCoords(double *longitude, double *latitude)
-{
-    int scanInputs;        // number of scanf inputs
-    char inputStr[BUFSIZ]; // input string
-    int dummy;             // dummy variable to check correct number of inputs
-
-    do
-    {
-        fflush(stdin);
-        printf("Enter coordinates (latitutde longitude): ");
-        fgets(inputStr, BUFSIZ, stdin);
-        scanInputs = sscanf(inputStr, "%lf %lf %d", latitude, longitude, &dummy);
-
-        // errors
-        if (scanInputs != 2)
-        {
-            printf("\tInvalid input! Enter exactly two coordinates, separated by a space.");
-            printf("\n\tExample input:\n\tEnter coordinates (latitutde longitude): 51.51 -0.13\n");
-        }
-        else if (fabs(*latitude) >= LATRANGE || fabs(*longitude) >= LONGRANGE)
-        {
-            printf("\tInvalid input! Latitude goes from -90 to 90, longitude from -180 to 180.");
-            printf("\n\tExample input:\n\tEnter coordinates (latitutde longitude): 47.6 -122.3\n");
-        }
-    } while (scanInputs != 2 || fabs(*latitude) >= LATRANGE || fabs(*longitude) >= LONGRANGE);
-}
-
-/**
- * Prompts the user to enter a time zone and validates it. Must be between UTC-13 and UTC+13, and must be an integer time zone.
- *
- *  Inputs:
- * None
- *
- *  Output:
- * Time zone UTC offset
- **/
-double getTimeZone(void)
-{
-    double timeZoneOffset; // time zone UTC offset
-    int scanInputs;        // number of scanf inputs
-    char inputStr[BUFSIZ]; // input string
-    int dummy;             // dummy variable to check correct number of inputs
-
-    do
-    {
-        fflush(stdin);
-        printf("Time zone: UTC");
-        fgets(inputStr, BUFSIZ, stdin);
-        scanInputs = sscanf(inputStr, "%lf %d", &timeZoneOffset, &dummy);
-        if (scanInputs != 1)
-        {
-            printf("\tInvalid input! Enter exactly one input");
-            printf("\n\tExample input:\n\tUTC+0\n");
-        }
-        else if (fabs(timeZoneOffset) > 13)
-        {
-            printf("\tInvalid input! Enter a time zone in UTC (GMT) offset. Must be between -13 and +13.");
-            printf("\n\tExample input:\n\tUTC-8\n");
-        }
-    } while (scanInputs != 1 || fabs(timeZoneOffset) > 13);
-
-    return timeZoneOffset;
-}
-
-/**
- * Prompts the user to enter a date as YYYY DD MM
- *
- *  Inputs:
- * int pointer year: the variable to store the year in
- * int pointer month: the variable to store the month in
- * int pointer day: the variable to store the day in
- *
- *  Output:
- * None
- **/
-void getDate(int *year, int *month, int *day)
-{
-    int scanInputs;        // number of scan inputs
-    char inputStr[BUFSIZ]; // input string
-    int dummy;             // dummy variable to check correct number of inputs
-
-    do
-    {
-        fflush(stdin);
-        printf("Enter a date as YYYY MM DD: ");
-        fgets(inputStr, BUFSIZ, stdin);
-        scanInputs = sscanf(inputStr, "%d %d %d %d", year, month, day, &dummy);
-        if (scanInputs != 3)
-        {
-            printf("\tInvalid input! Enter exactly three inputs separated by spaces.");
-            printf("\n\tExample input:\n\tEnter a date as YYYY MM DD: 2035 6 21\n");
-        }
-        else if (*year <= 0)
-        {
-            printf("\tInvalid input! The year must be positive.");
-            printf("\n\tExample input:\n\tEnter a date as YYYY MM DD: 1969 7 16\n");
-        }
-        else if (*month < 1 || *month > 12)
-        {
-            printf("\tInvalid input! The month must be a month between 1 and 12.");
-            printf("\n\tExample input:\n\tEnter a date as YYYY MM DD: 2021 2 18\n");
-        }
-        else if (*day < 1 || *day > monthLen(*month, *year))
-        {
-            printf("\tInvalid input! The day must be a valid day in the month you chose.");
-            printf("\n\tExample input:\n\tEnter a date as YYYY MM DD: %04d %02d %02d\n", *year, *month, monthLen(*month, *year));
-        }
-    } while (scanInputs != 3 || *year <= 0 || *month < 1 || *month > 12 || *day < 1 || *day > monthLen(*month, *year));
-}
-
-// TIME MANIPULATION FUNCTIONS
-
-/**
- * Determines whether a given year is a leap year
- *
- *  Inputs:
- * year: the year
- *
- *  Output:
- * 0 if the given year isn't a leapyear, 1 if it is.
- **/
-int isLeapYear(int year)
-{
-    return (!(year % 4) && (year % 100)) || !(year % 400);
-}
-
-/**
- * Determines the number of days in a given month
- *
- *  Inputs:
- * month: the number of the month in the year
- * year: the year (to know whether february has an extra day)
- *
- *  Output:
- * The number of days in the month
- **/
-int monthLen(int month, int year)
-{
-    int numDays; // number of days in the month
-
-    if (month == FEB)
-    {
-        numDays = DAYSINMONTH + isLeapYear(year);
-    }
-    else if (month == APR || month == JUN || month == SEP || month == NOV)
-    {
-        numDays = DAYSMEDMONTH;
-    }
-    else
-    {
-        numDays = DAYSLONGMONTH;
-    }
-
-    return numDays;
-}
-
-/**
- * Counts the number of days that have occurred in the year at a given date (including the 1st day).
- *
- *  Inputs:
- * day: the day number in the month
- * month: the month number of the year
- * year: the year number
- *
- *  Output:
- * total number of days
- **/
-int cumDaysInYr(int day, int month, int year)
-{
-    int days = 0; // total number of days in the year
-
-    for (int i = 1; i < month; i += 1)
-    {
-        days += monthLen(i, year);
-    }
-
-    for (int i = 0; i < day; i++)
-    {
-        days += 1;
-    }
-
-    return days;
-}
-
-/**
- * Counts the number of leap years that have occurred since 2000 (works backward as well). Does not count the given year
- *
- *  Inputs:
- * year: the year to check up to
- *
- *  Output:
- * Number of years that have been leap years
- **/
-int cumLpYrs(int year)
-{
-    int yrs = 0; // number of leap years since 2000 (works backward too)
-
-    if (year > 2000)
-    {
-        for (int i = 2000; i < year; i++)
-        {
-            yrs += isLeapYear(i);
-        }
-    }
-    else
-    {
-        for (int i = 2000; i > year; i--)
-        {
-            yrs -= isLeapYear(i);
-        }
-    }
-
-    return yrs;
-}
-
-/**
- * Counts the total number of days between Jan 1 2000 and a given date (what you have to add to jan 1 to get the current date)
- *
- *  Inputs:
- * day: the day number in the month
- * month: the month number of the year
- * year: the year number
- *
- *  Output:
- * Total number of days
- **/
-int cumDays(int day, int month, int year)
-{
-    int days = 0; // number of days since jan 1 2000 (should work backward)
-
-    days += cumDaysInYr(day, month, year);
-    days += DAYSINYEAR * (year - 2000);
-    days += cumLpYrs(year);
-    days -= (year >= 2000);
-
-    return days;
-}
-
-/**
- * Calculates the Julain date for a given Gregorian date
- *
- *  Inputs:
- * day: the day number in the month
- * month: the month number of the year
- * year: the year number
- * timeZone: the time zone UTC offset
- *
- *  Output:
- * Julian date of the beginning of the day
- **/
-double calcJDate(int day, int month, int year, double timeZone)
-{
-    double jDate; // Julian date for the given date
-
-    jDate = JDATE2000;
-    jDate += cumDays(day, month, year);
-
-    return jDate;
-}
-
-/**
- * Reverse of the calcJDate function. Calculates the day/month/year for a given Julian date
- *
- *  Inputs:
- * jDate: the Julain date for the beginning of the day
- * tZ: the time zone in UTC offset
- * pointer day: variable in which to store the day number
- * pointer month: variable in which to store the month number
- * pointer year: variable in which to store the year number
- *
- *  Output:
- * None (pointers)
- **/
-void calcDate(double jDate, double tZ, int *day, int *month, int *year)
-{
-    double currentJD; // current julian date (will default to the jDate of jan1 2000)
-
-    *day = 1;
-    *month = 1;
-    *year = 2000;
-    currentJD = calcJDate(*day, *month, *year, tZ);
-
-    while (currentJD < jDate)
-    {
-        if (*day < monthLen(*month, *year))
-        {
-            *day += 1;
-        }
-        else if (*month < NUMMONTHS)
-        {
-            *month += 1;
-            *day = 1;
-        }
-        else
-        {
-            *year += 1;
-            *month = 1;
-            *day = 1;
-        }
-        currentJD += 1;
-    }
-
-    while (currentJD > jDate)
-    {
-        if (*day > 1)
-        {
-            *day -= 1;
-        }
-        else if (*month > 1)
-        {
-            *month -= 1;
-            *day = monthLen(*month, *year);
-        }
-        else
-        {
-            *year -= 1;
-            *month = NUMMONTHS;
-            *day = monthLen(*month, *year);
-        }
-        currentJD -= 1;
-    }
-}
-
-/**
- * Rounds a given time to the nearest minute
- *
- *  Inputs:
- * timeDay: Decimal day. Range is [0:1)
- *
- *  Output:
- * Decimal day rounded to the nearest minute
- **/
-double roundToMin(double timeDay)
-{
-    return round(timeDay * MININHR * HRSINDAY) / (MININHR * HRSINDAY);
-}
-
-/**
- * Finds the hour of a given time of day (in 24hr time)
- *
- *  Inputs:
- * timeDay: decimal day. Range is [0, 1)
- *
- *  Output:
- * Number of hours. Will be between 0 and 23 inclusive of both
- **/
-int hours(double timeDay)
-{
-    return (int)(roundToMin(timeDay) * HRSINDAY) % HRSINDAY;
-}
-
-/**
- * Finds the hour of a given time of day, in 12hr time
- *
- *  Inputs:
- * timeDay: decimal day. Range is [0, 1)
- *
- *  Output:
- * Hour number on the clock, between 1 and 12 inclusive of both.
- **/
-int hours12Hr(double timeDay)
-{
-    int hr; // hour on the clock. 1-12 inclusive
-
-    hr = hours(timeDay) % HRS12HR;
-    if (hr == 0)
-    {
-        hr = 12;
-    }
-
-    return hr;
-}
-
-/**
- * Determines if a given time is AM or PM
- *
- *  Inputs:
- * timeDay: decimal day. Range is [0, 1)
- *
- *  Output:
- * 'A' or 'P', depending on if it's AM or PM
- **/
-char hrType12Hr(double timeDay)
-{
-    return (hours(timeDay) >= HRS12HR) ? 'P' : 'A';
-}
-
-/**
- * Finds the value of the minute hand at a given time
- *
- *  Inputs:
- * timeDay: decimal day. Range is [0, 1)
- *
- *  Output:
- * Number of minutes. Will be between 0 and 59 inclusive of both
- **/
-int minutes(double timeDay)
-{
-    int mins; // minute on the clock. 0-59 inclusive
-
-    mins = round(MININHR * HRSINDAY * roundToMin(timeDay));
-    mins -= MININHR * hours(roundToMin(timeDay));
-
-    return mins;
-}
-
-// SOLAR CALCULATION FUNCTIONS
-
-/**
- * Calculates approximately when a given solar event happens
- *
- *  Inputs:
- * jDate: Julian date to check. Must be the beginning of a day, locTime modifies for fractional days
- * tZ: time zone in UTC offset
- * longitude: East/west component of position find solar event
- * latitude: North/South component of position find solar event
- * locTime: decimal day offset for when to check
- * event: The event to check:
- *  > 1: sunrise
- *  > 2: solar noon
- *  > 3: sunset
- *  > 0: day status
- *
- *  Output:
- * Decimal day time of event. -1 means it doesn't happen
- **/
-double calcEventApprox(double jDate, double tZ, double longitude, double latitude, double locTime, int event)
-{
-    double geomMeanLongSun;  // Geometric mean longitude (L0) of the sun
-    double geomMeanAnomSun;  // Geometric mean anomaly of the sun
-    double eccentEarthOrbit; // Earth orbit eccentricity
-    double sunEqCtr;         // Sun's equation of center (error of position with respect to a circular orbit of same period)
-    double sunTruLong;       // Ecliptic Longitude of earth if the sun had 0 inclination
-    double sunAppLong;       // Apparent Longitude of the sun
-    double meanObliqEclip;   // Oblique ecliptic: Mean inclination of Earth’s equator relative to the Sun/planets apparent plane
-    double obliqCorr;        // Oblique ecliptic corrected
-    double sunDeclin;        // Sun's angular distance north/south of the equator
-    double varY;             // ADD COMMENT
-    double eqOfTime;         // Difference between apparent solar time and mean solar time
-    double funcArg;          // argument of arccosine, so that we don't get an error if the value is of magnitude greater than 1
-    double HASunrise;        // Cosine of the hour angle from the observer
-    double jCent;            // Julian century
-
-    double noon;           // solar noon (decimal day)
-    double rise = locTime; // sunrise (decimal day)
-    double set = locTime;  // sunset (decimal day)
-
-    int status; // what the day does. 0 it starts and ends, 1 there's sunlight all 24hrs. -1 it's dark all 24hrs
-
-    double eventTime; // Time of the given event.
-
-    // locTime -= longitude / (15 * HRSINDAY);
-    jDate += locTime;
-    jCent = ((jDate - JDATE2000 - 1) / JULCENTURY);
-    geomMeanLongSun = fmod(280.46646 + jCent * (36000.76983 + jCent * 0.0003032), 360);
-    geomMeanAnomSun = 357.52911 + jCent * (35999.05029 - 0.0001537 * jCent);
-    eccentEarthOrbit = 0.016708634 - jCent * (0.000042037 + 0.0000001267 * jCent);
-    sunEqCtr = sind(geomMeanAnomSun) * (1.914602 - jCent * (0.004817 + 0.000014 * jCent)) + sind(2 * geomMeanAnomSun) * (0.019993 - 0.000101 * jCent) + sind(3 * geomMeanAnomSun) * 0.000289;
-    sunTruLong = geomMeanLongSun + sunEqCtr;
-    sunAppLong = sunTruLong - 0.00569 - 0.00478 * sind(125.04 - 1934.136 * jCent);
-    meanObliqEclip = (HRSINDAY - 1) + (26 + ((21.448 - jCent * (46.815 + jCent * (0.00059 - jCent * 0.001813)))) / MININHR) / MININHR;
-    obliqCorr = meanObliqEclip + 0.00256 * cosd(125.04 - 1934.136 * jCent);
-    sunDeclin = asind(sind(obliqCorr) * sind(sunAppLong));
-    varY = pow(tand(obliqCorr / 2), 2);
-    eqOfTime = 4 * RAD2DEG * (varY * sind(2 * geomMeanLongSun) - 2 * eccentEarthOrbit * sind(geomMeanAnomSun) + 4 * eccentEarthOrbit * varY * sind(geomMeanAnomSun) * cosd(2 * geomMeanLongSun) - 0.5 * pow(varY, 2) * sind(4 * geomMeanLongSun) - 1.25 * pow(eccentEarthOrbit, 2) * sind(2 * geomMeanAnomSun));
-    funcArg = sind(TWILIGHTANGLE) / (cosd(latitude) * cosd(sunDeclin)) - tand(latitude) * tand(sunDeclin);
-
-    if (funcArg < -1)
-    {
-        status = 1;
-        rise = -100;
-        set = -100;
-        noon = -100;
-    }
-    else if (funcArg > 1)
-    {
-        status = -1;
-        rise = -100;
-        set = -100;
-        noon = -100;
-    }
-    else
-    {
-        status = 0;
-        HASunrise = acosd(funcArg);
-        noon = (720 - 4.0 * longitude - eqOfTime + tZ * MININHR) / (HRSINDAY * MININHR);
-        rise = noon - HASunrise * 4.0 / (HRSINDAY * MININHR);
-        set = noon + HASunrise * 4.0 / (HRSINDAY * MININHR);
-    }
-
-    switch (event)
-    {
-    case 1:
-        eventTime = rise;
-        break;
-    case 2:
-        eventTime = noon;
-        break;
-    case 3:
-        eventTime = set;
-        break;
-    case 0:
-        eventTime = status;
-        break;
-    }
-
-    return eventTime;
-}
-
-/**
- * Uses the approximate function to predict exact sunrise/sunset
- *
- *  Inputs:
- * jDate: Julian date to check. Must be the beginning of a day. Must be beginning of the day.
- * tZ: time zone in UTC offset
- * longitude: East/west component of position find solar event
- * latitude: North/South component of position find solar event
- * event: The event to check:
- *  > 1: sunrise
- *  > 2: solar noon
- *  > 3: sunset
- *
- *  Output:
- * Decimal day time of event. -1 means it doesn't happen
- **/
-double calcEvent(double jDate, double tZ, double longitude, double latitude, int event)
-{
-    double locTimePrev;    // local time from previous iteration
-    double ansBegin;       // answer as of beginning of day
-    double ansEnd;         // answer as of end of day
-    double properTimeZone; // the time zone if it were perfect
-
-    double finalAns; // final answer
-
-    ansBegin = BEGINDAY;
-    // printf("calcEvent called on jDate %.2f\n", jDate);
-
-    properTimeZone = longitude / (15);
-
-    do
-    {
-        locTimePrev = ansBegin;
-        ansBegin = calcEventApprox(jDate, properTimeZone, longitude, latitude, ansBegin, event);
-    } while (ansBegin >= -1 && ansBegin <= 2 && roundToMin(ansBegin) != roundToMin(locTimePrev));
-
-    ansEnd = ENDDAY;
-    do
-    {
-        locTimePrev = ansEnd;
-        ansEnd = calcEventApprox(jDate, properTimeZone, longitude, latitude, ansEnd, event);
-    } while (ansEnd >= -1 && ansEnd <= 2 && roundToMin(ansEnd) != roundToMin(locTimePrev));
-
-    finalAns = fmax(ansEnd, ansBegin);
-
-    finalAns -= properTimeZone / HRSINDAY;
-    finalAns += tZ / HRSINDAY;
-
-    return finalAns;
-}
-
-/**
- * Calculates what type of solar day it is / how many solar events happen
- *
- *  Inputs:
- * jDate: Julian date to check. Must be the beginning of a day, locTime modifies for fractional days
- * tZ: time zone in UTC offset
- * longitude: East/west component of position
- * latitude: North/South component of position
- *
- *  Output:
- * -2: it's night for all 24hrs
- * -1: it's day for all 24hrs
- * 1: the sun rises OR sets, but not both
- * 2: the sun rises AND sets (normal day)
- **/
-int calcDayType(double jDate, double tZ, double longitude, double latitude)
-{
-    int output = 0; // function output
-    int statBegin;  // status as of beginning of day
-    int statEnd;    // status as of end of day;
-
-    statBegin = calcEventApprox(jDate, tZ, longitude, latitude, BEGINDAY, 0);
-    statEnd = calcEventApprox(jDate, tZ, longitude, latitude, ENDDAY, 0);
-
-    output += (!statBegin || !statEnd);
-    output += (!statBegin && !statEnd);
-
-    if (output == 0)
-    {
-        switch (statBegin)
-        {
-        case -1: // dark all 24hrs
-            output = -2;
-            break;
-        case 1: // light all 24hrs
-            output = -1;
-            break;
-        }
-    }
-
-    return output;
-}
-
-/**
- * Calculates the next or last specific solar event
- *
- *  Inputs:
- * jDate: Julian date to check. Must be the beginning of a day
- * tZ: time zone in UTC offset
- * longitude: East/west component of position find solar event
- * latitude: North/South component of position find solar event
- * locTime: decimal day offset for when to check
- * option: The event to find:
- *  > -1: last sunrise
- *  > 1: next sunrise
- *  > -3: last sunset
- *  > 3: next sunset
- *
- *  Output:
- * Julian date of the next day that the given event happens
- **/
-double calcEventDay(double longitude, double latitude, double timeZone, double jDate, int option)
-{
-    int direction; // the sign of option
-    int dayStatus; // what the day does
-    int event;     // event, like whats used for the other functions
-
-    event = abs(option);
-    direction = (option > 0) - (option < 0);
-
-    do
-    {
-        dayStatus = calcEvent(jDate, timeZone, longitude, latitude, event);
-        jDate += direction;
-    } while (dayStatus < -1 || dayStatus >= 2);
-
-    jDate -= direction;
-
-    return jDate;
-}
-
-// DISPLAY FUNCTIONS
-
-/**
- * Prints coordinates with N/S and a degree symbol
- *
- *  Inputs:
- * longitude: longitude, with negative for west and positive for east
- * latitude: latitude, negative is south and positive is north
- *
- *  Output:
- * None
- **/
-void printCoords(double longitude, double latitude)
-{
-    char latDirection = 'N';  // latitude cardinal direction
-    char longDirection = 'E'; // longitude cardinal direction
-    int longDecimals;         // number of decimal places in the longitude coordinate
-    int latDecimals;          // number of decimal places in the latitude coordinate
-
-    longDecimals = numDecimals(longitude);
-    latDecimals = numDecimals(latitude);
-
-    if (latitude < 0)
-    {
-        latDirection = 'S';
-    }
-
-    if (longitude < 0)
-    {
-        longDirection = 'W';
-    }
-
-    printf("%.*lf%c %c, %.*lf%c %c",
-           latDecimals, fabs(latitude), DEGCODE, latDirection,
-           longDecimals, fabs(longitude), DEGCODE, longDirection);
-}
-
-/**
- * Prints a date to as DD Monthname, YYYY
- *
- *  Inputs:
- * jDate: Julian date to print
- *
- *  Output:
- * None
- **/
-void printDate(double jDate)
-{
-    int day;   // day of the month
-    int month; // month of the year
-    int year;  // standard calendar year
-
-    calcDate(jDate, 0, &day, &month, &year);
-
-    printf("%02d ", day);
-    switch (month)
-    {
-    case JAN:
-        printf("January");
-        break;
-    case FEB:
-        printf("February");
-        break;
-    case MAR:
-        printf("March");
-        break;
-    case APR:
-        printf("April");
-        break;
-    case MAY:
-        printf("May");
-        break;
-    case JUN:
-        printf("June");
-        break;
-    case JUL:
-        printf("July");
-        break;
-    case AUG:
-        printf("August");
-        break;
-    case SEP:
-        printf("September");
-        break;
-    case OCT:
-        printf("October");
-        break;
-    case NOV:
-        printf("November");
-        break;
-    case DEC:
-        printf("December");
-        break;
-    }
-    printf(", %d", year);
-}
-
-/**
- * Prints a time in both 24 and 12 hour format
- *
- *  Inputs:
- * fracDay: the time of day as a decimal day
- *
- *  Output:
- * None
- **/
-void dispTime(double fracDay)
-{
-    int hrs;   // hours
-    int min;   // mins
-    int hrs12; // 12hr hours
-
-    hrs = hours(fracDay);
-    hrs12 = hours12Hr(fracDay);
-    min = minutes(fracDay);
-
-    if (fracDay >= 0 && fracDay < 1)
-    {
-        printf("%02d:%02d (%d:%02d %cM)", hours(fracDay), minutes(fracDay),
-               hours12Hr(fracDay), minutes(fracDay), hrType12Hr(fracDay));
-    }
-    else if (fracDay >= -1 && fracDay < 0)
-    {
-        fracDay++;
-        printf("%02d:%02d (%d:%02d %cM) the previous date", hours(fracDay), minutes(fracDay),
-               hours12Hr(fracDay), minutes(fracDay), hrType12Hr(fracDay));
-    }
-    else if (fracDay >= 1 && fracDay < 2)
-    {
-        fracDay--;
-        printf("%02d:%02d (%d:%02d %cM) the previous date", hours(fracDay), minutes(fracDay),
-               hours12Hr(fracDay), minutes(fracDay), hrType12Hr(fracDay));
-    }
-    else
-    {
-        printf("None");
-    }
-}
-
-/**
- * Prints the output for a nominal day with a sunrise or sunset. Shows sunrise, sunset, and solar noon times
- *
- *  Inputs:
- * jDate: Julian date to check. Must be the beginning of a day
- * tZ: time zone in UTC offset
- * longitude: East/west component of position find solar event
- * latitude: North/South component of position find solar event
- *
- *  Output:
- * None
- **/
-void nominalOutput(double jDate, double timeZone, double longitude, double latitude)
-{
-    double riseTime; // sunrise time (decimal day - local time)
-    double setTime;  // sunset time (decimal day - local time)
-    double solNoon;  // solar noon (decimal day - local time)
-    double duration; // amount of sunlight (decimal day)
-
-    riseTime = calcEvent(jDate, timeZone, longitude, latitude, 1);
-    solNoon = calcEvent(jDate, timeZone, longitude, latitude, 2);
-    setTime = calcEvent(jDate, timeZone, longitude, latitude, 3);
-    duration = setTime - riseTime;
-
-    printf("\nSunrise: ");
-    dispTime(riseTime);
-
-    printf("\nSolar Noon: ");
-    dispTime(solNoon);
-
-    printf("\nSunset: ");
-    dispTime(setTime);
-
-    if (setTime >= -1 && riseTime >= -1)
-    {
-        printf("\nThere are %d hrs and %d minutes of sunlight", hours(duration), minutes(duration));
-    }
-
-    printf("\n\n");
-}
-
-/**
- * Prints the output for a day with neither sunrise nor sunset. Displays last event and next event dates and times.
- *
- *  Inputs:
- * jDate: Julian date to check. Must be the beginning of a day
- * tZ: time zone in UTC offset
- * longitude: East/west component of position find solar event
- * latitude: North/South component of position find solar event
- * status: The day type as determined by calcDayType
- *
- *  Output:
- * None
- **/
-void extremeLatOutput(double jDate, double timeZone, double longitude, double latitude, int status)
-{
-    double lastEventDay;  // Julian date for the last event
-    double nextEventDay;  // Julain date for the next event
-    double lastEventTime; // time for the last event (decimal day)
-    double nextEventTime; // time for the next event (decimal day)
-    double noon;          // solar noon time
-    int numDays;          // number of days between two events
-    int numHrs;           // number of excess hours between two events
-    int numMins;          // number of excess minutes between two events
-    double diff;          // difference between jDates of the two events (decimal day)
-
-    switch (status)
-    {
-    case -1:
-        lastEventDay = calcEventDay(longitude, latitude, timeZone, jDate, -1);
-        nextEventDay = calcEventDay(longitude, latitude, timeZone, jDate, 3);
-        lastEventTime = calcEvent(lastEventDay, timeZone, longitude, latitude, 1);
-        nextEventTime = calcEvent(nextEventDay, timeZone, longitude, latitude, 3);
-        break;
-    case -2:
-        lastEventDay = calcEventDay(longitude, latitude, timeZone, jDate, -3);
-        nextEventDay = calcEventDay(longitude, latitude, timeZone, jDate, 1);
-        nextEventTime = calcEvent(nextEventDay, timeZone, longitude, latitude, 1);
-        lastEventTime = calcEvent(lastEventDay, timeZone, longitude, latitude, 3);
-    }
-    noon = calcEvent(jDate, timeZone, longitude, latitude, 2);
-
-    numMins = (minutes(1 - lastEventTime) + minutes(nextEventTime)) % MININHR;
-    numHrs = hours(1 - lastEventTime) + hours(nextEventTime) + (minutes(1 - lastEventTime) + minutes(nextEventTime)) / MININHR;
-    diff = nextEventDay - lastEventDay;
-    numDays = floor(diff - (numHrs / (double)HRSINDAY) - numMins / ((double)HRSINDAY * MININHR));
-
-    switch (status)
-    {
-    case -1:
-        printf("The sun doesn't set. It's day for all 24hrs.\n\n");
-        printf("\nThe sun rose on ");
-        printDate(lastEventDay);
-        printf(", at ");
-        dispTime(lastEventTime);
-        printf("\nThe sun will set on ");
-        printDate(nextEventDay);
-        printf(", at ");
-        dispTime(nextEventTime);
-        printf("\nThe solar day lasts %d days, %d hours, and %d minutes", numDays, numHrs, numMins);
-        break;
-    case -2:
-        printf("The sun doesn't rise. It's night for all 24hrs.\n\n");
-        printf("The sun set on ");
-        printDate(lastEventDay);
-        printf(", at ");
-        dispTime(lastEventTime);
-        printf("\nThe sun will rise on ");
-        printDate(nextEventDay);
-        printf(", at ");
-        dispTime(nextEventTime);
-        printf("\nThe solar night lasts %d days, %d hours, and %d minutes", numDays, numHrs, numMins);
-        break;
-    }
-}
-
-/**
- * Calls the respective print functions to print the total output
- *
- *  Inputs:
- * jDate: Julian date to check. Must be the beginning of a day
- * longitude: East/west component of position find solar event
- * latitude: North/South component of position find solar event
- *
- *  Output:
- * None
- **/
-void printAll(double jDate, double timeZone, double longitude, double latitude)
-{
-    int dayStatus; // whether the sun rises, sets, or both
-    int dayType;   // The type of day: all night, all day, sunrise and sunsent, or just one?
-
-    dayType = calcDayType(jDate, timeZone, longitude, latitude);
-
-    printf("\n\n\t");
-    printDate(jDate);
-    printf("\n\t");
-    printCoords(longitude, latitude);
-    printf("\n\n");
-    if (dayType > 0)
-    { // there's a sunrise or sunset
-        nominalOutput(jDate, timeZone, longitude, latitude);
-    }
-    else
-    { // there's neither a sunrise nor a sunset
-        extremeLatOutput(jDate, timeZone, longitude, latitude, dayType);
-    }
-}
\ No newline at end of file
+/**
+ * todo:
+ **/
+#define _GNU_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "solarCalc.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#endif
+
+// OpenMP directives, compiled out when building without -fopenmp
+#ifdef _OPENMP
+#define OMP(...) _Pragma(OMPSTRING(omp __VA_ARGS__))
+#define OMPSTRING(...) #__VA_ARGS__
+#else
+#define OMP(...)
+#endif
+
+#define MAXDECIMALS 6
+#define DEGCODE 248
+
+#define DEG2RAD (M_PI / 180)
+#define RAD2DEG (180 / M_PI)
+
+#define LONGRANGE 180
+#define LATRANGE 90
+
+#define DAYSINYEAR 365
+#define DAYSINMONTH 28
+#define DAYSMEDMONTH 30
+#define DAYSLONGMONTH 31
+#define NUMMONTHS 12
+#define JAN 1
+#define FEB 2
+#define MAR 3
+#define APR 4
+#define MAY 5
+#define JUN 6
+#define JUL 7
+#define AUG 8
+#define SEP 9
+#define OCT 10
+#define NOV 11
+#define DEC 12
+
+#define JDATE2000 2451544.5
+#define JDATEUNIX 2440587.5
+#define SECINDAY 86400
+#define MSINSEC 1000
+#define NOEPOCH INT64_MIN
+#define HRSINDAY 24
+#define MININHR 60
+#define HRS12HR 12
+
+#define JULCENTURY 36525
+#define LOCTIME 0.5
+#define BEGINDAY 0
+#define ENDDAY (1 - (1 / (HRSINDAY * MININHR)))
+
+#define TWILIGHTANGLE -0.833
+#define CIVILANGLE -6
+#define NAUTICALANGLE -12
+#define ASTROANGLE -18
+#define NUMTWILIGHTS 3
+
+#define MAXDAYEVENTS 8
+#define ENUMLAT 60
+#define MINSTEP (1.0 / (HRSINDAY * MININHR))
+#define ROOTTOL (1.0 / (HRSINDAY * MININHR * MININHR))
+#define MAXROOTITER 60
+#define DECLINRATE 0.01
+#define MAXPOLARDAYS 256
+#define MAXEVENTITER 256
+#define EVENTTOL 1e-9
+#define MAXEVENTDAYS 800
+#define NOEVENTDAY -1
+#define MISSEDDEADLINE -2
+
+#define SITEBLOCK 256
+#define DATEBLOCK 64
+#define MAXGRIDITER 8
+#define STATSTRIPE 65536
+#define NOTIME INT16_MIN
+#define MAXSHARDS 256
+#define SHARDSAMPLE 7
+#define MAXTHREADS 1024
+#define MAXNODES 64
+#define HUGEPAGESIZE (2 * 1024 * 1024)
+
+#define COLMAGIC "SOLCOL1"
+#define COLALIGN 64
+#define COLNAMELEN 16
+#define NUMCOLUMNS 11
+#define COLFLOAT32 0
+#define COLINT8 1
+#define COLRISE 0
+#define COLNOON 1
+#define COLSET 2
+#define COLDAYLEN 3
+#define COLSTATUS 4
+#define COLTWILIGHT 5
+
+#define TZDIR "/usr/share/zoneinfo"
+#define TZNAMELEN 64
+#define MAXZONES 64
+#define TZMAXYEAR 2200
+#define SECINHR 3600
+#define SECINMIN 60
+#define DAYSINWEEK 7
+#define TZDEFAULTTIME 7200
+
+#define HORMAGIC "SOLHOR1"
+#define HORIZONBINS 64
+#define HORIZONSCALE 0.25
+#define DIPCOEFF 0.0293
+#define MAXHORIZONITER 6
+#define HORIZONTOL 0.001
+
+#define INVRISE 1
+#define INVSET 3
+#define INVDAYLEN 4
+#define INVSTEP 32
+#define INVPOLARLAT 64
+#define INVUNKNOWN HUGE_VAL
+#define INVBANDWIDTH 1.0
+#define INVPAD (2.0 / (HRSINDAY * MININHR))
+
+#define NUMENGINES 6
+#define ENGCALCEVENT 0
+#define ENGENUM 1
+#define ENGGRID 2
+#define ENGFLOAT32 3
+#define ENGHORIZON 4
+#define ENGSPAN 5
+#define REFTOL 1e-11L
+#define MAXREFITER 100
+#define EDGELATMIN 65.5
+#define EDGELATSTEP 0.05
+#define EDGEROWS 50
+#define EDGECOLS 5
+#define ACCMAXERR 30.0
+#define ACCPERCENTILE 0.99
+#define MAXSTATUSLIST 10
+
+#define TABLEBLOCK 32
+#define TABLENONE 2047
+#define TABLEANCHORBITS 11
+#define TABLEWIDTHBITS 4
+#define TABLEHEADER 4
+#define TABLELINE 16
+
+#define FUZZEVENT 0
+#define FUZZDAY 1
+#define FUZZKEEP 8
+#define FUZZROUNDS 4000
+#define FUZZMINSCALE 1e-7
+#define FUZZREPS 200
+#define FUZZYEARS 200
+#define FUZZFIRSTYEAR 1900
+#define MAXCORPUS 1024
+
+#define LIGHTNIGHT 0
+#define LIGHTASTRO 1
+#define LIGHTNAUTICAL 2
+#define LIGHTCIVIL 3
+#define LIGHTDAY 4
+#define LIGHTCHUNK 1024
+#define LIGHTNODESEC 3600
+#define LIGHTCACHE 256
+#define ROUNDMAGIC 6755399441055744.0
+#define LIGHTBENCHDAYS 7
+
+#define PROFOTHER 0
+#define PROFEPHEM 1
+#define PROFSOLVE 2
+#define PROFPOLAR 3
+#define PROFENUM 4
+#define PROFOUTPUT 5
+#define NUMSTAGES 6
+#define PROFCALIBSTAGE NUMSTAGES
+#define PROFCYCLES 0
+#define PROFINSTRS 1
+#define PROFBRANCHMISS 2
+#define PROFCACHEMISS 3
+#define NUMCOUNTERS 4
+#define PROFDEPTH 16
+#define PROFCALIB 100000
+#define PROFBATCHES 9
+#define PROFSAMPLE 64
+#define PROFREPLAY 1024
+#define PROFREPEATS 32
+#define PROFMISSCYCLES 15
+
+// stage profiling (profile mode and batch profile) is only compiled in with -DSOLARPROFILE. Other builds call libm
+// straight from the degree trig functions, and profEnter/profLeave do nothing
+#ifdef SOLARPROFILE
+#define PROFLIBM(func, arg) (activeProfile ? profLibm(func, arg) : func(arg))
+#else
+#define PROFLIBM(func, arg) func(arg)
+#endif
+
+#define SERVECACHE 4096
+#define SERVEEXACT 0
+#define SERVECACHED 1
+#define SERVEPREDICTED 2
+#define SERVETIMEDOUT 3
+#define SERVEEWMA 0.1
+#define SERVECALIBLAT 80
+#define ESTIMATEDAYS 1
+#define SERVERESERVEDAYS 8
+
+#define TRACKSTEPSEC 600
+#define TRACKTOLSEC 1
+#define TRACKMAXITERS 50
+#define TRACKBENCHLAT 75
+#define TRACKBENCHDAYS 10
+#define TRACKBENCHSPEED 0.005
+
+#define SPANLANES 16
+#define SPANBLOCK 256
+#define SPANGUARD 1e-8
+#define SPANEDGE 1e-4
+
+#define TILESIZE 256
+#define TILEPIXELS (TILESIZE * TILESIZE)
+#define TILEMAXZOOM 20
+#define TILERISE 0
+#define TILESET 1
+#define TILELENGTH 2
+#define NUMTILELAYERS 3
+#define TILEMEMORY 0
+#define TILEDISK 1
+#define TILEDERIVED 2
+#define TILECOMPUTED 3
+#define TILECACHE 512
+#define TILEDATES 256
+#define TILEPOPULAR 16
+#define TILEPREFETCHZOOM 3
+#define TILEQUEUE 1024
+#define TILEBACKLOG 64
+#define TILETIMEOUT 2
+
+#define TERMBANDS 4
+#define TERMPIECES 8
+#define TERMBLOCK 256
+#define EARTHRADIUS 6371.0
+#define TERMBENCHLINES 52
+#define TERMBENCHSTART 1704067200
+#define TERMBENCHSTEP 622923
+#define TERMCHECKSTRIDE 97
+#define TERMCHECKTOL 1e-6
+
+// a single solar event within a day
+typedef struct
+{
+    double time; // decimal day of the event, in the requested time zone. Range is [0, 1)
+    int type;    // event code as used by calcEvent: 1 sunrise, 2 solar noon, 3 sunset
+} SolarEvent;
+
+// sun position over one day, interpolated from three ephemeris evaluations
+typedef struct
+{
+    double tZ;        // time zone in UTC offset
+    double longitude; // East/west component of position
+    double sinLat;    // sine of the latitude
+    double cosLat;    // cosine of the latitude
+    double sinDec[3]; // sine of the declination at the beginning, middle, and end of the day
+    double cosDec[3]; // cosine of the declination at the beginning, middle, and end of the day
+    double eqTime[3]; // equation of time at the beginning, middle, and end of the day (minutes)
+    double maxRate;   // bound on the rate of change of altArg (per day)
+} DayEphem;
+
+// lazily produces every sunrise and sunset for a site over a range of dates
+typedef struct
+{
+    double tZ;                       // time zone in UTC offset
+    double longitude;                // East/west component of position
+    double latitude;                 // North/South component of position
+    double jDate;                    // next day to calculate
+    double endJDate;                 // first day not to calculate
+    double bufDay;                   // Julian date the pending events are relative to
+    SolarEvent events[MAXDAYEVENTS]; // pending events. Times are relative to bufDay and may fall outside [0, 1)
+    int numEvents;                   // number of pending events
+    int next;                        // index of the next pending event
+    double seed[2];                  // last sunrise and sunset (decimal day), used to start the next day's solve
+    int seeded;                      // whether seed holds the previous day's times
+} EventIter;
+
+// per-site terms of a grid job, stored as one array per field
+typedef struct
+{
+    int numSites;      // number of sites
+    double *longitude; // East/west component of position
+    double *latitude;  // North/South component of position
+    double *secLat;    // 1 / cos(latitude)
+    double *tanLat;    // tangent of the latitude
+} SiteArrays;
+
+// per-date terms of a grid job, shared by every site
+typedef struct
+{
+    double riseA[3];                   // sin(TWILIGHTANGLE) / cos(declination) at the beginning, middle, and end of the solar day
+    double tanDec[3];                  // tangent of the declination at the beginning, middle, and end of the solar day
+    double eqTime[3];                  // equation of time at the beginning, middle, and end of the solar day (minutes)
+    double twilightA[NUMTWILIGHTS][3]; // as riseA for the civil, nautical, and astronomical twilight angles
+    double secDec[3];                  // 1 / cos(declination) at the beginning, middle, and end of the solar day
+} DateEphem;
+
+// one site's statistics for one year. Times are UTC minutes after midnight, NOTIME if there were none
+typedef struct
+{
+    float latitude;         // North/South component of position
+    float longitude;        // East/west component of position
+    float meanDayLen;       // mean amount of sunlight per day (minutes)
+    int16_t year;           // calendar year
+    int16_t minDayLen;      // least sunlight in a day (minutes)
+    int16_t maxDayLen;      // most sunlight in a day (minutes)
+    int16_t earliestRise;   // earliest sunrise
+    int16_t latestSet;      // latest sunset
+    int16_t polarNightDays; // number of days with neither sunrise nor sunset, and no sunlight
+} SiteYearStats;
+
+// a raster of sites over a run of days, for grid and shard modes
+typedef struct
+{
+    double latMin;      // latitude of the first row (deg)
+    double lonMin;      // longitude of the first column (deg)
+    double step;        // raster spacing (deg)
+    int numLat;         // number of rows
+    int numLon;         // number of columns
+    double startJDate;  // Julian date of the first day
+    int numDays;        // number of days
+    int64_t epochUnits; // 0 to write float32 UTC minutes, or the units per day of int64 Unix timestamps
+} GridJob;
+
+// start of a columnar result file. The columns follow, each one's validity bitmap and values aligned to COLALIGN
+typedef struct
+{
+    char magic[8];       // COLMAGIC, written last so a reader never takes a partly written file as complete
+    uint64_t numRows;    // number of rows (site-days). Row = site * numDays + day
+    uint32_t numColumns; // number of columns
+    uint32_t numDays;    // number of days per site
+    uint32_t numLat;     // number of raster rows
+    uint32_t numLon;     // number of raster columns
+    double latMin;       // latitude of the first raster row (deg)
+    double lonMin;       // longitude of the first raster column (deg)
+    double step;         // raster spacing (deg)
+    double startJDate;   // Julian date of the first day
+} ColHeader;
+
+// description of one column in a columnar result file
+typedef struct
+{
+    char name[COLNAMELEN]; // column name
+    uint32_t type;         // COLFLOAT32 or COLINT8
+    uint32_t nullable;     // whether the column has a validity bitmap
+    uint64_t dataOffset;   // offset of the values from the start of the file
+    uint64_t validOffset;  // offset of the validity bitmap from the start of the file (bit set = valid, LSB first)
+} ColEntry;
+
+// an IANA time zone's UTC offsets, as a list of transitions
+typedef struct
+{
+    char name[TZNAMELEN];  // IANA zone name, like Europe/London
+    int numTrans;          // number of transitions
+    int64_t *transTimes;   // Unix time (seconds) of each transition, increasing
+    int32_t *transOffsets; // UTC offset (seconds) from each transition until the next
+    int32_t firstOffset;   // UTC offset (seconds) before the first transition
+} TzZone;
+
+// zones that have been loaded, so each tzdata file is only read once
+typedef struct
+{
+    int numZones;            // number of zones loaded
+    TzZone zones[MAXZONES]; // the zones
+} TzCache;
+
+// start of a horizon catalog file. numSites HorizonSite records follow
+typedef struct
+{
+    char magic[8];     // HORMAGIC
+    uint32_t numSites; // number of sites
+    uint32_t numBins;  // azimuth bins per site (HORIZONBINS)
+} HorizonHeader;
+
+// one site of a horizon catalog
+typedef struct
+{
+    float latitude;              // North/South component of position
+    float longitude;             // East/west component of position
+    float height;                // observer height above the surrounding terrain (m), for the dip of the horizon
+    int8_t elev[HORIZONBINS];    // horizon elevation in each azimuth bin (HORIZONSCALE deg), bin 0 centred on north
+} HorizonSite;
+
+// one site's quantity over a range of dates, evaluated only where the search needs it
+typedef struct
+{
+    double startJDate; // Julian date of the first day
+    double tZ;         // time zone in UTC offset
+    double longitude;  // East/west component of position
+    double latitude;   // North/South component of position
+    int quantity;      // INVRISE, INVSET, or INVDAYLEN
+    int below;         // 1 to match values below the threshold, 0 above
+    double threshold;  // value to compare with (decimal day)
+    double *values;    // each day's value: INVUNKNOWN until evaluated, NAN if the event doesn't happen
+    int numEvals;      // number of days evaluated
+} DateQuery;
+
+// a site of a SiteIndex
+typedef struct
+{
+    double latitude;  // North/South component of position
+    double longitude; // East/west component of position
+    int id;           // line of the site in its file, from 0
+} IndexedSite;
+
+// sites sorted into latitude bands, and by longitude within each band
+typedef struct
+{
+    int numSites;         // number of sites
+    int numBands;         // number of latitude bands
+    int *bandStart;       // index of each band's first site, numBands + 1 entries
+    IndexedSite *sites;   // the sites
+} SiteIndex;
+
+// one input to calcEvent or calcEventDay, and what it cost
+typedef struct
+{
+    int solver;       // FUZZEVENT for calcEvent, FUZZDAY for calcEventDay
+    double latitude;  // North/South component of position
+    double longitude; // East/west component of position
+    double jDate;     // Julian date of the day. The beginning of a day
+    int option;       // calcEvent's event, or calcEventDay's option
+    int iters;        // calcEventApprox calls
+    double nsPerCall; // wall time per call (ns)
+} FuzzCase;
+
+// the sun's position at one of the light classifier's shared ephemeris nodes
+typedef struct
+{
+    int64_t node;  // node number: Unix time / LIGHTNODESEC. NOEPOCH if the slot is empty
+    double sinDec; // sine of the declination
+    double cosDec; // cosine of the declination
+    double eqTime; // equation of time (minutes)
+} LightNode;
+
+// the ephemeris nodes recent rows have used, direct mapped by node number
+typedef struct
+{
+    LightNode nodes[LIGHTCACHE]; // the nodes
+    int numEvals;                // calcSunPos calls so far
+} LightCache;
+
+// a columnar batch of telemetry rows, classified in place
+typedef struct
+{
+    size_t numRows;           // number of rows
+    const double *latitude;   // North/South component of each row's position
+    const double *longitude;  // East/west component of each row's position
+    const int64_t *time;      // Unix timestamp of each row
+    int64_t epochUnits;       // units per day of the timestamps, as GridJob
+    float *elevation;         // output: elevation of the sun's centre (deg), without refraction. May be NULL
+    int8_t *light;            // output: LIGHTNIGHT, LIGHTASTRO, LIGHTNAUTICAL, LIGHTCIVIL, or LIGHTDAY
+} LightBatch;
+
+// the last and next events around one site's polar day or night
+typedef struct
+{
+    double latitude;      // North/South component of position
+    double longitude;     // East/west component of position
+    double tZ;            // time zone in UTC offset
+    int dayType;          // -1 polar day, -2 polar night, as calcDayType. 0 if the cache slot is empty
+    double lastEventDay;  // Julian date of the last sunrise (polar day) or sunset (polar night). NOEVENTDAY if none
+    double nextEventDay;  // Julian date of the next sunset (polar day) or sunrise (polar night). NOEVENTDAY if none
+    double lastEventTime; // time of the last event (decimal day). NAN if it isn't known
+    double nextEventTime; // time of the next event (decimal day). NAN if it isn't known
+} PolarPeriod;
+
+// state of serve mode, kept from request to request
+typedef struct
+{
+    PolarPeriod cache[SERVECACHE]; // exactly solved polar periods, direct mapped by site
+    double nsPerDay;               // running estimate of calcEventDay's time per day walked (ns)
+    long numRequests;              // requests answered
+    long numSources[4];            // answers by source: SERVEEXACT, SERVECACHED, SERVEPREDICTED, SERVETIMEDOUT
+    long numLate;                  // answers sent after their deadline
+    double maxLatency;             // slowest answer (s)
+} ServeState;
+
+// per-stage counts for profiled modes. Each stage is charged for what happens while it's the innermost stage entered
+typedef struct
+{
+    int fds[NUMCOUNTERS];                       // counter file descriptors, -1 where a counter isn't available
+    int slots[NUMCOUNTERS];                     // position of each counter in a group read, -1 if it isn't open
+    int numOpen;                                // number of counters open. 0 means only time is measured
+    int stack[PROFDEPTH];                       // stages entered and not yet left, innermost last
+    int depth;                                  // number of stages on the stack
+    uint64_t last[NUMCOUNTERS];                 // counter values at the last stage change
+    double lastNs;                              // monotonic time at the last stage change (ns)
+    double counts[NUMSTAGES + 1][NUMCOUNTERS];  // counts charged to each stage, then to the calibration stage
+    double ns[NUMSTAGES + 1];                   // time charged to each stage (ns)
+    long charges[NUMSTAGES + 1];                // stage changes charged to each stage
+    long entries[NUMSTAGES + 1];                // times each stage was entered
+    long libmCalls[NUMSTAGES + 1];              // libm calls made by the degree trig functions in each stage
+    double (*sampleFuncs[NUMSTAGES][PROFREPLAY])(double); // every PROFSAMPLE-th libm call of each stage, latest last
+    double sampleArgs[NUMSTAGES][PROFREPLAY];   // the sampled calls' arguments
+    double changeCounts[NUMCOUNTERS];           // counts one stage change adds to the stage it charges
+    double changeNs;                            // time one stage change adds to the stage it charges (ns)
+    double libmNs[NUMSTAGES];                   // time of one of each stage's libm calls, from replayLibm (ns)
+    double libmCycles[NUMSTAGES];               // cycles of one of each stage's libm calls, from replayLibm
+} Profile;
+
+// where a placed grid job's worker threads run. Workers are spread over the NUMA nodes round robin
+typedef struct
+{
+    int numThreads;        // number of workers
+    int numCpus;           // number of CPUs the process may run on
+    int pin;               // whether to pin each worker to its CPU
+    int hugePages;         // whether to ask for transparent huge pages for each worker's arrays
+    int cpus[MAXTHREADS];  // CPU of each worker
+    int nodes[MAXTHREADS]; // NUMA node of each worker's CPU
+} GridPlacement;
+
+// a moving observer's track, fed one sample at a time, and the walk through its latest segment
+typedef struct
+{
+    LightCache cache;    // ephemeris nodes shared by nearby samples
+    int64_t epochUnits;  // units per day of the timestamps, as GridJob
+    double sinRise;      // sine of TWILIGHTANGLE
+    double nodesPerUnit; // ephemeris nodes per timestamp unit
+    double stepUnits;    // longest step of the walk (timestamp units)
+    double tolUnits;     // how closely an event is located (timestamp units)
+    long numSamples;     // samples added so far
+    long numEvals;       // altitude evaluations so far
+    double latitude[2];  // North/South component of position at the start and end of the segment
+    double longitude[2]; // East/west component of position at the start and end of the segment
+    double time[2];      // timestamps of the start and end of the segment
+    double walkTime;     // how far the walk through the segment has got
+    double walkArg;      // trackAltArg at walkTime
+} TrackState;
+
+// a sunrise or sunset that a moving observer passes through
+typedef struct
+{
+    int type;         // event code as used by calcEvent: 1 sunrise, 3 sunset
+    double time;      // timestamp, in the track's units
+    double latitude;  // North/South component of the observer's position
+    double longitude; // East/west component of the observer's position
+} TrackEvent;
+
+// lanes of the time-major calcEvent kernel, each iterating one day's fixed point, and how busy they were kept
+typedef struct
+{
+    double jDate[SPANLANES];  // Julian date of each lane's day
+    double ans[SPANLANES];    // each lane's current answer (decimal day)
+    double iters[SPANLANES];  // calcEventApprox steps in each lane's current pass
+    double active[SPANLANES]; // 1 while a lane's fixed point is still moving, 0 once it has stopped
+    double close[SPANLANES];  // nonzero if a lane came close to a decision calcEvent could have made differently
+    int task[SPANLANES];      // day * 2 + pass of each lane's work within the block, -1 if the lane is idle
+    long numSweeps;           // vector sweeps over the lanes so far
+    long numSteps;            // lane steps that did useful work so far
+    long numRedone;           // days redone by calcEvent so far
+} SpanLanes;
+
+// a tile's place in the XYZ pyramid
+typedef struct
+{
+    int layer; // TILERISE, TILESET, or TILELENGTH
+    int date;  // UTC date as YYYYMMDD
+    int zoom;  // zoom level, 0 for the whole world in one tile
+    int x;     // column of the tile, from 0 at 180°W
+    int y;     // row of the tile, from 0 at the north edge
+} TileKey;
+
+// a tile held in tile mode's memory cache
+typedef struct
+{
+    TileKey key;   // which tile it is
+    float *pixels; // its TILEPIXELS values
+    int newer;     // next more recently used entry, -1 if none
+    int older;     // next less recently used entry, -1 if none
+    int chain;     // next entry in the same hash bucket, -1 if none
+} TileEntry;
+
+// state of tile mode, kept from request to request
+typedef struct
+{
+    TileEntry *entries;        // memory cache entries
+    float *pixels;             // storage for every entry's pixels
+    int *buckets;              // first entry of each hash bucket, -1 if none
+    int numBuckets;            // number of hash buckets
+    int capacity;              // number of tiles the memory cache holds
+    int numUsed;               // entries in use
+    int newest;                // most recently used entry, -1 if none
+    int oldest;                // least recently used entry, -1 if none
+    const char *cacheDir;      // directory of the disk cache
+    float scratch[TILEPIXELS]; // a tile being read, derived, or computed
+    float child[TILEPIXELS];   // a child tile read from disk while deriving
+    int popDates[TILEDATES];   // dates being counted for popularity, direct mapped by date
+    int popCounts[TILEDATES];  // requests for each of those dates
+    TileKey queue[TILEQUEUE];  // tiles waiting to be prefetched, as a ring
+    int queueHead;             // next tile to prefetch
+    int queueLen;              // tiles waiting
+    long numRequests;          // tile requests answered
+    long numSources[4];        // tiles answered by source: TILEMEMORY, TILEDISK, TILEDERIVED, TILECOMPUTED
+    long numPrefetched;        // tiles prefetched
+    long numErrors;            // requests that weren't for a tile or the counters
+    double computeSec;         // time spent calculating tiles (s)
+} TileState;
+
+// where a columnar result file's columns are while it's being written
+typedef struct
+{
+    unsigned char *base;              // start of the mapped file
+    size_t size;                      // size of the file
+    void *data[NUMCOLUMNS];           // each column's values
+    unsigned char *valid[NUMCOLUMNS]; // each column's validity bitmap, NULL if it has none
+} ColBuffers;
+
+// function declarations
+
+// math functions
+
+double cosd(double);
+double sind(double);
+double tand(double);
+double acosd(double);
+double asind(double);
+int numDecimals(double);
+
+// input functions
+
+void getCoords(double *, double *);
+double getTimeZone(void);
+void getDate(int *, int *, int *);
+int getMonth(void);
+int goAgain(void);
+
+// time functions
+
+int isLeapYear(int);
+int monthLen(int, int);
+int getDay(int, int);
+int cumDaysInYr(int, int, int);
+int cumLpYrs(int);
+int cumDays(int, int, int);
+double calcJDate(int, int, int, double);
+int64_t calcEpoch(double, double, int64_t);
+void calcDate(double, double, int *, int *, int *);
+void advanceDate(int *, int *, int *);
+double roundToMin(double);
+int hours(double);
+int minutes(double);
+int hours12Hr(double);
+char hrType12Hr(double);
+
+// sunrise/sunset functions
+
+double calcEventApprox(double, double, double, double, double, int);
+double calcEvent(double, double, double, double, int);
+double calcEventIters(double, double, double, double, int, int *);
+double calcEventDay(double, double, double, double, int);
+double calcEventDayIters(double, double, double, double, int, int *, const double *);
+void calcSunPos(double, double *, double *);
+int calcDayType(double, double, double, double);
+
+// event enumeration functions
+
+void initDayEphem(DayEphem *, double, double, double, double);
+double interpDay(const double *, double);
+double interpDayMax(const double *);
+double altArg(const DayEphem *, double);
+double findCrossing(const DayEphem *, double, double, double, double);
+double transitTime(const DayEphem *);
+int calcDayEvents(double, double, double, double, SolarEvent *, int *);
+int enumDayType(double, double, double, double);
+
+// event iterator functions
+
+double calcEventSeeded(double, double, double, double, int, double);
+double polarPeriodEnd(double, double, double, double);
+double polarPeriodEdge(double, double, double, double, int, int (*)(double, double, double, double));
+void initEventIter(EventIter *, double, double, double, double, double);
+void fillIterDay(EventIter *);
+int nextEvent(EventIter *, double *, SolarEvent *);
+
+// grid functions
+
+int allocSiteArrays(SiteArrays *, int);
+void freeSiteArrays(SiteArrays *);
+void prepSiteArrays(SiteArrays *);
+void calcDateEphem(DateEphem *, double);
+double gridEvent(const DateEphem *, double, double, int, int *);
+double gridEventAt(const DateEphem *, const double *, double, double, int, int *);
+void storeGridEvent(const GridJob *, void *, size_t, int, double);
+void gridTile(const GridJob *, const SiteArrays *, const DateEphem *, int, int, int, int, void *);
+void gridNaiveRow(const GridJob *, const SiteArrays *, int, int, void *);
+int gridDayStatus(const DateEphem *, double, double);
+void siteYearStats(const SiteArrays *, const DateEphem *, int, int, int, SiteYearStats *);
+
+// time zone functions
+
+int64_t readBigEndian(const unsigned char *, int);
+const char *parseTzName(const char *);
+const char *parseTzOffset(const char *, int32_t *);
+const char *parseTzDate(const char *, int *, int *, int *, int *, int32_t *);
+int64_t tzRuleTime(int, int, int, int, int, int32_t, int32_t);
+int addTzTrans(TzZone *, int *, int64_t, int32_t);
+int expandTzRule(TzZone *, int *, const char *);
+int64_t readTzHeader(const unsigned char *, int, int64_t *);
+int loadTzZone(TzZone *, const char *);
+const TzZone *findTzZone(TzCache *, const char *);
+void freeTzCache(TzCache *);
+int32_t tzOffsetAt(const TzZone *, int64_t);
+double zoneDayOffset(const TzZone *, double);
+double zoneLocalTime(const TzZone *, double, double, double);
+
+// horizon functions
+
+double horizonAt(const HorizonSite *, double);
+double sunAzimuth(const DateEphem *, double, double, double);
+double horizonEvent(const DateEphem *, const HorizonSite *, double, double, int, int, double *);
+int buildHorizonCatalog(const char *, const char *);
+int runHorizonCatalog(const char *, double, int, const char *);
+
+// inverse query functions
+
+double dateQuantity(DateQuery *, int);
+int quantityMatches(double, int, double);
+int dateSlope(DateQuery *, int);
+void fillMonotone(DateQuery *, int, int, unsigned char *);
+void fillDateMatches(DateQuery *, int, unsigned char *);
+double siteQuantity(const DateEphem *, double, int, int *);
+int compareIndexedSites(const void *, const void *);
+int compareInts(const void *, const void *);
+int loadSiteIndex(SiteIndex *, const char *);
+void freeSiteIndex(SiteIndex *);
+int firstLonAbove(const SiteIndex *, int, int, double);
+int querySiteIndex(const SiteIndex *, const DateEphem *, int, int, double, double, int *, int *);
+
+// accuracy functions
+
+void calcSunPosRef(long double, long double *, long double *);
+long double calcEventRef(long double, long double, long double, int);
+void engineEvents(int, const SiteArrays *, const DateEphem *, double, int, const double *, double *);
+int compareFloats(const void *, const void *);
+double elapsedSec(const struct timespec *);
+
+// sunrise table functions
+
+uint32_t zigZag(int32_t);
+int32_t unZigZag(uint32_t);
+void putBits(uint8_t *, size_t *, uint32_t, int);
+uint32_t getBits(const uint8_t *, size_t, int);
+int tableMinute(double);
+size_t encodeSunTable(const int16_t *, const int16_t *, int, uint8_t *);
+int decodeSunTable(const uint8_t *, int, int);
+void writeSunDecoder(FILE *);
+int writeSunTables(const char *, int, int, const char *);
+
+// solver fuzzing functions
+
+double fuzzRandom(double, double);
+int fuzzCost(FuzzCase *);
+void randomCase(FuzzCase *, int);
+void mutateCase(FuzzCase *, const FuzzCase *, double);
+double timeCase(const FuzzCase *);
+void keepWorst(FuzzCase *, int *, const FuzzCase *);
+int writeCorpus(const char *, const FuzzCase *, int);
+int readCorpus(const char *, FuzzCase *, int);
+
+// daylight classifier functions
+
+void initLightCache(LightCache *);
+const LightNode *lightNode(LightCache *, int64_t);
+static inline double polyCosd(double);
+void classifyLight(const LightBatch *, LightCache *);
+double sunElevation(double, double, int64_t, int64_t);
+
+// resident service functions
+
+double monoSec(void);
+PolarPeriod *polarCacheSlot(ServeState *, double, double, double);
+void estimatePolarPeriod(PolarPeriod *, double, int);
+int solvePolarPeriod(ServeState *, double, double, double, double, int, double, PolarPeriod *);
+void printServeEvent(double, double, double);
+void printServeStats(FILE *, const ServeState *);
+void serveRequest(ServeState *, double, double, double, double, double, double);
+
+// placement functions
+
+int readCpuList(const char *, unsigned char *, int);
+void planPlacement(GridPlacement *, int, int, int);
+int pinThread(int);
+void *allocPlaced(size_t, int);
+int runGridBand(const GridJob *, int, int, int, off_t, int, int);
+int runGridPlaced(const GridJob *, int, int, int, int, const GridPlacement *);
+
+// profiling functions
+
+int openProfile(Profile *);
+void closeProfile(Profile *);
+void readProfCounters(const Profile *, uint64_t *);
+void changeStage(Profile *, int);
+static inline void profEnter(int);
+static inline void profLeave(void);
+double profLibm(double (*)(double), double);
+void resetProfile(Profile *);
+int compareDoubles(const void *, const void *);
+double medianOf(double *, int);
+void calibrateProfile(Profile *);
+void replayLibm(Profile *);
+void printProfile(FILE *, const Profile *);
+
+// track functions
+void initTrack(TrackState *, int64_t);
+void trackPosition(const TrackState *, double, double *, double *);
+double trackAltArg(TrackState *, double, double, double);
+int addTrackSample(TrackState *, double, double, double);
+int nextTrackEvent(TrackState *, TrackEvent *);
+
+// time-major event functions
+static inline double nonNegMask(double);
+static inline double polySqrt(double);
+static inline double polyAcosd(double);
+void initSpanLanes(SpanLanes *);
+void calcEventSpan(SpanLanes *, double, int, double, double, double, int, double *);
+
+// tile service functions
+const char *tileLayerName(int);
+double tileLatitude(int, long);
+double tileLongitude(int, long);
+void computeTile(const TileKey *, float *);
+int initTileState(TileState *, int, const char *);
+int tileBucket(const TileState *, const TileKey *);
+int sameTile(const TileKey *, const TileKey *);
+void unlinkTile(TileState *, int);
+void linkNewestTile(TileState *, int);
+float *findCachedTile(TileState *, const TileKey *);
+float *cacheTile(TileState *, const TileKey *, const float *);
+void tilePath(const TileState *, const TileKey *, char *, size_t);
+int readDiskTile(const TileState *, const TileKey *, float *);
+void writeDiskTile(const TileState *, const TileKey *, const float *);
+int deriveTile(TileState *, const TileKey *, float *);
+const float *getTile(TileState *, const TileKey *, int *);
+void countTileDate(TileState *, int);
+void prefetchTile(TileState *);
+int parseTilePath(const char *, TileKey *);
+void sendAll(int, const void *, size_t);
+void printTileStats(FILE *, const TileState *);
+void serveTileConnection(TileState *, int);
+void stopTiles(int);
+
+// terminator functions
+static inline double polyAtan2d(double, double, double);
+void subsolarPoint(double, double *, double *);
+void calcTerminator(double, double, int, double *, double *);
+int cutTerminator(const double *, const double *, int, double *, double *, int *);
+void printTerminatorFeature(const char *, double, double, const double *, const double *, const int *, int, int, double *, double *);
+
+// columnar output functions
+
+int openColumns(ColBuffers *, const char *, const GridJob *, int, int);
+void closeColumns(ColBuffers *);
+void setColTime(ColBuffers *, int, size_t, double);
+void gridTileColumns(const GridJob *, const SiteArrays *, const DateEphem *, int, int, int, int, size_t, ColBuffers *);
+int runGridColumns(const GridJob *, int, int, const char *);
+
+// output functions
+
+void printCoords(double, double);
+void printDate(double);
+void dispTime(double);
+void nominalOutput(double, double, double, double);
+void extremeLatOutput(double, double, double, double, int);
+void printAll(double, double, double, double);
+void enumOutput(double, double, double, double);
+void printClock(double);
+
+// batch functions
+
+int runMode(int, char *[]);
+int batchMode(int, char *[]);
+int rangeMode(int, char *[]);
+int gridMode(int, char *[]);
+int statsMode(int, char *[]);
+int parseGridJob(GridJob *, char *[]);
+int parseEpochUnits(GridJob *, const char *);
+int runGrid(const GridJob *, int, int, FILE *, int);
+double rowCost(const GridJob *, const DateEphem *, int, int);
+void planShards(const GridJob *, int, int *);
+int shardMode(int, char *[]);
+void batchOutput(double, double, double, double, const TzZone *);
+int colReadMode(int, char *[]);
+int horizonMode(int, char *[]);
+int inverseMode(int, char *[]);
+int accuracyMode(int, char *[]);
+int tableMode(int, char *[]);
+int fuzzMode(int, char *[]);
+int lightMode(int, char *[]);
+int serveMode(int, char *[]);
+int scaleMode(int, char *[]);
+int profileMode(int, char *[]);
+int trackMode(int, char *[]);
+int spanMode(int, char *[]);
+int tileMode(int, char *[]);
+int terminatorMode(int, char *[]);
+
+// profile being recorded by a profiled mode, NULL otherwise. Only ever set from a single thread
+Profile *activeProfile = NULL;
+
+// set by stopTiles when tile mode is asked to stop
+volatile sig_atomic_t tilesStopping = 0;
+
+#ifndef SOLARLIB
+int main(int argc, char *argv[])
+{
+    double latitude;  // latitude (deg, - is south, + is north)
+    double longitude; // longitude (deg, - is west, + is east)
+    double timeZone;  // time zone in UTC offset.
+    int year;         // years in standard calendar
+    int month;        // month number (1-indexed)
+    int day;          // day number of the month (1-indexed)
+    double jDate;     // Julian date
+    int iterate;      // whether to keep iterating
+
+    if (argc > 1)
+    {
+        return runMode(argc, argv);
+    }
+
+    printf("\n\n\tSolar Calculations");
+    do
+    {
+        printf("\n\n");
+
+        // get position
+        getCoords(&longitude, &latitude);
+        timeZone = getTimeZone();
+
+        // get time
+        getDate(&year, &month, &day);
+
+        jDate = calcJDate(day, month, year, timeZone);
+
+        printAll(jDate, timeZone, longitude, latitude);
+
+        // prompt to go again
+        iterate = goAgain();
+    } while (iterate == 1);
+
+    return 0;
+}
+#endif
+
+// MATH FUNCTIONS
+
+/**
+ * Cosine function in degrees
+ *
+ *  Inputs:
+ * angleDeg: the angle, in degrees. Domain of all real numbers
+ *
+ *  Output:
+ * The value of the cosine, between -1 and +1 inclusive of both
+ **/
+double cosd(double angleDeg)
+{
+    return PROFLIBM(cos, angleDeg * DEG2RAD);
+}
+
+/**
+ * Sine function in degrees
+ *
+ *  Inputs:
+ * angleDeg: the angle, in degrees. Domain of all real numbers
+ *
+ *  Output:
+ * The value of the sine, between -1 and +1 inclusive of both
+ **/
+double sind(double angleDeg)
+{
+    return PROFLIBM(sin, angleDeg * DEG2RAD);
+}
+
+/**
+ * Tangent function in degrees
+ *
+ *  Inputs:
+ * angleDeg: the angle, in degrees. Domain of all real numbers excluding the vertical angles
+ *
+ *  Output:
+ * The value of the tangent, domain of all real numbers
+ **/
+double tand(double angleDeg)
+{
+    return PROFLIBM(tan, angleDeg * DEG2RAD);
+}
+
+/**
+ * Arccosine written to work in degrees
+ *
+ *  Inputs:
+ * ratio: the cosine of an unknown angle (adjacent / hypotenuse). Must be between -1 and 1.
+ *
+ *  Output:
+ * The angle in degrees. The output will be between 0 and 180 degrees.
+ **/
+double acosd(double ratio)
+{
+    return PROFLIBM(acos, ratio) * RAD2DEG;
+}
+
+/**
+ * Arcsine written to work in degrees
+ *
+ *  Inputs:
+ * ratio: the sine of an unknown angle (opposite / hypotenuse). Must be between -1 and 1.
+ *
+ *  Output:
+ * The angle in degrees. The output will be between -90 and 90 degrees.
+ **/
+double asind(double ratio)
+{
+    return PROFLIBM(asin, ratio) * RAD2DEG;
+}
+
+/**
+ * Calculates the number of nonzero decimal places that a number has
+ *
+ *  Inputs:
+ * number: the number to check
+ *
+ *  Output:
+ * The angle, in degrees. Range: (-180, 180]
+ **/
+int numDecimals(double number)
+{
+    int decimals = 0; // the number of decimals
+
+    while (fmod(number, 1) != 0 && decimals < MAXDECIMALS)
+    {
+        number *= 10;
+        number = fmod(number, 1);
+        decimals++;
+    }
+
+    return decimals;
+}
+
+// USER INPUT FUNCTIONS
+
+/**
+ * Prompts the user whether to iterate the program again (validates input as upper or lower case Y/N
+ * )
+ *
+ *  Inputs:
+ * None
+ *
+ *  Output:
+ * Binary whether to loop again
+ **/
+int goAgain(void)
+{
+    char userInput;     // what the user inputted
+    int scanInputs = 0; // number of scanf inputs
+
+    printf("\n\n\n");
+    do
+    {
+        fflush(stdin);
+        printf("Calculate again [Y/N]? ");
+        scanInputs = scanf("%c", &userInput);
+        userInput = toupper(userInput);
+    } while (scanInputs != 1 && !(userInput == 'Y' || userInput == 'N'));
+
+    return userInput == 'Y' ? 1 : 0;
+}
+
+/**
+ * Prompts the user to enter coordinates, and validates the input. Longitude must have magnitude no greater than 180. Latitude must be between -90 and 90.
+ *
+ *  Inputs:
+ * longitude pointer: variable in which to store user-entered longitude. Positive values are east, negative are west.
+ * latitude pointer: variable in which to store latitude. Positive values are north, negative are south.
+ *
+ *  Output:
+ * None
+ **/
+void getCoords(double *longitude, double *latitude)
+{
+    int scanInputs;        // number of scanf inputs
+    char inputStr[BUFSIZ]; // input string
+    int dummy;             // dummy variable to check correct number of inputs
+
+    do
+    {
+        fflush(stdin);
+        printf("Enter coordinates (latitutde longitude): ");
+        fgets(inputStr, BUFSIZ, stdin);
+        scanInputs = sscanf(inputStr, "%lf %lf %d", latitude, longitude, &dummy);
+
+        // errors
+        if (scanInputs != 2)
+        {
+            printf("\tInvalid input! Enter exactly two coordinates, separated by a space.");
+            printf("\n\tExample input:\n\tEnter coordinates (latitutde longitude): 51.51 -0.13\n");
+        }
+        else if (fabs(*latitude) >= LATRANGE || fabs(*longitude) >= LONGRANGE)
+        {
+            printf("\tInvalid input! Latitude goes from -90 to 90, longitude from -180 to 180.");
+            printf("\n\tExample input:\n\tEnter coordinates (latitutde longitude): 47.6 -122.3\n");
+        }
+    } while (scanInputs != 2 || fabs(*latitude) >= LATRANGE || fabs(*longitude) >= LONGRANGE);
+}
+
+/**
+ * Prompts the user to enter a time zone and validates it. Must be between UTC-13 and UTC+13, and must be an integer time zone.
+ *
+ *  Inputs:
+ * None
+ *
+ *  Output:
+ * Time zone UTC offset
+ **/
+double getTimeZone(void)
+{
+    double timeZoneOffset; // time zone UTC offset
+    int scanInputs;        // number of scanf inputs
+    char inputStr[BUFSIZ]; // input string
+    int dummy;             // dummy variable to check correct number of inputs
+
+    do
+    {
+        fflush(stdin);
+        printf("Time zone: UTC");
+        fgets(inputStr, BUFSIZ, stdin);
+        scanInputs = sscanf(inputStr, "%lf %d", &timeZoneOffset, &dummy);
+        if (scanInputs != 1)
+        {
+            printf("\tInvalid input! Enter exactly one input");
+            printf("\n\tExample input:\n\tUTC+0\n");
+        }
+        else if (fabs(timeZoneOffset) > 13)
+        {
+            printf("\tInvalid input! Enter a time zone in UTC (GMT) offset. Must be between -13 and +13.");
+            printf("\n\tExample input:\n\tUTC-8\n");
+        }
+    } while (scanInputs != 1 || fabs(timeZoneOffset) > 13);
+
+    return timeZoneOffset;
+}
+
+/**
+ * Prompts the user to enter a date as YYYY DD MM
+ *
+ *  Inputs:
+ * int pointer year: the variable to store the year in
+ * int pointer month: the variable to store the month in
+ * int pointer day: the variable to store the day in
+ *
+ *  Output:
+ * None
+ **/
+void getDate(int *year, int *month, int *day)
+{
+    int scanInputs;        // number of scan inputs
+    char inputStr[BUFSIZ]; // input string
+    int dummy;             // dummy variable to check correct number of inputs
+
+    do
+    {
+        fflush(stdin);
+        printf("Enter a date as YYYY MM DD: ");
+        fgets(inputStr, BUFSIZ, stdin);
+        scanInputs = sscanf(inputStr, "%d %d %d %d", year, month, day, &dummy);
+        if (scanInputs != 3)
+        {
+            printf("\tInvalid input! Enter exactly three inputs separated by spaces.");
+            printf("\n\tExample input:\n\tEnter a date as YYYY MM DD: 2035 6 21\n");
+        }
+        else if (*year <= 0)
+        {
+            printf("\tInvalid input! The year must be positive.");
+            printf("\n\tExample input:\n\tEnter a date as YYYY MM DD: 1969 7 16\n");
+        }
+        else if (*month < 1 || *month > 12)
+        {
+            printf("\tInvalid input! The month must be a month between 1 and 12.");
+            printf("\n\tExample input:\n\tEnter a date as YYYY MM DD: 2021 2 18\n");
+        }
+        else if (*day < 1 || *day > monthLen(*month, *year))
+        {
+            printf("\tInvalid input! The day must be a valid day in the month you chose.");
+            printf("\n\tExample input:\n\tEnter a date as YYYY MM DD: %04d %02d %02d\n", *year, *month, monthLen(*month, *year));
+        }
+    } while (scanInputs != 3 || *year <= 0 || *month < 1 || *month > 12 || *day < 1 || *day > monthLen(*month, *year));
+}
+
+// TIME MANIPULATION FUNCTIONS
+
+/**
+ * Determines whether a given year is a leap year
+ *
+ *  Inputs:
+ * year: the year
+ *
+ *  Output:
+ * 0 if the given year isn't a leapyear, 1 if it is.
+ **/
+int isLeapYear(int year)
+{
+    return (!(year % 4) && (year % 100)) || !(year % 400);
+}
+
+/**
+ * Determines the number of days in a given month
+ *
+ *  Inputs:
+ * month: the number of the month in the year
+ * year: the year (to know whether february has an extra day)
+ *
+ *  Output:
+ * The number of days in the month
+ **/
+int monthLen(int month, int year)
+{
+    int numDays; // number of days in the month
+
+    if (month == FEB)
+    {
+        numDays = DAYSINMONTH + isLeapYear(year);
+    }
+    else if (month == APR || month == JUN || month == SEP || month == NOV)
+    {
+        numDays = DAYSMEDMONTH;
+    }
+    else
+    {
+        numDays = DAYSLONGMONTH;
+    }
+
+    return numDays;
+}
+
+/**
+ * Counts the number of days that have occurred in the year at a given date (including the 1st day).
+ *
+ *  Inputs:
+ * day: the day number in the month
+ * month: the month number of the year
+ * year: the year number
+ *
+ *  Output:
+ * total number of days
+ **/
+int cumDaysInYr(int day, int month, int year)
+{
+    int days = 0; // total number of days in the year
+
+    for (int i = 1; i < month; i += 1)
+    {
+        days += monthLen(i, year);
+    }
+
+    for (int i = 0; i < day; i++)
+    {
+        days += 1;
+    }
+
+    return days;
+}
+
+/**
+ * Counts the number of leap years that have occurred since 2000 (works backward as well). Does not count the given year
+ *
+ *  Inputs:
+ * year: the year to check up to
+ *
+ *  Output:
+ * Number of years that have been leap years
+ **/
+int cumLpYrs(int year)
+{
+    int yrs = 0; // number of leap years since 2000 (works backward too)
+
+    if (year > 2000)
+    {
+        for (int i = 2000; i < year; i++)
+        {
+            yrs += isLeapYear(i);
+        }
+    }
+    else
+    {
+        for (int i = 2000; i > year; i--)
+        {
+            yrs -= isLeapYear(i);
+        }
+    }
+
+    return yrs;
+}
+
+/**
+ * Counts the total number of days between Jan 1 2000 and a given date (what you have to add to jan 1 to get the current date)
+ *
+ *  Inputs:
+ * day: the day number in the month
+ * month: the month number of the year
+ * year: the year number
+ *
+ *  Output:
+ * Total number of days
+ **/
+int cumDays(int day, int month, int year)
+{
+    int days = 0; // number of days since jan 1 2000 (should work backward)
+
+    days += cumDaysInYr(day, month, year);
+    days += DAYSINYEAR * (year - 2000);
+    days += cumLpYrs(year);
+    days -= (year >= 2000);
+
+    return days;
+}
+
+/**
+ * Calculates the Julain date for a given Gregorian date
+ *
+ *  Inputs:
+ * day: the day number in the month
+ * month: the month number of the year
+ * year: the year number
+ * timeZone: the time zone UTC offset
+ *
+ *  Output:
+ * Julian date of the beginning of the day
+ **/
+double calcJDate(int day, int month, int year, double timeZone)
+{
+    double jDate; // Julian date for the given date
+
+    jDate = JDATE2000;
+    jDate += cumDays(day, month, year);
+
+    return jDate;
+}
+
+/**
+ * Converts a time on a given date to a Unix timestamp, without rounding to the minute
+ *
+ *  Inputs:
+ * jDate: Julian date of the day. Must be the beginning of a day
+ * utcTime: decimal day in UTC. May be outside [0, 1) for times on the days before or after
+ * unitsPerDay: SECINDAY for seconds, SECINDAY * MSINSEC for milliseconds
+ *
+ *  Output:
+ * Whole units since 1970-01-01 00:00 UTC
+ **/
+int64_t calcEpoch(double jDate, double utcTime, int64_t unitsPerDay)
+{
+    return (int64_t)llround(jDate - JDATEUNIX) * unitsPerDay + llround(utcTime * unitsPerDay);
+}
+
+/**
+ * Reverse of the calcJDate function. Calculates the day/month/year for a given Julian date
+ *
+ *  Inputs:
+ * jDate: the Julain date for the beginning of the day
+ * tZ: the time zone in UTC offset
+ * pointer day: variable in which to store the day number
+ * pointer month: variable in which to store the month number
+ * pointer year: variable in which to store the year number
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void calcDate(double jDate, double tZ, int *day, int *month, int *year)
+{
+    double currentJD; // current julian date (will default to the jDate of jan1 2000)
+
+    *day = 1;
+    *month = 1;
+    *year = 2000;
+    currentJD = calcJDate(*day, *month, *year, tZ);
+
+    while (currentJD < jDate)
+    {
+        advanceDate(day, month, year);
+        currentJD += 1;
+    }
+
+    while (currentJD > jDate)
+    {
+        if (*day > 1)
+        {
+            *day -= 1;
+        }
+        else if (*month > 1)
+        {
+            *month -= 1;
+            *day = monthLen(*month, *year);
+        }
+        else
+        {
+            *year -= 1;
+            *month = NUMMONTHS;
+            *day = monthLen(*month, *year);
+        }
+        currentJD -= 1;
+    }
+}
+
+/**
+ * Moves a date forward by one day
+ *
+ *  Inputs:
+ * pointer day: the day number, updated in place
+ * pointer month: the month number, updated in place
+ * pointer year: the year number, updated in place
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void advanceDate(int *day, int *month, int *year)
+{
+    if (*day < monthLen(*month, *year))
+    {
+        *day += 1;
+    }
+    else if (*month < NUMMONTHS)
+    {
+        *month += 1;
+        *day = 1;
+    }
+    else
+    {
+        *year += 1;
+        *month = 1;
+        *day = 1;
+    }
+}
+
+/**
+ * Rounds a given time to the nearest minute
+ *
+ *  Inputs:
+ * timeDay: Decimal day. Range is [0:1)
+ *
+ *  Output:
+ * Decimal day rounded to the nearest minute
+ **/
+double roundToMin(double timeDay)
+{
+    return round(timeDay * MININHR * HRSINDAY) / (MININHR * HRSINDAY);
+}
+
+/**
+ * Finds the hour of a given time of day (in 24hr time)
+ *
+ *  Inputs:
+ * timeDay: decimal day. Range is [0, 1)
+ *
+ *  Output:
+ * Number of hours. Will be between 0 and 23 inclusive of both
+ **/
+int hours(double timeDay)
+{
+    return (int)(roundToMin(timeDay) * HRSINDAY) % HRSINDAY;
+}
+
+/**
+ * Finds the hour of a given time of day, in 12hr time
+ *
+ *  Inputs:
+ * timeDay: decimal day. Range is [0, 1)
+ *
+ *  Output:
+ * Hour number on the clock, between 1 and 12 inclusive of both.
+ **/
+int hours12Hr(double timeDay)
+{
+    int hr; // hour on the clock. 1-12 inclusive
+
+    hr = hours(timeDay) % HRS12HR;
+    if (hr == 0)
+    {
+        hr = 12;
+    }
+
+    return hr;
+}
+
+/**
+ * Determines if a given time is AM or PM
+ *
+ *  Inputs:
+ * timeDay: decimal day. Range is [0, 1)
+ *
+ *  Output:
+ * 'A' or 'P', depending on if it's AM or PM
+ **/
+char hrType12Hr(double timeDay)
+{
+    return (hours(timeDay) >= HRS12HR) ? 'P' : 'A';
+}
+
+/**
+ * Finds the value of the minute hand at a given time
+ *
+ *  Inputs:
+ * timeDay: decimal day. Range is [0, 1)
+ *
+ *  Output:
+ * Number of minutes. Will be between 0 and 59 inclusive of both
+ **/
+int minutes(double timeDay)
+{
+    int mins; // minute on the clock. 0-59 inclusive
+
+    mins = round(MININHR * HRSINDAY * roundToMin(timeDay));
+    mins -= MININHR * hours(roundToMin(timeDay));
+
+    return mins;
+}
+
+// SOLAR CALCULATION FUNCTIONS
+
+/**
+ * Calculates the sun's declination and the equation of time at a given instant
+ *
+ *  Inputs:
+ * jDate: Julian date (fractional days allowed)
+ * pointer sunDeclin: variable in which to store the sun's declination (deg)
+ * pointer eqOfTime: variable in which to store the equation of time (minutes)
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void calcSunPos(double jDate, double *sunDeclin, double *eqOfTime)
+{
+    double geomMeanLongSun;  // Geometric mean longitude (L0) of the sun
+    double geomMeanAnomSun;  // Geometric mean anomaly of the sun
+    double eccentEarthOrbit; // Earth orbit eccentricity
+    double sunEqCtr;         // Sun's equation of center (error of position with respect to a circular orbit of same period)
+    double sunTruLong;       // Ecliptic Longitude of earth if the sun had 0 inclination
+    double sunAppLong;       // Apparent Longitude of the sun
+    double meanObliqEclip;   // Oblique ecliptic: Mean inclination of Earth’s equator relative to the Sun/planets apparent plane
+    double obliqCorr;        // Oblique ecliptic corrected
+    double varY;             // ADD COMMENT
+    double jCent;            // Julian century
+
+    profEnter(PROFEPHEM);
+    jCent = ((jDate - JDATE2000 - 1) / JULCENTURY);
+    geomMeanLongSun = fmod(280.46646 + jCent * (36000.76983 + jCent * 0.0003032), 360);
+    geomMeanAnomSun = 357.52911 + jCent * (35999.05029 - 0.0001537 * jCent);
+    eccentEarthOrbit = 0.016708634 - jCent * (0.000042037 + 0.0000001267 * jCent);
+    sunEqCtr = sind(geomMeanAnomSun) * (1.914602 - jCent * (0.004817 + 0.000014 * jCent)) + sind(2 * geomMeanAnomSun) * (0.019993 - 0.000101 * jCent) + sind(3 * geomMeanAnomSun) * 0.000289;
+    sunTruLong = geomMeanLongSun + sunEqCtr;
+    sunAppLong = sunTruLong - 0.00569 - 0.00478 * sind(125.04 - 1934.136 * jCent);
+    meanObliqEclip = (HRSINDAY - 1) + (26 + ((21.448 - jCent * (46.815 + jCent * (0.00059 - jCent * 0.001813)))) / MININHR) / MININHR;
+    obliqCorr = meanObliqEclip + 0.00256 * cosd(125.04 - 1934.136 * jCent);
+    *sunDeclin = asind(sind(obliqCorr) * sind(sunAppLong));
+    varY = pow(tand(obliqCorr / 2), 2);
+    *eqOfTime = 4 * RAD2DEG * (varY * sind(2 * geomMeanLongSun) - 2 * eccentEarthOrbit * sind(geomMeanAnomSun) + 4 * eccentEarthOrbit * varY * sind(geomMeanAnomSun) * cosd(2 * geomMeanLongSun) - 0.5 * pow(varY, 2) * sind(4 * geomMeanLongSun) - 1.25 * pow(eccentEarthOrbit, 2) * sind(2 * geomMeanAnomSun));
+    profLeave();
+}
+
+/**
+ * Calculates approximately when a given solar event happens
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day, locTime modifies for fractional days
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ * locTime: decimal day offset for when to check
+ * event: The event to check:
+ *  > 1: sunrise
+ *  > 2: solar noon
+ *  > 3: sunset
+ *  > 0: day status
+ *
+ *  Output:
+ * Decimal day time of event. -1 means it doesn't happen
+ **/
+double calcEventApprox(double jDate, double tZ, double longitude, double latitude, double locTime, int event)
+{
+    double sunDeclin; // Sun's angular distance north/south of the equator
+    double eqOfTime;  // Difference between apparent solar time and mean solar time
+    double funcArg;   // argument of arccosine, so that we don't get an error if the value is of magnitude greater than 1
+    double HASunrise; // Cosine of the hour angle from the observer
+
+    double noon;           // solar noon (decimal day)
+    double rise = locTime; // sunrise (decimal day)
+    double set = locTime;  // sunset (decimal day)
+
+    int status; // what the day does. 0 it starts and ends, 1 there's sunlight all 24hrs. -1 it's dark all 24hrs
+
+    double eventTime; // Time of the given event.
+
+    // locTime -= longitude / (15 * HRSINDAY);
+    calcSunPos(jDate + locTime, &sunDeclin, &eqOfTime);
+    funcArg = sind(TWILIGHTANGLE) / (cosd(latitude) * cosd(sunDeclin)) - tand(latitude) * tand(sunDeclin);
+
+    if (funcArg < -1)
+    {
+        status = 1;
+        rise = -100;
+        set = -100;
+        noon = -100;
+    }
+    else if (funcArg > 1)
+    {
+        status = -1;
+        rise = -100;
+        set = -100;
+        noon = -100;
+    }
+    else
+    {
+        status = 0;
+        HASunrise = acosd(funcArg);
+        noon = (720 - 4.0 * longitude - eqOfTime + tZ * MININHR) / (HRSINDAY * MININHR);
+        rise = noon - HASunrise * 4.0 / (HRSINDAY * MININHR);
+        set = noon + HASunrise * 4.0 / (HRSINDAY * MININHR);
+    }
+
+    switch (event)
+    {
+    case 1:
+        eventTime = rise;
+        break;
+    case 2:
+        eventTime = noon;
+        break;
+    case 3:
+        eventTime = set;
+        break;
+    case 0:
+        eventTime = status;
+        break;
+    }
+
+    return eventTime;
+}
+
+/**
+ * Uses the approximate function to predict exact sunrise/sunset
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day. Must be beginning of the day.
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ * event: The event to check:
+ *  > 1: sunrise
+ *  > 2: solar noon
+ *  > 3: sunset
+ *
+ *  Output:
+ * Decimal day time of event. -1 means it doesn't happen
+ **/
+double calcEvent(double jDate, double tZ, double longitude, double latitude, int event)
+{
+    return calcEventIters(jDate, tZ, longitude, latitude, event, NULL);
+}
+
+/**
+ * As calcEvent, counting the fixed point's iterations
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ * event: 1 sunrise, 2 solar noon, 3 sunset
+ * pointer iters: variable to add the number of calcEventApprox calls to. May be NULL
+ *
+ *  Output:
+ * Decimal day time of event. -1 means it doesn't happen
+ **/
+double calcEventIters(double jDate, double tZ, double longitude, double latitude, int event, int *iters)
+{
+    int numIters = 0; // calcEventApprox calls
+    int passIters;    // calcEventApprox calls in the current pass
+    double locTimePrev;    // local time from previous iteration
+    double ansBegin;       // answer as of beginning of day
+    double ansEnd;         // answer as of end of day
+    double properTimeZone; // the time zone if it were perfect
+
+    double finalAns; // final answer
+
+    profEnter(PROFSOLVE);
+    ansBegin = BEGINDAY;
+    // printf("calcEvent called on jDate %.2f\n", jDate);
+
+    properTimeZone = longitude / (15);
+
+    // an answer within rounding of a half minute can flip between two minutes forever, so stop once it stops moving.
+    // the caps are far above anything fuzz mode has found and only guard against longer cycles
+    passIters = 0;
+    do
+    {
+        locTimePrev = ansBegin;
+        ansBegin = calcEventApprox(jDate, properTimeZone, longitude, latitude, ansBegin, event);
+        passIters++;
+    } while (ansBegin >= -1 && ansBegin <= 2 && roundToMin(ansBegin) != roundToMin(locTimePrev) && fabs(ansBegin - locTimePrev) > EVENTTOL &&
+             passIters < MAXEVENTITER);
+    numIters += passIters;
+
+    ansEnd = ENDDAY;
+    passIters = 0;
+    do
+    {
+        locTimePrev = ansEnd;
+        ansEnd = calcEventApprox(jDate, properTimeZone, longitude, latitude, ansEnd, event);
+        passIters++;
+    } while (ansEnd >= -1 && ansEnd <= 2 && roundToMin(ansEnd) != roundToMin(locTimePrev) && fabs(ansEnd - locTimePrev) > EVENTTOL &&
+             passIters < MAXEVENTITER);
+    numIters += passIters;
+
+    finalAns = fmax(ansEnd, ansBegin);
+
+    finalAns -= properTimeZone / HRSINDAY;
+    finalAns += tZ / HRSINDAY;
+    if (iters)
+    {
+        *iters += numIters;
+    }
+    profLeave();
+
+    return finalAns;
+}
+
+/**
+ * Calculates what type of solar day it is / how many solar events happen
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day, locTime modifies for fractional days
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ *
+ *  Output:
+ * -2: it's night for all 24hrs
+ * -1: it's day for all 24hrs
+ * 1: the sun rises OR sets, but not both
+ * 2: the sun rises AND sets (normal day)
+ **/
+int calcDayType(double jDate, double tZ, double longitude, double latitude)
+{
+    int output = 0; // function output
+    int statBegin;  // status as of beginning of day
+    int statEnd;    // status as of end of day;
+
+    profEnter(PROFPOLAR);
+    statBegin = calcEventApprox(jDate, tZ, longitude, latitude, BEGINDAY, 0);
+    statEnd = calcEventApprox(jDate, tZ, longitude, latitude, ENDDAY, 0);
+
+    output += (!statBegin || !statEnd);
+    output += (!statBegin && !statEnd);
+
+    if (output == 0)
+    {
+        switch (statBegin)
+        {
+        case -1: // dark all 24hrs
+            output = -2;
+            break;
+        case 1: // light all 24hrs
+            output = -1;
+            break;
+        }
+    }
+    profLeave();
+
+    return output;
+}
+
+/**
+ * Calculates the next or last specific solar event
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ * locTime: decimal day offset for when to check
+ * option: The event to find:
+ *  > -1: last sunrise
+ *  > 1: next sunrise
+ *  > -3: last sunset
+ *  > 3: next sunset
+ *
+ *  Output:
+ * Julian date of the next day that the given event happens. NOEVENTDAY if it doesn't within MAXEVENTDAYS days
+ **/
+double calcEventDay(double longitude, double latitude, double timeZone, double jDate, int option)
+{
+    return calcEventDayIters(longitude, latitude, timeZone, jDate, option, NULL, NULL);
+}
+
+/**
+ * As calcEventDay, counting the fixed point's iterations over every day it checks, and giving up at a deadline
+ *
+ *  Inputs:
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ * timeZone: time zone in UTC offset
+ * jDate: Julian date to check. Must be the beginning of a day
+ * option: -1 last sunrise, 1 next sunrise, -3 last sunset, 3 next sunset
+ * pointer iters: variable to add the number of calcEventApprox calls to. May be NULL
+ * pointer deadline: monoSec time to give up at, checked once per day. May be NULL
+ *
+ *  Output:
+ * Julian date of the next day that the given event happens. NOEVENTDAY if it doesn't within MAXEVENTDAYS days,
+ * MISSEDDEADLINE if the deadline passed first
+ **/
+double calcEventDayIters(double longitude, double latitude, double timeZone, double jDate, int option, int *iters, const double *deadline)
+{
+    int direction;    // the sign of option
+    int dayStatus;    // what the day does
+    int event;        // event, like whats used for the other functions
+    int numDays = 0;  // days checked
+
+    event = abs(option);
+    direction = (option > 0) - (option < 0);
+
+    // within a few hundredths of a degree of the poles, the sun can cross the horizon between the instants calcEvent
+    // checks on consecutive days, so that calcEvent finds no event on any day
+    profEnter(PROFPOLAR);
+    do
+    {
+        if (deadline && monoSec() > *deadline)
+        {
+            profLeave();
+            return MISSEDDEADLINE;
+        }
+        dayStatus = calcEventIters(jDate, timeZone, longitude, latitude, event, iters);
+        jDate += direction;
+        numDays++;
+    } while ((dayStatus < -1 || dayStatus >= 2) && numDays < MAXEVENTDAYS);
+    profLeave();
+
+    if (dayStatus < -1 || dayStatus >= 2)
+    {
+        return NOEVENTDAY;
+    }
+    jDate -= direction;
+
+    return jDate;
+}
+
+// EVENT ENUMERATION FUNCTIONS
+
+/**
+ * Evaluates the sun's position at the beginning, middle, and end of a day so that altArg can interpolate between them
+ *
+ *  Inputs:
+ * pointer eph: the structure to fill
+ * jDate: Julian date of the day. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void initDayEphem(DayEphem *eph, double jDate, double tZ, double longitude, double latitude)
+{
+    double sunDeclin;  // sun declination at a node (deg)
+    double maxCosDec;  // largest cosine of the declination over the day
+    double solarShift; // offset from the local time zone to local solar time (decimal day)
+
+    eph->tZ = tZ;
+    eph->longitude = longitude;
+    eph->sinLat = sind(latitude);
+    eph->cosLat = cosd(latitude);
+
+    // same epoch convention as calcEventApprox: beginning of the day plus local solar time
+    solarShift = longitude / (15 * HRSINDAY) - tZ / HRSINDAY;
+    maxCosDec = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        calcSunPos(jDate + LOCTIME * i + solarShift, &sunDeclin, &eph->eqTime[i]);
+        eph->sinDec[i] = sind(sunDeclin);
+        eph->cosDec[i] = cosd(sunDeclin);
+        maxCosDec = fmax(maxCosDec, eph->cosDec[i]);
+    }
+
+    // the hour angle turns 2 pi per day, and the declination drifts by well under DECLINRATE per day
+    eph->maxRate = 2 * M_PI * eph->cosLat * maxCosDec + DECLINRATE;
+}
+
+/**
+ * Quadratic interpolation through values at the beginning, middle, and end of a day
+ *
+ *  Inputs:
+ * nodes: values at decimal day 0, 0.5, and 1
+ * locTime: decimal day to interpolate at
+ *
+ *  Output:
+ * The interpolated value
+ **/
+double interpDay(const double *nodes, double locTime)
+{
+    double a; // first order coefficient
+    double b; // second order coefficient
+
+    a = -3 * nodes[0] + 4 * nodes[1] - nodes[2];
+    b = 2 * nodes[0] - 4 * nodes[1] + 2 * nodes[2];
+
+    return nodes[0] + locTime * (a + locTime * b);
+}
+
+/**
+ * Largest value of interpDay over the day
+ *
+ *  Inputs:
+ * nodes: values at decimal day 0, 0.5, and 1
+ *
+ *  Output:
+ * The largest interpolated value for a decimal day in [0, 1]
+ **/
+double interpDayMax(const double *nodes)
+{
+    double a;    // first order coefficient
+    double b;    // second order coefficient
+    double peak; // decimal day of the parabola's turning point, if it's a maximum
+
+    a = -3 * nodes[0] + 4 * nodes[1] - nodes[2];
+    b = 2 * nodes[0] - 4 * nodes[1] + 2 * nodes[2];
+    peak = b < 0 ? -a / (2 * b) : -1;
+
+    return fmax(fmax(nodes[0], nodes[2]), peak > 0 && peak < 1 ? interpDay(nodes, peak) : nodes[0]);
+}
+
+/**
+ * Sine of the solar altitude minus the sine of the twilight angle. Positive when the sun is up.
+ *
+ *  Inputs:
+ * eph: the interpolated sun position for the day
+ * locTime: decimal day in the requested time zone
+ *
+ *  Output:
+ * sin(altitude) - sin(TWILIGHTANGLE)
+ **/
+double altArg(const DayEphem *eph, double locTime)
+{
+    double trueSolarTime; // true solar time (minutes)
+    double hourAngle;     // hour angle of the sun (deg)
+
+    trueSolarTime = (locTime - eph->tZ / HRSINDAY) * HRSINDAY * MININHR + interpDay(eph->eqTime, locTime) + 4 * eph->longitude;
+    hourAngle = trueSolarTime / 4 - 180;
+
+    return eph->sinLat * interpDay(eph->sinDec, locTime) + eph->cosLat * interpDay(eph->cosDec, locTime) * cosd(hourAngle) - sind(TWILIGHTANGLE);
+}
+
+/**
+ * Refines a bracketed sign change of altArg (Illinois false position)
+ *
+ *  Inputs:
+ * eph: the interpolated sun position for the day
+ * lo: decimal day at the start of the bracket
+ * hi: decimal day at the end of the bracket
+ * fLo: altArg at lo
+ * fHi: altArg at hi
+ *
+ *  Output:
+ * Decimal day of the crossing, to within ROOTTOL
+ **/
+double findCrossing(const DayEphem *eph, double lo, double hi, double fLo, double fHi)
+{
+    double mid;   // current estimate
+    double fMid;  // altArg at the estimate
+    int side = 0; // which end was kept last time (-1 lo, 1 hi)
+
+    for (int i = 0; i < MAXROOTITER && hi - lo > ROOTTOL; i++)
+    {
+        mid = (lo * fHi - hi * fLo) / (fHi - fLo);
+        fMid = altArg(eph, mid);
+        if ((fMid > 0) == (fLo > 0))
+        {
+            lo = mid;
+            fLo = fMid;
+            if (side == -1)
+            {
+                fHi /= 2;
+            }
+            side = -1;
+        }
+        else
+        {
+            hi = mid;
+            fHi = fMid;
+            if (side == 1)
+            {
+                fLo /= 2;
+            }
+            side = 1;
+        }
+    }
+
+    return (lo * fHi - hi * fLo) / (fHi - fLo);
+}
+
+/**
+ * Calculates the time of the sun's upper transit (solar noon) within the day
+ *
+ *  Inputs:
+ * eph: the interpolated sun position for the day
+ *
+ *  Output:
+ * Decimal day of solar noon in the requested time zone. Range is [0, 1)
+ **/
+double transitTime(const DayEphem *eph)
+{
+    double noon = LOCTIME; // solar noon estimate (decimal day)
+
+    for (int i = 0; i < 2; i++)
+    {
+        noon = (720 - 4.0 * eph->longitude - interpDay(eph->eqTime, noon) + eph->tZ * MININHR) / (HRSINDAY * MININHR);
+        noon -= floor(noon);
+    }
+
+    return noon;
+}
+
+/**
+ * Finds every sunrise and sunset in a day by bracketing the sign changes of the solar altitude. The day is sampled on
+ * an adaptive grid: the step is the distance the altitude could possibly cover before reaching the threshold, so no
+ * crossing is skipped, and far from sunrise/sunset (or near the poles) only a handful of samples are needed.
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ * events: array of at least MAXDAYEVENTS in which to store the events, in order of time. Solar noon is always included.
+ * pointer sunUp: variable in which to store whether the sun is up at the beginning of the day
+ *
+ *  Output:
+ * The number of events stored
+ **/
+int calcDayEvents(double jDate, double tZ, double longitude, double latitude, SolarEvent *events, int *sunUp)
+{
+    DayEphem eph;       // sun position over the day
+    double t = 0;       // current sample (decimal day)
+    double tNext;       // next sample (decimal day)
+    double f;           // altArg at the current sample
+    double fNext;       // altArg at the next sample
+    double noon;        // solar noon (decimal day)
+    int numEvents = 0;  // number of events found
+    int pos;            // where solar noon goes in the list
+
+    profEnter(PROFENUM);
+    initDayEphem(&eph, jDate, tZ, longitude, latitude);
+    f = altArg(&eph, t);
+    *sunUp = f > 0;
+
+    while (t < 1 && numEvents < MAXDAYEVENTS - 1)
+    {
+        tNext = fmin(t + fmax(fabs(f) / eph.maxRate, MINSTEP), 1);
+        fNext = altArg(&eph, tNext);
+        if ((f > 0) != (fNext > 0))
+        {
+            events[numEvents].time = findCrossing(&eph, t, tNext, f, fNext);
+            events[numEvents].type = fNext > 0 ? 1 : 3;
+            numEvents++;
+        }
+        t = tNext;
+        f = fNext;
+    }
+
+    noon = transitTime(&eph);
+    for (pos = numEvents; pos > 0 && events[pos - 1].time > noon; pos--)
+    {
+        events[pos] = events[pos - 1];
+    }
+    events[pos].time = noon;
+    events[pos].type = 2;
+    profLeave();
+
+    return numEvents + 1;
+}
+
+/**
+ * Tells whether calcDayEvents is certain to find no sunrise or sunset on a day, without sampling it. Whatever the hour
+ * angle, altArg lies between sin(lat) sin(dec) - cos(lat) cos(dec) and sin(lat) sin(dec) + cos(lat) cos(dec), less the
+ * threshold, with the declination terms interpolated as calcDayEvents interpolates them. If either bound keeps one sign
+ * all day, the altitude never crosses the threshold. Days that only graze it are left to calcDayEvents.
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ *
+ *  Output:
+ * -2: it's certainly night for all 24hrs
+ * -1: it's certainly day for all 24hrs
+ * 0: calcDayEvents may find an event
+ **/
+int enumDayType(double jDate, double tZ, double longitude, double latitude)
+{
+    DayEphem eph;      // sun position over the day, as calcDayEvents has it
+    double highest[3]; // upper bound of altArg at the nodes
+    double lowest[3];  // lower bound of altArg at the nodes, negated
+
+    initDayEphem(&eph, jDate, tZ, longitude, latitude);
+    for (int i = 0; i < 3; i++)
+    {
+        highest[i] = eph.sinLat * eph.sinDec[i] + eph.cosLat * eph.cosDec[i] - sind(TWILIGHTANGLE);
+        lowest[i] = -(eph.sinLat * eph.sinDec[i] - eph.cosLat * eph.cosDec[i] - sind(TWILIGHTANGLE));
+    }
+
+    if (interpDayMax(highest) < 0)
+    {
+        return -2;
+    }
+    if (interpDayMax(lowest) < 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+// EVENT ITERATOR FUNCTIONS
+
+/**
+ * Same iteration as calcEvent, but started from a single guess instead of both ends of the day. When the guess is the
+ * previous day's time of the same event it usually converges on the first or second step.
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ * event: The event to check, as calcEvent
+ * seed: starting guess (decimal day in the time zone tZ)
+ *
+ *  Output:
+ * Decimal day time of event. Less than -1 means it doesn't happen
+ **/
+double calcEventSeeded(double jDate, double tZ, double longitude, double latitude, int event, double seed)
+{
+    double locTimePrev;    // local time from previous iteration
+    double ans;            // current answer
+    double properTimeZone; // the time zone if it were perfect
+    int numIters = 0;      // calcEventApprox calls
+
+    properTimeZone = longitude / (15);
+    ans = seed + properTimeZone / HRSINDAY - tZ / HRSINDAY;
+
+    // stops as calcEvent's passes do
+    do
+    {
+        locTimePrev = ans;
+        ans = calcEventApprox(jDate, properTimeZone, longitude, latitude, ans, event);
+        numIters++;
+    } while (ans >= -1 && ans <= 2 && roundToMin(ans) != roundToMin(locTimePrev) && fabs(ans - locTimePrev) > EVENTTOL &&
+             numIters < MAXEVENTITER);
+
+    ans -= properTimeZone / HRSINDAY;
+    ans += tZ / HRSINDAY;
+
+    return ans;
+}
+
+/**
+ * Finds the end of a polar day or polar night without calculating the days in between. The day type only changes when
+ * the declination crosses a latitude-dependent limit, so the days of one polar period are contiguous; this gallops
+ * forward by doubling steps and then bisects the last step. Days are classified with enumDayType, so every day skipped
+ * is one calcDayEvents would find no event on.
+ *
+ *  Inputs:
+ * jDate: Julian date of a day in the polar period. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ *
+ *  Output:
+ * Julian date of the first day after the polar period (jDate + 1 if jDate isn't in one)
+ **/
+double polarPeriodEnd(double jDate, double tZ, double longitude, double latitude)
+{
+    return polarPeriodEdge(jDate, tZ, longitude, latitude, 1, enumDayType);
+}
+
+/**
+ * As polarPeriodEnd, in either direction
+ *
+ *  Inputs:
+ * jDate: Julian date of a day in the polar period. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ * direction: 1 to find the end of the period, -1 to find its beginning
+ * classify: classifies a day as calcDayType does, negative in a polar day or night (calcDayType or enumDayType)
+ *
+ *  Output:
+ * Julian date of the first day outside the polar period in the given direction (jDate + direction if jDate isn't in
+ * one), at most MAXPOLARDAYS days away
+ **/
+double polarPeriodEdge(double jDate, double tZ, double longitude, double latitude, int direction,
+                       int (*classify)(double, double, double, double))
+{
+    int dayType;  // type of the polar period, as classify
+    int lo = 0;   // offset of the last day known to be in the period
+    int hi = 1;   // offset of the first day that might be outside the period
+    int step = 1; // galloping step
+    int mid;      // bisection point
+
+    dayType = classify(jDate, tZ, longitude, latitude);
+    if (dayType >= 0)
+    {
+        return jDate + direction;
+    }
+
+    while (hi < MAXPOLARDAYS && classify(jDate + direction * hi, tZ, longitude, latitude) == dayType)
+    {
+        lo = hi;
+        step *= 2;
+        hi = lo + step;
+    }
+    hi = hi < MAXPOLARDAYS ? hi : MAXPOLARDAYS;
+
+    while (hi - lo > 1)
+    {
+        mid = (lo + hi) / 2;
+        if (classify(jDate + direction * mid, tZ, longitude, latitude) == dayType)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return jDate + direction * hi;
+}
+
+/**
+ * Sets up an event iterator over a range of days
+ *
+ *  Inputs:
+ * pointer it: the iterator to set up
+ * startJDate: Julian date of the first day. Must be the beginning of a day
+ * endJDate: Julian date of the first day not to include
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void initEventIter(EventIter *it, double startJDate, double endJDate, double tZ, double longitude, double latitude)
+{
+    it->tZ = tZ;
+    it->longitude = longitude;
+    it->latitude = latitude;
+    it->jDate = startJDate;
+    it->endJDate = endJDate;
+    it->bufDay = startJDate;
+    it->numEvents = 0;
+    it->next = 0;
+    it->seeded = 0;
+}
+
+/**
+ * Calculates the sunrises and sunsets of the iterator's next day into its buffer. Up to ENUMLAT each event is solved
+ * from the previous day's time; above it the day is enumerated, and polar periods are skipped with polarPeriodEnd.
+ *
+ *  Inputs:
+ * pointer it: the iterator
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void fillIterDay(EventIter *it)
+{
+    SolarEvent dayEvents[MAXDAYEVENTS]; // the day's events, including solar noon
+    int numDayEvents;                   // number of events in dayEvents
+    int sunUp;                          // whether the sun is up at the beginning of the day
+    double eventTime;                   // time of a solved event (decimal day)
+    int event;                          // event code, as calcEvent
+
+    it->numEvents = 0;
+    it->next = 0;
+    it->bufDay = it->jDate;
+
+    if (fabs(it->latitude) <= ENUMLAT)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            event = 2 * i + 1;
+            if (it->seeded)
+            {
+                eventTime = calcEventSeeded(it->jDate, it->tZ, it->longitude, it->latitude, event, it->seed[i]);
+            }
+            else
+            {
+                eventTime = calcEvent(it->jDate, it->tZ, it->longitude, it->latitude, event);
+            }
+            if (eventTime >= -1 && eventTime < 2)
+            {
+                it->events[it->numEvents].time = eventTime;
+                it->events[it->numEvents].type = event;
+                it->numEvents++;
+                it->seed[i] = eventTime;
+            }
+        }
+        it->seeded = it->numEvents == 2;
+        it->jDate += 1;
+    }
+    else
+    {
+        numDayEvents = calcDayEvents(it->jDate, it->tZ, it->longitude, it->latitude, dayEvents, &sunUp);
+        for (int i = 0; i < numDayEvents; i++)
+        {
+            if (dayEvents[i].type != 2)
+            {
+                it->events[it->numEvents++] = dayEvents[i];
+            }
+        }
+        if (numDayEvents == 1)
+        {
+            it->jDate = fmax(it->jDate + 1, polarPeriodEnd(it->jDate, it->tZ, it->longitude, it->latitude));
+        }
+        else
+        {
+            it->jDate += 1;
+        }
+    }
+}
+
+/**
+ * Produces the next sunrise or sunset from an event iterator
+ *
+ *  Inputs:
+ * pointer it: the iterator
+ * pointer jDate: variable in which to store the Julian date of the day the event falls on
+ * pointer event: variable in which to store the event. The time is a decimal day in [0, 1)
+ *
+ *  Output:
+ * 1 if an event was produced, 0 if the range is finished
+ **/
+int nextEvent(EventIter *it, double *jDate, SolarEvent *event)
+{
+    double dayOffset; // whole days between bufDay and the event
+
+    while (it->next >= it->numEvents)
+    {
+        if (it->jDate >= it->endJDate)
+        {
+            return 0;
+        }
+        fillIterDay(it);
+    }
+
+    *event = it->events[it->next++];
+    dayOffset = floor(event->time);
+    event->time -= dayOffset;
+    *jDate = it->bufDay + dayOffset;
+
+    return 1;
+}
+
+// GRID FUNCTIONS
+
+/**
+ * Allocates the arrays for a grid job's sites
+ *
+ *  Inputs:
+ * pointer sites: the structure to fill
+ * numSites: number of sites
+ *
+ *  Output:
+ * 1 if the allocation worked, 0 if not
+ **/
+int allocSiteArrays(SiteArrays *sites, int numSites)
+{
+    sites->numSites = numSites;
+    sites->longitude = malloc(numSites * sizeof(double));
+    sites->latitude = malloc(numSites * sizeof(double));
+    sites->secLat = malloc(numSites * sizeof(double));
+    sites->tanLat = malloc(numSites * sizeof(double));
+
+    if (!sites->longitude || !sites->latitude || !sites->secLat || !sites->tanLat)
+    {
+        freeSiteArrays(sites);
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Frees the arrays for a grid job's sites
+ *
+ *  Inputs:
+ * pointer sites: the structure to free
+ *
+ *  Output:
+ * None
+ **/
+void freeSiteArrays(SiteArrays *sites)
+{
+    free(sites->longitude);
+    free(sites->latitude);
+    free(sites->secLat);
+    free(sites->tanLat);
+    sites->longitude = sites->latitude = sites->secLat = sites->tanLat = NULL;
+}
+
+/**
+ * Calculates the per-site trig terms, once for the whole job
+ *
+ *  Inputs:
+ * pointer sites: sites with longitude and latitude filled in
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void prepSiteArrays(SiteArrays *sites)
+{
+    for (int i = 0; i < sites->numSites; i++)
+    {
+        sites->secLat[i] = 1 / cosd(sites->latitude[i]);
+        sites->tanLat[i] = tand(sites->latitude[i]);
+    }
+}
+
+/**
+ * Calculates the per-date ephemeris terms. The nodes are at the same epochs calcEvent uses (beginning of the day plus
+ * local solar time), which don't depend on the site, so every site on the date shares them.
+ *
+ *  Inputs:
+ * pointer eph: the structure to fill
+ * jDate: Julian date of the day. Must be the beginning of a day
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void calcDateEphem(DateEphem *eph, double jDate)
+{
+    const double twilightAngles[NUMTWILIGHTS] = {CIVILANGLE, NAUTICALANGLE, ASTROANGLE}; // twilight angles (deg)
+    double sunDeclin;                                                                     // sun declination at a node (deg)
+
+    for (int i = 0; i < 3; i++)
+    {
+        calcSunPos(jDate + LOCTIME * i, &sunDeclin, &eph->eqTime[i]);
+        eph->riseA[i] = sind(TWILIGHTANGLE) / cosd(sunDeclin);
+        eph->tanDec[i] = tand(sunDeclin);
+        for (int t = 0; t < NUMTWILIGHTS; t++)
+        {
+            eph->twilightA[t][i] = sind(twilightAngles[t]) / cosd(sunDeclin);
+        }
+        eph->secDec[i] = 1 / cosd(sunDeclin);
+    }
+}
+
+/**
+ * Solves one event for one site and date from the shared terms. This is the calcEvent iteration with the ephemeris
+ * interpolated instead of recalculated: it starts at the beginning of the day, and falls back to the end of the day
+ * if the event doesn't happen as of the beginning (as calcEvent does near the polar day/night limits).
+ *
+ *  Inputs:
+ * eph: the date's ephemeris terms
+ * secLat: 1 / cos(latitude) of the site
+ * tanLat: tangent of the latitude of the site
+ * event: 1 sunrise, 2 solar noon, 3 sunset
+ * pointer iters: variable to add the number of iterations to, for cost estimates. May be NULL
+ *
+ *  Output:
+ * Decimal day of the event in local solar time. Less than -1 means it doesn't happen
+ **/
+double gridEvent(const DateEphem *eph, double secLat, double tanLat, int event, int *iters)
+{
+    return gridEventAt(eph, eph->riseA, secLat, tanLat, event, iters);
+}
+
+/**
+ * As gridEvent, for the sun crossing any altitude
+ *
+ *  Inputs:
+ * eph: the date's ephemeris terms
+ * angleA: sin(altitude) / cos(declination) at the beginning, middle, and end of the solar day, as DateEphem's riseA
+ * secLat: 1 / cos(latitude) of the site
+ * tanLat: tangent of the latitude of the site
+ * event: 1 the sun rises past the altitude (dawn), 2 solar noon, 3 the sun sets past the altitude (dusk)
+ * pointer iters: variable to add the number of iterations to, for cost estimates. May be NULL
+ *
+ *  Output:
+ * Decimal day of the event in local solar time. Less than -1 means it doesn't happen
+ **/
+double gridEventAt(const DateEphem *eph, const double *angleA, double secLat, double tanLat, int event, int *iters)
+{
+    double ans = -100; // current answer (decimal day)
+    double prev;       // answer from the previous iteration
+    double funcArg;    // argument of arccosine
+    int iter;          // number of iterations
+
+    for (int pass = 0; pass < 2 && ans < -1; pass++)
+    {
+        ans = pass == 0 ? BEGINDAY : ENDDAY;
+        iter = 0;
+        do
+        {
+            prev = ans;
+            funcArg = secLat * interpDay(angleA, prev) - tanLat * interpDay(eph->tanDec, prev);
+            if (fabs(funcArg) > 1)
+            {
+                ans = -100;
+                break;
+            }
+            ans = (720 - interpDay(eph->eqTime, prev)) / (HRSINDAY * MININHR);
+            ans += (event - 2) * acosd(funcArg) * 4.0 / (HRSINDAY * MININHR);
+            iter++;
+        } while (ans >= -1 && ans <= 2 && fabs(ans - prev) > ROOTTOL && iter < MAXGRIDITER);
+        if (iters)
+        {
+            *iters += iter + 1;
+        }
+    }
+
+    return ans;
+}
+
+/**
+ * Stores one event in a grid job's output, in the job's output format
+ *
+ *  Inputs:
+ * job: the grid job
+ * out: output buffer
+ * index: position in the buffer, counted in events
+ * day: day of the job the event belongs to
+ * utcTime: decimal day in UTC. Less than -1 means the event doesn't happen
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void storeGridEvent(const GridJob *job, void *out, size_t index, int day, double utcTime)
+{
+    if (job->epochUnits == 0)
+    {
+        ((float *)out)[index] = utcTime < -1 ? NAN : utcTime * HRSINDAY * MININHR;
+    }
+    else
+    {
+        ((int64_t *)out)[index] = utcTime < -1 ? NOEPOCH : calcEpoch(job->startJDate + day, utcTime, job->epochUnits);
+    }
+}
+
+/**
+ * Calculates one tile of a grid job: a block of sites over a block of dates. The tile's site terms and ephemeris
+ * terms are small enough to stay in L1 cache while every pair is evaluated.
+ *
+ *  Inputs:
+ * job: the grid job
+ * sites: the sites being calculated
+ * ephs: the job's per-date terms
+ * siteBegin: first site of the tile
+ * siteEnd: one past the last site of the tile
+ * dayBegin: first day of the tile
+ * dayEnd: one past the last day of the tile
+ * out: output for the stripe of sites starting at siteBegin, as [site][day][rise, noon, set]
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void gridTile(const GridJob *job, const SiteArrays *sites, const DateEphem *ephs, int siteBegin, int siteEnd, int dayBegin, int dayEnd, void *out)
+{
+    double solarShift; // offset from local solar time to UTC (decimal day)
+    double eventTime;  // event time (decimal day)
+    size_t index;      // position of the site and day in the output
+
+    for (int i = siteBegin; i < siteEnd; i++)
+    {
+        solarShift = sites->longitude[i] / (15 * HRSINDAY);
+        for (int d = dayBegin; d < dayEnd; d++)
+        {
+            index = ((size_t)(i - siteBegin) * job->numDays + d) * 3;
+            for (int e = 0; e < 3; e++)
+            {
+                eventTime = gridEvent(&ephs[d], sites->secLat[i], sites->tanLat[i], e + 1, NULL);
+                storeGridEvent(job, out, index + e, d, eventTime < -1 ? eventTime : eventTime - solarShift);
+            }
+        }
+    }
+}
+
+/**
+ * Calculates one site's days with calcEvent, for comparison with the tiled engine
+ *
+ *  Inputs:
+ * job: the grid job
+ * sites: the sites being calculated
+ * siteBegin: first site of the stripe
+ * site: the site to calculate
+ * out: output for the stripe, as gridTile
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void gridNaiveRow(const GridJob *job, const SiteArrays *sites, int siteBegin, int site, void *out)
+{
+    size_t index; // position of the site and day in the output
+
+    for (int d = 0; d < job->numDays; d++)
+    {
+        index = ((size_t)(site - siteBegin) * job->numDays + d) * 3;
+        for (int e = 0; e < 3; e++)
+        {
+            storeGridEvent(job, out, index + e, d,
+                           calcEvent(job->startJDate + d, 0, sites->longitude[site], sites->latitude[site], e + 1));
+        }
+    }
+}
+
+/**
+ * Finds whether the sun is up all day or down all day at a site when gridEvent finds no sunrise or sunset
+ *
+ *  Inputs:
+ * eph: the date's ephemeris terms
+ * secLat: 1 / cos(latitude) of the site
+ * tanLat: tangent of the latitude of the site
+ *
+ *  Output:
+ * 1 if it's day for all 24hrs, -1 if it's night for all 24hrs (as calcEventApprox's status at solar noon)
+ **/
+int gridDayStatus(const DateEphem *eph, double secLat, double tanLat)
+{
+    return secLat * eph->riseA[1] - tanLat * eph->tanDec[1] < -1 ? 1 : -1;
+}
+
+/**
+ * Reduces one site's days to yearly statistics as they are calculated, without keeping the days. Days with only a
+ * sunrise or only a sunset count the sunlight up to the end or from the beginning of the solar day.
+ *
+ *  Inputs:
+ * sites: the job's sites
+ * ephs: the job's per-date terms, starting on January 1 of firstYear
+ * site: the site to calculate
+ * firstYear: the first calendar year
+ * numYears: number of years
+ * out: array of numYears records to fill
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void siteYearStats(const SiteArrays *sites, const DateEphem *ephs, int site, int firstYear, int numYears, SiteYearStats *out)
+{
+    double rise;        // sunrise (decimal day, local solar time)
+    double set;         // sunset (decimal day, local solar time)
+    double dayLen;      // amount of sunlight (minutes)
+    double totalLen;    // running total of sunlight (minutes)
+    double solarShift;  // offset from local solar time to UTC (minutes)
+    int yearLen;        // number of days in the year
+    int riseMin;        // sunrise (UTC minutes)
+    int setMin;         // sunset (UTC minutes)
+    SiteYearStats *rec; // the current record
+
+    solarShift = 4 * sites->longitude[site];
+    for (int y = 0; y < numYears; y++)
+    {
+        rec = &out[y];
+        rec->latitude = sites->latitude[site];
+        rec->longitude = sites->longitude[site];
+        rec->year = firstYear + y;
+        rec->minDayLen = HRSINDAY * MININHR;
+        rec->maxDayLen = 0;
+        rec->earliestRise = NOTIME;
+        rec->latestSet = NOTIME;
+        rec->polarNightDays = 0;
+        totalLen = 0;
+
+        yearLen = DAYSINYEAR + isLeapYear(firstYear + y);
+        for (int d = 0; d < yearLen; d++, ephs++)
+        {
+            rise = gridEvent(ephs, sites->secLat[site], sites->tanLat[site], 1, NULL);
+            set = gridEvent(ephs, sites->secLat[site], sites->tanLat[site], 3, NULL);
+
+            if (rise < -1 && set < -1)
+            {
+                dayLen = gridDayStatus(ephs, sites->secLat[site], sites->tanLat[site]) == 1 ? HRSINDAY * MININHR : 0;
+                rec->polarNightDays += dayLen == 0;
+            }
+            else
+            {
+                dayLen = ((set < -1 ? 1 : set) - (rise < -1 ? 0 : rise)) * HRSINDAY * MININHR;
+            }
+            if (rise >= -1)
+            {
+                riseMin = (int)round(rise * HRSINDAY * MININHR - solarShift);
+                if (rec->earliestRise == NOTIME || riseMin < rec->earliestRise)
+                {
+                    rec->earliestRise = riseMin;
+                }
+            }
+            if (set >= -1)
+            {
+                setMin = (int)round(set * HRSINDAY * MININHR - solarShift);
+                if (rec->latestSet == NOTIME || setMin > rec->latestSet)
+                {
+                    rec->latestSet = setMin;
+                }
+            }
+
+            totalLen += dayLen;
+            if (round(dayLen) < rec->minDayLen)
+            {
+                rec->minDayLen = round(dayLen);
+            }
+            if (round(dayLen) > rec->maxDayLen)
+            {
+                rec->maxDayLen = round(dayLen);
+            }
+        }
+        rec->meanDayLen = totalLen / yearLen;
+    }
+}
+
+// TIME ZONE FUNCTIONS
+
+/**
+ * Reads a signed big-endian integer, as stored in tzdata files
+ *
+ *  Inputs:
+ * bytes: the integer's bytes
+ * numBytes: 4 or 8
+ *
+ *  Output:
+ * The integer
+ **/
+int64_t readBigEndian(const unsigned char *bytes, int numBytes)
+{
+    uint64_t value = 0; // unsigned value
+
+    for (int i = 0; i < numBytes; i++)
+    {
+        value = (value << 8) | bytes[i];
+    }
+
+    return numBytes == 4 ? (int32_t)value : (int64_t)value;
+}
+
+/**
+ * Skips a zone abbreviation in a POSIX TZ rule (letters, or anything in angle brackets)
+ *
+ *  Inputs:
+ * rule: the rule, at the start of the abbreviation
+ *
+ *  Output:
+ * The rule after the abbreviation
+ **/
+const char *parseTzName(const char *rule)
+{
+    if (*rule == '<')
+    {
+        while (*rule && *rule != '>')
+        {
+            rule++;
+        }
+        return *rule ? rule + 1 : rule;
+    }
+    while (isalpha((unsigned char)*rule))
+    {
+        rule++;
+    }
+
+    return rule;
+}
+
+/**
+ * Reads a [+|-]hh[:mm[:ss]] time from a POSIX TZ rule
+ *
+ *  Inputs:
+ * rule: the rule, at the start of the time
+ * pointer seconds: variable in which to store the time in seconds (with the sign as written)
+ *
+ *  Output:
+ * The rule after the time
+ **/
+const char *parseTzOffset(const char *rule, int32_t *seconds)
+{
+    int sign = 1;   // sign of the time
+    int32_t part;   // hours, minutes, or seconds
+    int32_t scale;  // seconds per unit of the current part
+
+    if (*rule == '+' || *rule == '-')
+    {
+        sign = *rule == '-' ? -1 : 1;
+        rule++;
+    }
+
+    *seconds = 0;
+    for (scale = SECINHR; scale >= 1; scale /= SECINMIN)
+    {
+        part = 0;
+        while (isdigit((unsigned char)*rule))
+        {
+            part = part * 10 + (*rule++ - '0');
+        }
+        *seconds += part * scale;
+        if (*rule != ':' || scale == 1)
+        {
+            break;
+        }
+        rule++;
+    }
+    *seconds *= sign;
+
+    return rule;
+}
+
+/**
+ * Reads a transition date and time from a POSIX TZ rule: Mm.w.d, Jn, or n, then an optional /time
+ *
+ *  Inputs:
+ * rule: the rule, at the start of the date
+ * pointer kind: variable in which to store 'M', 'J', or 'n'
+ * pointer a: variable in which to store the month (M) or day number (J, n)
+ * pointer b: variable in which to store the week of the month (M, 5 means the last)
+ * pointer c: variable in which to store the day of the week (M, 0 is Sunday)
+ * pointer time: variable in which to store the local time of day (seconds)
+ *
+ *  Output:
+ * The rule after the date, or NULL if it isn't valid
+ **/
+const char *parseTzDate(const char *rule, int *kind, int *a, int *b, int *c, int32_t *time)
+{
+    char *end; // end of a number
+
+    *kind = *rule == 'M' || *rule == 'J' ? *rule++ : 'n';
+    *a = strtol(rule, &end, 10);
+    if (end == rule)
+    {
+        return NULL;
+    }
+    rule = end;
+    if (*kind == 'M')
+    {
+        if (sscanf(rule, ".%d.%d", b, c) != 2)
+        {
+            return NULL;
+        }
+        rule = strchr(rule + 1, '.') + 1;
+        while (isdigit((unsigned char)*rule))
+        {
+            rule++;
+        }
+    }
+
+    *time = TZDEFAULTTIME;
+    if (*rule == '/')
+    {
+        rule = parseTzOffset(rule + 1, time);
+    }
+
+    return rule;
+}
+
+/**
+ * Calculates the Unix time of a POSIX TZ rule's transition in a given year
+ *
+ *  Inputs:
+ * year: the year
+ * kind, a, b, c: the date, as parseTzDate
+ * localTime: seconds after local midnight (may be negative or past 24 hours)
+ * offset: UTC offset in effect before the transition (seconds)
+ *
+ *  Output:
+ * Unix time of the transition (seconds)
+ **/
+int64_t tzRuleTime(int year, int kind, int a, int b, int c, int32_t localTime, int32_t offset)
+{
+    int64_t days;   // days from 1970-01-01 to the transition date
+    int firstDay;   // day of the week of the first of the month
+    int dayOfMonth; // day of the month of the transition
+
+    if (kind == 'M')
+    {
+        days = llround(calcJDate(1, a, year, 0) - JDATEUNIX);
+        firstDay = (int)(((days + 4) % DAYSINWEEK + DAYSINWEEK) % DAYSINWEEK); // 1970-01-01 was a Thursday
+        dayOfMonth = 1 + (c - firstDay + DAYSINWEEK) % DAYSINWEEK + (b - 1) * DAYSINWEEK;
+        while (dayOfMonth > monthLen(a, year))
+        {
+            dayOfMonth -= DAYSINWEEK;
+        }
+        days += dayOfMonth - 1;
+    }
+    else
+    {
+        days = llround(calcJDate(1, JAN, year, 0) - JDATEUNIX);
+        days += kind == 'J' ? a - 1 + (isLeapYear(year) && a >= 60) : a;
+    }
+
+    return days * SECINDAY + localTime - offset;
+}
+
+/**
+ * Appends a transition to a zone, growing its arrays as needed
+ *
+ *  Inputs:
+ * pointer zone: the zone
+ * pointer capacity: the arrays' current capacity, updated if they grow
+ * time: Unix time of the transition (seconds)
+ * offset: UTC offset from the transition on (seconds)
+ *
+ *  Output:
+ * 1 if it worked, 0 if memory couldn't be allocated
+ **/
+int addTzTrans(TzZone *zone, int *capacity, int64_t time, int32_t offset)
+{
+    int64_t *times;   // grown transition times
+    int32_t *offsets; // grown transition offsets
+
+    if (zone->numTrans == *capacity)
+    {
+        *capacity = *capacity * 2 + 16;
+        times = realloc(zone->transTimes, *capacity * sizeof(int64_t));
+        offsets = realloc(zone->transOffsets, *capacity * sizeof(int32_t));
+        if (times)
+        {
+            zone->transTimes = times;
+        }
+        if (offsets)
+        {
+            zone->transOffsets = offsets;
+        }
+        if (!times || !offsets)
+        {
+            return 0;
+        }
+    }
+    zone->transTimes[zone->numTrans] = time;
+    zone->transOffsets[zone->numTrans] = offset;
+    zone->numTrans++;
+
+    return 1;
+}
+
+/**
+ * Turns the POSIX TZ rule at the end of a tzdata file (used for times after its last transition) into explicit
+ * transitions up to TZMAXYEAR, so every lookup is a binary search
+ *
+ *  Inputs:
+ * pointer zone: the zone, with the file's transitions already loaded
+ * pointer capacity: the zone's array capacity
+ * rule: the rule, like "GMT0BST,M3.5.0/1,M10.5.0"
+ *
+ *  Output:
+ * 1 if it worked (or there's no daylight saving to add), 0 if not
+ **/
+int expandTzRule(TzZone *zone, int *capacity, const char *rule)
+{
+    int32_t stdOffset;      // standard UTC offset (seconds)
+    int32_t dstOffset;      // daylight saving UTC offset (seconds)
+    int kinds[2];           // kind of the start and end dates
+    int a[2], b[2], c[2];   // start and end dates
+    int32_t times[2];       // start and end local times (seconds)
+    int64_t trans[2];       // start and end Unix times (seconds)
+    int64_t lastTime;       // time of the last explicit transition
+    int firstYear = 1970;   // first year to add transitions for
+    int day, month;         // date of the last explicit transition
+    int first;              // which of the year's transitions comes first
+
+    rule = parseTzOffset(parseTzName(rule), &stdOffset);
+    stdOffset = -stdOffset; // POSIX offsets are positive west of Greenwich
+    if (*rule == '\0' || *rule == '\n')
+    {
+        return 1;
+    }
+    rule = parseTzName(rule);
+    dstOffset = stdOffset + SECINHR;
+    if (*rule != ',')
+    {
+        rule = parseTzOffset(rule, &dstOffset);
+        dstOffset = -dstOffset;
+    }
+    if (*rule != ',' || !(rule = parseTzDate(rule + 1, &kinds[0], &a[0], &b[0], &c[0], &times[0])) || *rule != ',' ||
+        !(rule = parseTzDate(rule + 1, &kinds[1], &a[1], &b[1], &c[1], &times[1])))
+    {
+        return 0;
+    }
+
+    lastTime = zone->numTrans ? zone->transTimes[zone->numTrans - 1] : INT64_MIN;
+    if (zone->numTrans)
+    {
+        calcDate(JDATEUNIX + floor((double)lastTime / SECINDAY), 0, &day, &month, &firstYear);
+    }
+    for (int year = firstYear; year <= TZMAXYEAR; year++)
+    {
+        trans[0] = tzRuleTime(year, kinds[0], a[0], b[0], c[0], times[0], stdOffset);
+        trans[1] = tzRuleTime(year, kinds[1], a[1], b[1], c[1], times[1], dstOffset);
+        first = trans[1] < trans[0]; // southern hemisphere zones end daylight saving before it starts again
+        for (int k = 0; k < 2; k++)
+        {
+            int which = k ^ first; // transition to add
+            if (trans[which] > lastTime && !addTzTrans(zone, capacity, trans[which], which == 0 ? dstOffset : stdOffset))
+            {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Reads the counts in a TZif header and works out the size of the data block that follows it
+ *
+ *  Inputs:
+ * header: the 44 byte header
+ * timeSize: size of a transition time in the block (4 for the version 1 block, 8 for the version 2 block)
+ * counts: array of 6 to fill with the UT indicator, standard indicator, leap second, transition, type, and
+ *  character counts
+ *
+ *  Output:
+ * Size of the data block in bytes, or -1 if a count is negative
+ **/
+int64_t readTzHeader(const unsigned char *header, int timeSize, int64_t *counts)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        counts[i] = readBigEndian(header + 20 + 4 * i, 4);
+        if (counts[i] < 0)
+        {
+            return -1;
+        }
+    }
+
+    return counts[3] * (timeSize + 1) + counts[4] * 6 + counts[5] + counts[2] * (timeSize + 4) + counts[1] + counts[0];
+}
+
+/**
+ * Reads a zone's transitions from the system tzdata (TZif files, versions 1 to 4)
+ *
+ *  Inputs:
+ * pointer zone: the zone to fill
+ * name: IANA zone name. Looked up under $TZDIR, or TZDIR if that isn't set
+ *
+ *  Output:
+ * 1 if it worked, 0 if the zone couldn't be read
+ **/
+int loadTzZone(TzZone *zone, const char *name)
+{
+    char path[BUFSIZ];        // path of the zone's file
+    unsigned char *data;      // the file's contents
+    const unsigned char *p;   // current position in the file
+    const char *tzDir;        // tzdata directory
+    FILE *file;               // the file
+    long size;                // size of the file
+    int64_t counts[6];        // UT indicator, standard indicator, leap second, transition, type, and character counts
+    int64_t blockSize;        // size of the data block after the current header
+    int timeSize = 4;         // size of a transition time
+    int capacity = 0;         // capacity of the zone's arrays
+    int ok = 1;               // whether the file is valid
+    const unsigned char *types; // the local time types
+
+    tzDir = getenv("TZDIR") ? getenv("TZDIR") : TZDIR;
+    if (strlen(name) >= TZNAMELEN || strstr(name, "..") || snprintf(path, BUFSIZ, "%s/%s", tzDir, name) >= BUFSIZ ||
+        !(file = fopen(path, "rb")))
+    {
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    rewind(file);
+    data = malloc(size + 1);
+    if (!data || size < 44 || fread(data, 1, size, file) != (size_t)size || memcmp(data, "TZif", 4) != 0)
+    {
+        fclose(file);
+        free(data);
+        return 0;
+    }
+    fclose(file);
+    data[size] = '\0';
+
+    // version 2 and later files repeat the data with 64-bit times after the 32-bit block. Each block is checked to
+    // end inside the file before p moves past it, so nothing below reads beyond the data
+    p = data;
+    blockSize = readTzHeader(p, timeSize, counts);
+    ok = blockSize >= 0 && 44 + blockSize <= size;
+    if (ok && data[4] >= '2')
+    {
+        p += 44 + blockSize;
+        timeSize = 8;
+        ok = p + 44 <= data + size && memcmp(p, "TZif", 4) == 0;
+        blockSize = ok ? readTzHeader(p, timeSize, counts) : -1;
+        ok = blockSize >= 0 && (p - data) + 44 + blockSize <= size;
+    }
+    ok = ok && counts[4] > 0;
+
+    strcpy(zone->name, name);
+    zone->numTrans = 0;
+    zone->transTimes = NULL;
+    zone->transOffsets = NULL;
+    zone->firstOffset = 0;
+    if (ok)
+    {
+        types = p + 44 + counts[3] * (timeSize + 1);
+        zone->firstOffset = (int32_t)readBigEndian(types, 4);
+        for (int64_t i = 0; i < counts[3] && ok; i++)
+        {
+            int type = p[44 + counts[3] * timeSize + i]; // local time type of the transition
+            ok = type < counts[4] && addTzTrans(zone, &capacity, readBigEndian(p + 44 + i * timeSize, timeSize),
+                                                (int32_t)readBigEndian(types + type * 6, 4));
+        }
+        p = types + counts[4] * 6 + counts[5] + counts[2] * (timeSize + 4) + counts[1] + counts[0];
+        if (ok && timeSize == 8 && p < data + size && *p == '\n')
+        {
+            ok = expandTzRule(zone, &capacity, (const char *)p + 1);
+        }
+    }
+
+    free(data);
+    if (!ok)
+    {
+        free(zone->transTimes);
+        free(zone->transOffsets);
+    }
+
+    return ok;
+}
+
+/**
+ * Finds a zone in the cache, loading it the first time it's asked for
+ *
+ *  Inputs:
+ * pointer cache: the zone cache
+ * name: IANA zone name
+ *
+ *  Output:
+ * The zone, or NULL if it couldn't be loaded
+ **/
+const TzZone *findTzZone(TzCache *cache, const char *name)
+{
+    for (int i = 0; i < cache->numZones; i++)
+    {
+        if (strcmp(cache->zones[i].name, name) == 0)
+        {
+            return &cache->zones[i];
+        }
+    }
+    if (cache->numZones == MAXZONES || !loadTzZone(&cache->zones[cache->numZones], name))
+    {
+        return NULL;
+    }
+
+    return &cache->zones[cache->numZones++];
+}
+
+/**
+ * Frees every zone in the cache
+ *
+ *  Inputs:
+ * pointer cache: the zone cache
+ *
+ *  Output:
+ * None
+ **/
+void freeTzCache(TzCache *cache)
+{
+    for (int i = 0; i < cache->numZones; i++)
+    {
+        free(cache->zones[i].transTimes);
+        free(cache->zones[i].transOffsets);
+    }
+    cache->numZones = 0;
+}
+
+/**
+ * Finds a zone's UTC offset at a given instant (binary search over the transitions)
+ *
+ *  Inputs:
+ * zone: the zone
+ * unixTime: the instant, in Unix time (seconds)
+ *
+ *  Output:
+ * UTC offset (seconds)
+ **/
+int32_t tzOffsetAt(const TzZone *zone, int64_t unixTime)
+{
+    int lo = 0;               // first transition that might be after unixTime
+    int hi = zone->numTrans;  // one past the last
+    int mid;                  // bisection point
+
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        if (zone->transTimes[mid] <= unixTime)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo == 0 ? zone->firstOffset : zone->transOffsets[lo - 1];
+}
+
+/**
+ * Finds a zone's UTC offset at local midnight at the beginning of a date
+ *
+ *  Inputs:
+ * zone: the zone
+ * jDate: Julian date of the date (UTC midnight, as calcJDate)
+ *
+ *  Output:
+ * UTC offset (hours)
+ **/
+double zoneDayOffset(const TzZone *zone, double jDate)
+{
+    int64_t midnight; // the date's midnight, as if it were UTC (seconds)
+    int32_t offset;   // UTC offset (seconds)
+
+    midnight = llround(jDate - JDATEUNIX) * SECINDAY;
+    offset = tzOffsetAt(zone, midnight);
+    offset = tzOffsetAt(zone, midnight - offset);
+
+    return (double)offset / SECINHR;
+}
+
+/**
+ * Converts a time calculated with a fixed UTC offset to the zone's wall clock at that instant, so daylight saving
+ * changes between the beginning of the day and the event are accounted for
+ *
+ *  Inputs:
+ * zone: the zone
+ * jDate: Julian date of the day (UTC midnight, as calcJDate)
+ * tZ: the UTC offset the time was calculated with (hours)
+ * locTime: decimal day in that offset
+ *
+ *  Output:
+ * Decimal day on the zone's wall clock, relative to the same date (may be outside [0, 1))
+ **/
+double zoneLocalTime(const TzZone *zone, double jDate, double tZ, double locTime)
+{
+    int32_t offset; // the zone's UTC offset at the event (seconds)
+
+    offset = tzOffsetAt(zone, calcEpoch(jDate, locTime - tZ / HRSINDAY, SECINDAY));
+
+    return locTime + ((double)offset / SECINHR - tZ) / HRSINDAY;
+}
+
+// HORIZON FUNCTIONS
+
+/**
+ * Finds a site's horizon elevation in a given direction, interpolating between azimuth bins
+ *
+ *  Inputs:
+ * site: the site
+ * azimuth: direction (deg clockwise from north)
+ *
+ *  Output:
+ * Horizon elevation (deg)
+ **/
+double horizonAt(const HorizonSite *site, double azimuth)
+{
+    double pos;  // position in bins
+    int bin;     // bin at or before the direction
+    double frac; // fraction of the way to the next bin
+
+    pos = azimuth / (360.0 / HORIZONBINS);
+    pos -= floor(pos / HORIZONBINS) * HORIZONBINS;
+    bin = (int)pos;
+    frac = pos - bin;
+
+    return (site->elev[bin % HORIZONBINS] * (1 - frac) + site->elev[(bin + 1) % HORIZONBINS] * frac) * HORIZONSCALE;
+}
+
+/**
+ * Calculates the sun's azimuth at a time of day, from a date's ephemeris terms
+ *
+ *  Inputs:
+ * eph: the date's ephemeris terms
+ * sinLat: sine of the latitude
+ * cosLat: cosine of the latitude
+ * solarTime: decimal day in local solar time
+ *
+ *  Output:
+ * Azimuth (deg clockwise from north)
+ **/
+double sunAzimuth(const DateEphem *eph, double sinLat, double cosLat, double solarTime)
+{
+    double hourAngle; // hour angle of the sun (deg)
+    double tanDec;    // tangent of the declination
+
+    hourAngle = (solarTime * HRSINDAY * MININHR + interpDay(eph->eqTime, solarTime)) / 4 - 180;
+    tanDec = interpDay(eph->tanDec, solarTime);
+
+    return 180 + RAD2DEG * atan2(sind(hourAngle), cosd(hourAngle) * sinLat - tanDec * cosLat);
+}
+
+/**
+ * Solves a sunrise or sunset behind terrain. The threshold altitude depends on where along the horizon the sun is,
+ * so this alternates between solving for the time with a fixed threshold and moving the threshold to the horizon at
+ * the sun's azimuth at that time. A flat profile needs one solve, and starting from the previous day's threshold
+ * usually needs two.
+ *
+ *  Inputs:
+ * eph: the date's ephemeris terms
+ * site: the site
+ * secLat: 1 / cos(latitude) of the site
+ * tanLat: tangent of the latitude of the site
+ * event: 1 sunrise, 2 solar noon, 3 sunset
+ * flat: whether the site's horizon is the same in every direction
+ * threshold: threshold altitude to start from (deg), or NAN for none; replaced by the one found
+ *
+ *  Output:
+ * Decimal day of the event in local solar time. Less than -1 means it doesn't happen
+ **/
+double horizonEvent(const DateEphem *eph, const HorizonSite *site, double secLat, double tanLat, int event, int flat,
+                    double *threshold)
+{
+    double base;      // threshold altitude with a flat horizon (deg)
+    double sinThresh; // sine of the current threshold
+    double next;      // threshold at the current solution's azimuth (deg)
+    double angleA[3]; // sin(threshold) / cos(declination) at the beginning, middle, and end of the day
+    double ans = 0;   // current solution (decimal day)
+
+    base = TWILIGHTANGLE - DIPCOEFF * sqrt(fmax(site->height, 0));
+    if (isnan(*threshold))
+    {
+        *threshold = base + horizonAt(site, event == 1 ? 90 : 270);
+    }
+    for (int iter = 0; iter < MAXHORIZONITER; iter++)
+    {
+        sinThresh = sind(*threshold);
+        for (int i = 0; i < 3; i++)
+        {
+            angleA[i] = sinThresh * eph->secDec[i];
+        }
+        ans = gridEventAt(eph, angleA, secLat, tanLat, event, NULL);
+        if (ans < -1 || event == 2 || flat)
+        {
+            break;
+        }
+        next = base + horizonAt(site, sunAzimuth(eph, sind(site->latitude), cosd(site->latitude), ans));
+        if (fabs(next - *threshold) < HORIZONTOL)
+        {
+            break;
+        }
+        // halfway steps stop the threshold from bouncing between the two sides of a steep notch
+        *threshold = iter < 2 ? next : (*threshold + next) / 2;
+    }
+
+    return ans;
+}
+
+/**
+ * Builds a horizon catalog file from text. Each line is "latitude longitude height e1 e2 ... eN": the observer's
+ * height (m) and N >= 1 horizon elevations (deg) at evenly spaced azimuths starting at north, which are resampled to
+ * HORIZONBINS bins and quantized to HORIZONSCALE deg.
+ *
+ *  Inputs:
+ * inPath: text file to read
+ * outPath: catalog file to write
+ *
+ *  Output:
+ * 1 if it worked, 0 if not
+ **/
+int buildHorizonCatalog(const char *inPath, const char *outPath)
+{
+    char line[BUFSIZ * 4];       // input line
+    double elevs[HORIZONBINS * 8]; // elevations as read (deg)
+    int numElevs;                // number of elevations read
+    int numRead;                 // characters read by sscanf
+    char *pos;                   // current position in the line
+    double pos2;                 // position of a bin in the input's azimuth steps
+    int below;                   // input azimuth at or before the bin
+    double elev;                 // resampled elevation (deg)
+    HorizonHeader header;        // the catalog's header
+    HorizonSite site;            // current site
+    FILE *inFile;                // text file
+    FILE *outFile;               // catalog file
+
+    inFile = fopen(inPath, "r");
+    outFile = fopen(outPath, "wb");
+    if (!inFile || !outFile)
+    {
+        if (inFile)
+        {
+            fclose(inFile);
+        }
+        if (outFile)
+        {
+            fclose(outFile);
+        }
+        return 0;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.numBins = HORIZONBINS;
+    fwrite(&header, sizeof(header), 1, outFile);
+    while (fgets(line, sizeof(line), inFile))
+    {
+        if (sscanf(line, "%f %f %f%n", &site.latitude, &site.longitude, &site.height, &numRead) != 3 ||
+            fabs(site.latitude) >= LATRANGE || fabs(site.longitude) >= LONGRANGE)
+        {
+            continue;
+        }
+        pos = line + numRead;
+        numElevs = 0;
+        while (numElevs < HORIZONBINS * 8 && sscanf(pos, "%lf%n", &elevs[numElevs], &numRead) == 1)
+        {
+            pos += numRead;
+            numElevs++;
+        }
+        if (numElevs == 0)
+        {
+            continue;
+        }
+        for (int b = 0; b < HORIZONBINS; b++)
+        {
+            pos2 = (double)b * numElevs / HORIZONBINS;
+            below = (int)pos2;
+            elev = elevs[below] + (elevs[(below + 1) % numElevs] - elevs[below]) * (pos2 - below);
+            site.elev[b] = (int8_t)fmax(INT8_MIN, fmin(INT8_MAX, round(elev / HORIZONSCALE)));
+        }
+        fwrite(&site, sizeof(site), 1, outFile);
+        header.numSites++;
+    }
+
+    // the count is only known at the end; the magic goes in with it
+    memcpy(header.magic, HORMAGIC, sizeof(HORMAGIC));
+    rewind(outFile);
+    fwrite(&header, sizeof(header), 1, outFile);
+    fclose(inFile);
+
+    return fclose(outFile) == 0;
+}
+
+/**
+ * Calculates sunrise, solar noon, and sunset behind each site's horizon for every site of a horizon catalog. The
+ * catalog is memory mapped, and the sites are calculated in parallel. Output is as grid mode's float32 format.
+ *
+ *  Inputs:
+ * catalogPath: horizon catalog file
+ * startJDate: Julian date of the first day
+ * numDays: number of days
+ * outPath: output file
+ *
+ *  Output:
+ * 1 if it worked, 0 if not
+ **/
+int runHorizonCatalog(const char *catalogPath, double startJDate, int numDays, const char *outPath)
+{
+    const HorizonHeader *header; // the catalog's header
+    const HorizonSite *sites;    // the catalog's sites
+    struct stat fileInfo;        // the catalog's size
+    DateEphem *ephs;             // per-date terms
+    float *out;                  // output for one stripe of sites
+    FILE *outFile;               // output file
+    int stripeEnd;               // one past the last site of the current stripe
+    int fd;                      // catalog file descriptor
+
+    fd = open(catalogPath, O_RDONLY);
+    if (fd < 0 || fstat(fd, &fileInfo) != 0 || (size_t)fileInfo.st_size < sizeof(HorizonHeader))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return 0;
+    }
+    header = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED || memcmp(header->magic, HORMAGIC, sizeof(HORMAGIC)) != 0 || header->numBins != HORIZONBINS ||
+        sizeof(HorizonHeader) + (size_t)header->numSites * sizeof(HorizonSite) > (size_t)fileInfo.st_size)
+    {
+        if (header != MAP_FAILED)
+        {
+            munmap((void *)header, fileInfo.st_size);
+        }
+        return 0;
+    }
+    sites = (const HorizonSite *)(header + 1);
+
+    ephs = malloc(numDays * sizeof(DateEphem));
+    out = malloc((size_t)STATSTRIPE * numDays * 3 * sizeof(float));
+    outFile = fopen(outPath, "wb");
+    if (!ephs || !out || !outFile)
+    {
+        free(ephs);
+        free(out);
+        if (outFile)
+        {
+            fclose(outFile);
+        }
+        munmap((void *)header, fileInfo.st_size);
+        return 0;
+    }
+    for (int d = 0; d < numDays; d++)
+    {
+        calcDateEphem(&ephs[d], startJDate + d);
+    }
+
+    for (int siteBegin = 0; siteBegin < (int)header->numSites; siteBegin += STATSTRIPE)
+    {
+        stripeEnd = siteBegin + STATSTRIPE < (int)header->numSites ? siteBegin + STATSTRIPE : (int)header->numSites;
+        OMP(parallel for schedule(dynamic, SITEBLOCK))
+        for (int i = siteBegin; i < stripeEnd; i++)
+        {
+            const HorizonSite *site = &sites[i]; // the site
+            double secLat = 1 / cosd(site->latitude); // 1 / cos(latitude)
+            double tanLat = tand(site->latitude);     // tangent of the latitude
+            double eventTime;                         // event time (decimal day, local solar time)
+            int flat = 1;                             // whether the horizon is the same in every direction
+            double thresholds[3] = {NAN, NAN, NAN};   // each event's threshold on the previous day (deg)
+            float *row;                               // output for one day
+
+            for (int b = 1; b < HORIZONBINS; b++)
+            {
+                flat &= site->elev[b] == site->elev[0];
+            }
+            for (int d = 0; d < numDays; d++)
+            {
+                row = out + ((size_t)(i - siteBegin) * numDays + d) * 3;
+                for (int e = 0; e < 3; e++)
+                {
+                    eventTime = horizonEvent(&ephs[d], site, secLat, tanLat, e + 1, flat, &thresholds[e]);
+                    row[e] = eventTime < -1 ? NAN : (eventTime - site->longitude / (15 * HRSINDAY)) * HRSINDAY * MININHR;
+                }
+            }
+        }
+        fwrite(out, sizeof(float), (size_t)(stripeEnd - siteBegin) * numDays * 3, outFile);
+    }
+
+    free(ephs);
+    free(out);
+    munmap((void *)header, fileInfo.st_size);
+
+    return fclose(outFile) == 0;
+}
+
+// INVERSE QUERY FUNCTIONS
+
+/**
+ * Finds one day's value of a date query's quantity, evaluating it with calcEvent the first time it's needed
+ *
+ *  Inputs:
+ * query: the query
+ * day: day of the query, from 0
+ *
+ *  Output:
+ * Sunrise or sunset (decimal day in the query's time zone) or amount of sunlight (days). NAN if the event doesn't
+ * happen
+ **/
+double dateQuantity(DateQuery *query, int day)
+{
+    double jDate;  // the day
+    double rise;   // sunrise (decimal day)
+    double set;    // sunset (decimal day)
+    int dayStatus; // 1 if it's day for all 24hrs, -1 if it's night for all 24hrs
+
+    if (query->values[day] != INVUNKNOWN)
+    {
+        return query->values[day];
+    }
+
+    jDate = query->startJDate + day;
+    if (query->quantity == INVDAYLEN)
+    {
+        // as stats mode: a day with only a sunrise or only a sunset counts to the end or from the beginning of the day
+        rise = calcEvent(jDate, query->longitude / 15, query->longitude, query->latitude, 1);
+        set = calcEvent(jDate, query->longitude / 15, query->longitude, query->latitude, 3);
+        if (rise < -1 && set < -1)
+        {
+            dayStatus = calcEventApprox(jDate, query->longitude / 15, query->longitude, query->latitude, LOCTIME, 0);
+            query->values[day] = dayStatus == 1 ? 1 : 0;
+        }
+        else
+        {
+            query->values[day] = (set < -1 ? 1 : set) - (rise < -1 ? 0 : rise);
+        }
+    }
+    else
+    {
+        query->values[day] = calcEvent(jDate, query->tZ, query->longitude, query->latitude, query->quantity);
+        if (query->values[day] < -1)
+        {
+            query->values[day] = NAN;
+        }
+    }
+    query->numEvals++;
+
+    return query->values[day];
+}
+
+/**
+ * Checks a value against a query's threshold. A missing value never matches
+ *
+ *  Inputs:
+ * value: the value, NAN if missing
+ * below: 1 to match values below the threshold, 0 above
+ * threshold: value to compare with
+ *
+ *  Output:
+ * 1 if it matches, 0 if not
+ **/
+int quantityMatches(double value, int below, double threshold)
+{
+    return !isnan(value) && (below ? value < threshold : value > threshold);
+}
+
+/**
+ * Finds which way a date query's quantity goes from one day to the next
+ *
+ *  Inputs:
+ * query: the query
+ * day: day of the query, from 0. Must be before the last day
+ *
+ *  Output:
+ * 1 rising, -1 falling, 0 flat, 2 if either value is missing
+ **/
+int dateSlope(DateQuery *query, int day)
+{
+    double diff; // change over the day
+
+    diff = dateQuantity(query, day + 1) - dateQuantity(query, day);
+    if (isnan(diff))
+    {
+        return 2;
+    }
+
+    return (diff > 0) - (diff < 0);
+}
+
+/**
+ * Marks the matching days of a stretch of dates over which the quantity only rises or only falls. The days of each
+ * kind are contiguous, so only the boundary between them needs finding.
+ *
+ *  Inputs:
+ * query: the query
+ * first: first day of the stretch
+ * last: last day of the stretch
+ * matches: each day's match, to fill
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void fillMonotone(DateQuery *query, int first, int last, unsigned char *matches)
+{
+    int firstMatch; // whether the first day matches
+    int lo = first; // last day known to match as the first does
+    int hi = last;  // first day known to match as the last does
+    int mid;        // day being checked
+
+    firstMatch = quantityMatches(dateQuantity(query, first), query->below, query->threshold);
+    if (quantityMatches(dateQuantity(query, last), query->below, query->threshold) == firstMatch)
+    {
+        memset(matches + first, firstMatch, last - first + 1);
+        return;
+    }
+
+    while (hi - lo > 1)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (quantityMatches(dateQuantity(query, mid), query->below, query->threshold) == firstMatch)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    memset(matches + first, firstMatch, lo - first + 1);
+    memset(matches + hi, !firstMatch, last - hi + 1);
+}
+
+/**
+ * Marks the days on which a date query matches. The quantity is sampled every INVSTEP days; a stretch between samples
+ * is split at its turning point if it has one, found by bisecting on the day-to-day slope, and each monotonic part is
+ * bisected for the threshold. Stretches where an event is missing, and sites far enough north or south for a polar
+ * day or night to fall between samples, are checked day by day.
+ *
+ *  Inputs:
+ * query: the query
+ * numDays: number of days
+ * matches: each day's match, to fill
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void fillDateMatches(DateQuery *query, int numDays, unsigned char *matches)
+{
+    int step;     // days between samples
+    int last;     // last day of the current stretch
+    int slopeLo;  // direction at the start of the stretch
+    int slopeHi;  // direction at the end of the stretch
+    int lo, hi;   // days either side of the turning point
+    int mid;      // day being checked
+
+    step = query->quantity != INVDAYLEN && fabs(query->latitude) > INVPOLARLAT ? 1 : INVSTEP;
+    for (int first = 0; first < numDays; first = last + 1)
+    {
+        last = first + step < numDays ? first + step : numDays - 1;
+        if (last - first < 2)
+        {
+            for (int d = first; d <= last; d++)
+            {
+                matches[d] = quantityMatches(dateQuantity(query, d), query->below, query->threshold);
+            }
+            continue;
+        }
+
+        slopeLo = dateSlope(query, first);
+        slopeHi = dateSlope(query, last - 1);
+        if (slopeLo == 2 || slopeHi == 2)
+        {
+            for (int d = first; d <= last; d++)
+            {
+                matches[d] = quantityMatches(dateQuantity(query, d), query->below, query->threshold);
+            }
+        }
+        else if (slopeLo == slopeHi || slopeLo == 0 || slopeHi == 0)
+        {
+            fillMonotone(query, first, last, matches);
+        }
+        else
+        {
+            lo = first;
+            hi = last - 1;
+            while (hi - lo > 1)
+            {
+                mid = lo + (hi - lo) / 2;
+                if (dateSlope(query, mid) == slopeLo)
+                {
+                    lo = mid;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            fillMonotone(query, first, hi, matches);
+            fillMonotone(query, hi, last, matches);
+        }
+    }
+}
+
+/**
+ * Finds a site query's quantity in local solar time for one latitude on one date, with the grid engine
+ *
+ *  Inputs:
+ * eph: the date's ephemeris terms
+ * latitude: North/South component of position
+ * quantity: INVRISE, INVSET, or INVDAYLEN
+ * pointer kind: variable in which to store 0 if every event needed happens, 1 if some do, 2 if none do
+ *
+ *  Output:
+ * Sunrise or sunset (decimal day in local solar time) or amount of sunlight (days). NAN if the event doesn't happen
+ **/
+double siteQuantity(const DateEphem *eph, double latitude, int quantity, int *kind)
+{
+    double secLat; // 1 / cos(latitude)
+    double tanLat; // tangent of the latitude
+    double rise;   // sunrise (decimal day)
+    double set;    // sunset (decimal day)
+
+    secLat = 1 / cosd(latitude);
+    tanLat = tand(latitude);
+    if (quantity != INVDAYLEN)
+    {
+        rise = gridEvent(eph, secLat, tanLat, quantity, NULL);
+        *kind = rise < -1 ? 2 : 0;
+        return rise < -1 ? NAN : rise;
+    }
+
+    rise = gridEvent(eph, secLat, tanLat, 1, NULL);
+    set = gridEvent(eph, secLat, tanLat, 3, NULL);
+    *kind = (rise < -1) + (set < -1);
+    if (rise < -1 && set < -1)
+    {
+        return gridDayStatus(eph, secLat, tanLat) == 1 ? 1 : 0;
+    }
+
+    return (set < -1 ? 1 : set) - (rise < -1 ? 0 : rise);
+}
+
+/**
+ * Orders indexed sites by latitude band, then longitude
+ *
+ *  Inputs:
+ * a: pointer to the first site
+ * b: pointer to the second site
+ *
+ *  Output:
+ * Negative, 0, or positive as for qsort
+ **/
+int compareIndexedSites(const void *a, const void *b)
+{
+    const IndexedSite *siteA = a; // first site
+    const IndexedSite *siteB = b; // second site
+    int bandA;                    // first site's band
+    int bandB;                    // second site's band
+
+    bandA = (int)floor((siteA->latitude + LATRANGE) / INVBANDWIDTH);
+    bandB = (int)floor((siteB->latitude + LATRANGE) / INVBANDWIDTH);
+    if (bandA != bandB)
+    {
+        return bandA - bandB;
+    }
+
+    return (siteA->longitude > siteB->longitude) - (siteA->longitude < siteB->longitude);
+}
+
+/**
+ * Orders integers, for qsort
+ *
+ *  Inputs:
+ * a: pointer to the first integer
+ * b: pointer to the second integer
+ *
+ *  Output:
+ * Negative, 0, or positive as for qsort
+ **/
+int compareInts(const void *a, const void *b)
+{
+    return (*(const int *)a > *(const int *)b) - (*(const int *)a < *(const int *)b);
+}
+
+/**
+ * Reads a site file and indexes it by latitude band and longitude. Each line starts "latitude longitude"; anything
+ * after is ignored, so horizon mode's site files can be used as they are.
+ *
+ *  Inputs:
+ * pointer index: the index to fill
+ * path: site file
+ *
+ *  Output:
+ * 1 if it worked, 0 if not
+ **/
+int loadSiteIndex(SiteIndex *index, const char *path)
+{
+    char line[BUFSIZ * 4];    // input line
+    int capacity = SITEBLOCK; // number of sites there's room for
+    IndexedSite *grown;       // reallocated sites
+    int band;                 // band of a site
+    int lineNum;              // line number
+    FILE *inFile;             // site file
+
+    index->numSites = 0;
+    index->numBands = (int)ceil(2 * LATRANGE / INVBANDWIDTH);
+    index->sites = malloc(capacity * sizeof(IndexedSite));
+    index->bandStart = calloc(index->numBands + 1, sizeof(int));
+    inFile = fopen(path, "r");
+    if (!index->sites || !index->bandStart || !inFile)
+    {
+        if (inFile)
+        {
+            fclose(inFile);
+        }
+        freeSiteIndex(index);
+        return 0;
+    }
+
+    for (lineNum = 0; fgets(line, sizeof(line), inFile); lineNum++)
+    {
+        if (index->numSites == capacity)
+        {
+            capacity *= 2;
+            grown = realloc(index->sites, capacity * sizeof(IndexedSite));
+            if (!grown)
+            {
+                fclose(inFile);
+                freeSiteIndex(index);
+                return 0;
+            }
+            index->sites = grown;
+        }
+        if (sscanf(line, "%lf %lf", &index->sites[index->numSites].latitude, &index->sites[index->numSites].longitude) == 2 &&
+            fabs(index->sites[index->numSites].latitude) < LATRANGE && fabs(index->sites[index->numSites].longitude) < LONGRANGE)
+        {
+            index->sites[index->numSites].id = lineNum;
+            index->numSites++;
+        }
+    }
+    fclose(inFile);
+
+    qsort(index->sites, index->numSites, sizeof(IndexedSite), compareIndexedSites);
+    for (int i = 0; i < index->numSites; i++)
+    {
+        band = (int)floor((index->sites[i].latitude + LATRANGE) / INVBANDWIDTH);
+        index->bandStart[band + 1]++;
+    }
+    for (int b = 0; b < index->numBands; b++)
+    {
+        index->bandStart[b + 1] += index->bandStart[b];
+    }
+
+    return 1;
+}
+
+/**
+ * Frees a site index
+ *
+ *  Inputs:
+ * pointer index: the index
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void freeSiteIndex(SiteIndex *index)
+{
+    free(index->sites);
+    free(index->bandStart);
+    index->sites = NULL;
+    index->bandStart = NULL;
+    index->numSites = 0;
+}
+
+/**
+ * Finds the first site of part of a band that is east of a longitude
+ *
+ *  Inputs:
+ * index: the index
+ * begin: first site of the part
+ * end: one past the last site of the part
+ * longitude: the longitude
+ *
+ *  Output:
+ * Index of the first site east of the longitude, end if there isn't one
+ **/
+int firstLonAbove(const SiteIndex *index, int begin, int end, double longitude)
+{
+    int mid; // site being checked
+
+    while (begin < end)
+    {
+        mid = begin + (end - begin) / 2;
+        if (index->sites[mid].longitude > longitude)
+        {
+            end = mid;
+        }
+        else
+        {
+            begin = mid + 1;
+        }
+    }
+
+    return begin;
+}
+
+/**
+ * Finds the indexed sites that match a query on one date. Within a latitude band, the local solar time of sunrise or
+ * sunset only moves between its values at the band's edges (plus INVPAD), and the clock time then falls steadily
+ * with longitude, so two binary searches split the band into sites that certainly match, certainly don't, and a
+ * narrow strip that is calculated. Sunlight doesn't depend on longitude, so whole bands are decided at once. A band
+ * with no events at either edge is in a polar day or night throughout; a band whose edges differ in which events
+ * happen is calculated site by site.
+ *
+ *  Inputs:
+ * index: the index
+ * eph: the date's ephemeris terms
+ * quantity: INVRISE, INVSET, or INVDAYLEN
+ * below: 1 to match values below the threshold, 0 above
+ * threshold: value to compare with (decimal day, in the time zone for sunrise and sunset)
+ * tZ: time zone in UTC offset
+ * matches: array of at least numSites entries in which to store the matching sites' ids, in order
+ * pointer numEvals: variable to add the number of sites calculated to
+ *
+ *  Output:
+ * Number of matching sites
+ **/
+int querySiteIndex(const SiteIndex *index, const DateEphem *eph, int quantity, int below, double threshold, double tZ,
+                   int *matches, int *numEvals)
+{
+    int numMatches = 0; // number of matching sites
+    int begin, end;     // the band's sites
+    double edgeLo;      // quantity at the band's southern edge
+    double edgeHi;      // quantity at the band's northern edge
+    int kindLo;         // which events happen at the band's southern edge
+    int kindHi;         // which events happen at the band's northern edge
+    double valueLo;     // least the quantity can be in the band (local solar time)
+    double valueHi;     // most the quantity can be in the band (local solar time)
+    double offset;      // clock time minus local solar time, without the longitude (decimal day)
+    int sureBegin;      // first site that certainly matches
+    int sureEnd;        // one past the last site that certainly matches
+    int evalBegin;      // first site to calculate
+    int evalEnd;        // one past the last site to calculate
+    double value;       // a calculated site's value
+    int kind;           // which events happen at a calculated site
+
+    offset = quantity == INVDAYLEN ? 0 : tZ / HRSINDAY;
+    for (int b = 0; b < index->numBands; b++)
+    {
+        begin = index->bandStart[b];
+        end = index->bandStart[b + 1];
+        if (begin == end)
+        {
+            continue;
+        }
+
+        edgeLo = siteQuantity(eph, fmax(-LATRANGE + b * INVBANDWIDTH, -LATRANGE + INVBANDWIDTH / 100), quantity, &kindLo);
+        edgeHi = siteQuantity(eph, fmin(-LATRANGE + (b + 1) * INVBANDWIDTH, LATRANGE - INVBANDWIDTH / 100), quantity, &kindHi);
+        valueLo = fmin(edgeLo, edgeHi) - INVPAD;
+        valueHi = fmax(edgeLo, edgeHi) + INVPAD;
+
+        sureBegin = sureEnd = evalBegin = begin;
+        evalEnd = end;
+        if (kindLo != kindHi || kindLo == 1 || (kindLo == 2 && quantity == INVDAYLEN && edgeLo != edgeHi))
+        {
+            // no bounds: everything is calculated
+        }
+        else if (kindLo == 2 && quantity != INVDAYLEN)
+        {
+            evalBegin = evalEnd = end;
+        }
+        else if (quantity == INVDAYLEN)
+        {
+            if (quantityMatches(valueLo, below, threshold) && quantityMatches(valueHi, below, threshold))
+            {
+                sureEnd = end;
+                evalBegin = evalEnd = end;
+            }
+            else if (!quantityMatches(valueLo, below, threshold) && !quantityMatches(valueHi, below, threshold))
+            {
+                evalBegin = evalEnd = end;
+            }
+        }
+        else if (below)
+        {
+            // clock time is value + offset - longitude / 360: east of (valueHi + offset - threshold) * 360 it's
+            // certainly early enough, and west of (valueLo + offset - threshold) * 360 it certainly isn't
+            evalBegin = firstLonAbove(index, begin, end, (valueLo + offset - threshold) * 360);
+            evalEnd = sureBegin = firstLonAbove(index, evalBegin, end, (valueHi + offset - threshold) * 360);
+            sureEnd = end;
+        }
+        else
+        {
+            sureEnd = evalBegin = firstLonAbove(index, begin, end, (valueLo + offset - threshold) * 360);
+            evalEnd = firstLonAbove(index, evalBegin, end, (valueHi + offset - threshold) * 360);
+        }
+
+        for (int i = sureBegin; i < sureEnd; i++)
+        {
+            matches[numMatches++] = index->sites[i].id;
+        }
+        for (int i = evalBegin; i < evalEnd; i++)
+        {
+            value = siteQuantity(eph, index->sites[i].latitude, quantity, &kind);
+            if (quantity != INVDAYLEN)
+            {
+                value += offset - index->sites[i].longitude / 360;
+            }
+            if (quantityMatches(value, below, threshold))
+            {
+                matches[numMatches++] = index->sites[i].id;
+            }
+        }
+        *numEvals += evalEnd - evalBegin;
+    }
+    qsort(matches, numMatches, sizeof(int), compareInts);
+
+    return numMatches;
+}
+
+// ACCURACY FUNCTIONS
+
+/**
+ * As calcSunPos, in long double. The reference for the accuracy harness: the same formulas, with rounding error far
+ * below anything the engines could show.
+ *
+ *  Inputs:
+ * jDate: Julian date (fractional days allowed)
+ * pointer sunDeclin: variable in which to store the sun's declination (deg)
+ * pointer eqOfTime: variable in which to store the equation of time (minutes)
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void calcSunPosRef(long double jDate, long double *sunDeclin, long double *eqOfTime)
+{
+    const long double degToRad = 3.141592653589793238462643383279502884L / 180; // radians per degree
+    long double geomMeanLongSun;  // Geometric mean longitude (L0) of the sun
+    long double geomMeanAnomSun;  // Geometric mean anomaly of the sun
+    long double eccentEarthOrbit; // Earth orbit eccentricity
+    long double sunEqCtr;         // Sun's equation of center
+    long double sunAppLong;       // Apparent Longitude of the sun
+    long double meanObliqEclip;   // Mean inclination of Earth's equator relative to the ecliptic
+    long double obliqCorr;        // Oblique ecliptic corrected
+    long double varY;             // tan^2(obliqCorr / 2)
+    long double jCent;            // Julian century
+
+    jCent = ((jDate - JDATE2000 - 1) / JULCENTURY);
+    geomMeanLongSun = fmodl(280.46646L + jCent * (36000.76983L + jCent * 0.0003032L), 360);
+    geomMeanAnomSun = 357.52911L + jCent * (35999.05029L - 0.0001537L * jCent);
+    eccentEarthOrbit = 0.016708634L - jCent * (0.000042037L + 0.0000001267L * jCent);
+    sunEqCtr = sinl(degToRad * geomMeanAnomSun) * (1.914602L - jCent * (0.004817L + 0.000014L * jCent)) +
+               sinl(degToRad * 2 * geomMeanAnomSun) * (0.019993L - 0.000101L * jCent) + sinl(degToRad * 3 * geomMeanAnomSun) * 0.000289L;
+    sunAppLong = geomMeanLongSun + sunEqCtr - 0.00569L - 0.00478L * sinl(degToRad * (125.04L - 1934.136L * jCent));
+    meanObliqEclip = (HRSINDAY - 1) + (26 + ((21.448L - jCent * (46.815L + jCent * (0.00059L - jCent * 0.001813L)))) / MININHR) / MININHR;
+    obliqCorr = meanObliqEclip + 0.00256L * cosl(degToRad * (125.04L - 1934.136L * jCent));
+    *sunDeclin = asinl(sinl(degToRad * obliqCorr) * sinl(degToRad * sunAppLong)) / degToRad;
+    varY = tanl(degToRad * obliqCorr / 2) * tanl(degToRad * obliqCorr / 2);
+    *eqOfTime = 4 / degToRad * (varY * sinl(degToRad * 2 * geomMeanLongSun) - 2 * eccentEarthOrbit * sinl(degToRad * geomMeanAnomSun) +
+                4 * eccentEarthOrbit * varY * sinl(degToRad * geomMeanAnomSun) * cosl(degToRad * 2 * geomMeanLongSun) -
+                0.5L * varY * varY * sinl(degToRad * 4 * geomMeanLongSun) -
+                1.25L * eccentEarthOrbit * eccentEarthOrbit * sinl(degToRad * 2 * geomMeanAnomSun));
+}
+
+/**
+ * As calcEvent in local solar time, in long double, with calcEventApprox's fixed point iterated to convergence
+ * rather than to the nearest minute
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ * event: 1 sunrise, 2 solar noon, 3 sunset
+ *
+ *  Output:
+ * Decimal day of the event in local solar time. Less than -1 means it doesn't happen
+ **/
+long double calcEventRef(long double jDate, long double longitude, long double latitude, int event)
+{
+    const long double degToRad = 3.141592653589793238462643383279502884L / 180; // radians per degree
+    long double sunDeclin; // Sun's declination (deg)
+    long double eqOfTime;  // equation of time (minutes)
+    long double funcArg;   // argument of arccosine
+    long double ans[2];    // answers from the beginning and end of the day
+    long double prev;      // answer from the previous iteration
+
+    (void)longitude; // local solar time: calcEventApprox's longitude and time zone terms cancel
+    for (int pass = 0; pass < 2; pass++)
+    {
+        ans[pass] = pass == 0 ? BEGINDAY : ENDDAY;
+        for (int iter = 0; iter < MAXREFITER; iter++)
+        {
+            prev = ans[pass];
+            calcSunPosRef(jDate + prev, &sunDeclin, &eqOfTime);
+            funcArg = sinl(degToRad * TWILIGHTANGLE) / (cosl(degToRad * latitude) * cosl(degToRad * sunDeclin)) -
+                      tanl(degToRad * latitude) * tanl(degToRad * sunDeclin);
+            if (fabsl(funcArg) > 1)
+            {
+                ans[pass] = -100;
+                break;
+            }
+            ans[pass] = (720 - eqOfTime) / (HRSINDAY * MININHR);
+            ans[pass] += (event - 2) * acosl(funcArg) / degToRad * 4 / (HRSINDAY * MININHR);
+            if (ans[pass] < -1 || ans[pass] > 2 || fabsl(ans[pass] - prev) < REFTOL)
+            {
+                break;
+            }
+        }
+    }
+
+    return fmaxl(ans[0], ans[1]);
+}
+
+/**
+ * Calculates every site-day's sunrise, solar noon, and sunset with one engine, in local solar time
+ *
+ *  Inputs:
+ * engine: ENGCALCEVENT, ENGENUM, ENGGRID, ENGFLOAT32, ENGHORIZON, or ENGSPAN
+ * sites: the sites
+ * ephs: per-date terms
+ * startJDate: Julian date of the first day
+ * numDays: number of days
+ * ref: the reference events, for picking which of several sunrises or sunsets the enumerator's is
+ * out: array of numSites * numDays * 3 to fill, [site][day][event], NAN where the event doesn't happen
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void engineEvents(int engine, const SiteArrays *sites, const DateEphem *ephs, double startJDate, int numDays,
+                  const double *ref, double *out)
+{
+    SolarEvent events[MAXDAYEVENTS]; // the enumerator's events
+    int numEvents;                   // number of the enumerator's events
+    int sunUp;                       // whether the sun is up at the beginning of the day
+    HorizonSite flatSite;            // a site with a flat horizon at sea level
+    double thresholds[3];            // horizonEvent's thresholds
+    double value;                    // an event (decimal day)
+    double *row;                     // one site-day's events
+    const double *refRow;            // one site-day's reference events
+    SpanLanes lanes;                 // lanes of the time-major calcEvent kernel
+    double spanTimes[3][SPANBLOCK];  // the kernel's events for a block of days
+
+    memset(&flatSite, 0, sizeof(flatSite));
+    initSpanLanes(&lanes);
+    for (int i = 0; i < sites->numSites; i++)
+    {
+        flatSite.latitude = sites->latitude[i];
+        thresholds[0] = thresholds[1] = thresholds[2] = NAN;
+        for (int d = 0; d < numDays; d++)
+        {
+            row = out + ((size_t)i * numDays + d) * 3;
+            refRow = ref + ((size_t)i * numDays + d) * 3;
+            switch (engine)
+            {
+            case ENGCALCEVENT:
+                for (int e = 0; e < 3; e++)
+                {
+                    value = calcEvent(startJDate + d, sites->longitude[i] / 15, sites->longitude[i], sites->latitude[i], e + 1);
+                    row[e] = value < -1 ? NAN : value;
+                }
+                break;
+            case ENGENUM:
+                numEvents = calcDayEvents(startJDate + d, sites->longitude[i] / 15, sites->longitude[i], sites->latitude[i], events, &sunUp);
+                row[0] = row[1] = row[2] = NAN;
+                for (int k = 0; k < numEvents; k++)
+                {
+                    value = row[events[k].type - 1];
+                    if (isnan(value) || fabs(events[k].time - refRow[events[k].type - 1]) < fabs(value - refRow[events[k].type - 1]))
+                    {
+                        row[events[k].type - 1] = events[k].time;
+                    }
+                }
+                break;
+            case ENGGRID:
+            case ENGFLOAT32:
+                for (int e = 0; e < 3; e++)
+                {
+                    value = gridEvent(&ephs[d], sites->secLat[i], sites->tanLat[i], e + 1, NULL);
+                    row[e] = value < -1 ? NAN : value;
+                    if (engine == ENGFLOAT32 && value >= -1)
+                    {
+                        // round trip through grid mode's output: float32 UTC minutes
+                        row[e] = (float)((value - sites->longitude[i] / 360) * HRSINDAY * MININHR) / (HRSINDAY * MININHR) +
+                                 sites->longitude[i] / 360;
+                    }
+                }
+                break;
+            case ENGHORIZON:
+                for (int e = 0; e < 3; e++)
+                {
+                    value = horizonEvent(&ephs[d], &flatSite, sites->secLat[i], sites->tanLat[i], e + 1, 1, &thresholds[e]);
+                    row[e] = value < -1 ? NAN : value;
+                }
+                break;
+            case ENGSPAN:
+                for (int e = 0; e < 3; e++)
+                {
+                    if (d % SPANBLOCK == 0)
+                    {
+                        calcEventSpan(&lanes, startJDate + d, numDays - d < SPANBLOCK ? numDays - d : SPANBLOCK,
+                                      sites->longitude[i] / 15, sites->longitude[i], sites->latitude[i], e + 1, spanTimes[e]);
+                    }
+                    value = spanTimes[e][d % SPANBLOCK];
+                    row[e] = value < -1 ? NAN : value;
+                }
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Orders floats, for qsort
+ *
+ *  Inputs:
+ * a: pointer to the first float
+ * b: pointer to the second float
+ *
+ *  Output:
+ * Negative, 0, or positive as for qsort
+ **/
+int compareFloats(const void *a, const void *b)
+{
+    return (*(const float *)a > *(const float *)b) - (*(const float *)a < *(const float *)b);
+}
+
+/**
+ * Finds the time since a starting point
+ *
+ *  Inputs:
+ * start: the starting point, from clock_gettime(CLOCK_MONOTONIC)
+ *
+ *  Output:
+ * Seconds since the start
+ **/
+double elapsedSec(const struct timespec *start)
+{
+    struct timespec now; // current time
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// SUNRISE TABLE FUNCTIONS
+
+/**
+ * Maps a signed integer to an unsigned one so that small magnitudes of either sign stay small: 0, -1, 1, -2, ...
+ * become 0, 1, 2, 3, ...
+ *
+ *  Inputs:
+ * value: the integer
+ *
+ *  Output:
+ * The zig-zag encoded integer
+ **/
+uint32_t zigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)-(value < 0);
+}
+
+/**
+ * Reverses zigZag
+ *
+ *  Inputs:
+ * code: the zig-zag encoded integer
+ *
+ *  Output:
+ * The integer
+ **/
+int32_t unZigZag(uint32_t code)
+{
+    return (int32_t)(code >> 1) ^ -(int32_t)(code & 1);
+}
+
+/**
+ * Appends a value to a bit stream, least significant bit first. The buffer must start zeroed
+ *
+ *  Inputs:
+ * buf: the stream
+ * pointer bitPos: position to write at (bits), advanced past the value
+ * value: the value
+ * width: number of bits to write
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void putBits(uint8_t *buf, size_t *bitPos, uint32_t value, int width)
+{
+    for (int i = 0; i < width; i++, (*bitPos)++)
+    {
+        buf[*bitPos >> 3] |= ((value >> i) & 1) << (*bitPos & 7);
+    }
+}
+
+/**
+ * Reads a value from a bit stream written by putBits
+ *
+ *  Inputs:
+ * buf: the stream
+ * bitPos: position of the value (bits)
+ * width: number of bits
+ *
+ *  Output:
+ * The value
+ **/
+uint32_t getBits(const uint8_t *buf, size_t bitPos, int width)
+{
+    uint32_t value = 0; // the value
+
+    for (int i = 0; i < width; i++, bitPos++)
+    {
+        value |= (uint32_t)((buf[bitPos >> 3] >> (bitPos & 7)) & 1) << i;
+    }
+
+    return value;
+}
+
+/**
+ * Rounds a day's sunrise or sunset to what a table stores: calcEvent's time rounded to the minute as batch mode prints
+ * it, in minutes after midnight
+ *
+ *  Inputs:
+ * eventTime: the event as calcEvent returns it
+ *
+ *  Output:
+ * Minutes after midnight, or TABLENONE if the event doesn't happen
+ **/
+int tableMinute(double eventTime)
+{
+    int minute; // the event (minutes)
+
+    if (eventTime < -1)
+    {
+        return TABLENONE;
+    }
+    minute = (int)round(eventTime * HRSINDAY * MININHR) % (HRSINDAY * MININHR);
+
+    return minute < 0 ? minute + HRSINDAY * MININHR : minute;
+}
+
+/**
+ * Encodes a site's sunrises and sunsets. Days are in blocks of TABLEBLOCK. The table starts with each block's byte
+ * offset (uint16, little endian). Each block has a 32 bit header: the first day's sunrise and sunset (TABLEANCHORBITS
+ * each), then the bit widths of the two delta streams (TABLEWIDTHBITS each). The rest of the block's days follow as
+ * zig-zag encoded day-to-day changes, first the sunrises and then the sunsets, each stream as narrow as its largest
+ * change allows. Any day can then be decoded from its block's anchor with at most TABLEBLOCK - 1 additions.
+ *
+ *  Inputs:
+ * rise: each day's sunrise (minutes, or TABLENONE)
+ * set: each day's sunset (minutes, or TABLENONE)
+ * numDays: number of days
+ * out: buffer to write to, zeroed, big enough for the worst case
+ *
+ *  Output:
+ * Size of the table (bytes). 0 if a block starts past where a uint16 offset can point (64 KB)
+ **/
+size_t encodeSunTable(const int16_t *rise, const int16_t *set, int numDays, uint8_t *out)
+{
+    const int16_t *events[2] = {rise, set}; // the two streams
+    int numBlocks;                          // number of blocks
+    size_t bitPos;                          // write position (bits)
+    int width[2];                           // bit width of each stream's changes in the current block
+    uint32_t header;                        // the current block's header
+    int first;                              // first day of the current block
+    int last;                               // one past the last day of the current block
+
+    numBlocks = (numDays + TABLEBLOCK - 1) / TABLEBLOCK;
+    bitPos = (size_t)numBlocks * 2 * 8;
+    for (int b = 0; b < numBlocks; b++)
+    {
+        first = b * TABLEBLOCK;
+        last = first + TABLEBLOCK < numDays ? first + TABLEBLOCK : numDays;
+        bitPos = (bitPos + 7) & ~(size_t)7;
+        if (bitPos / 8 > UINT16_MAX)
+        {
+            return 0;
+        }
+        out[2 * b] = (bitPos / 8) & 0xFF;
+        out[2 * b + 1] = (bitPos / 8) >> 8;
+
+        for (int e = 0; e < 2; e++)
+        {
+            width[e] = 0;
+            for (int d = first + 1; d < last; d++)
+            {
+                while (zigZag(events[e][d] - events[e][d - 1]) >> width[e])
+                {
+                    width[e]++;
+                }
+            }
+        }
+        header = events[0][first] | (uint32_t)events[1][first] << TABLEANCHORBITS |
+                 (uint32_t)width[0] << (2 * TABLEANCHORBITS) | (uint32_t)width[1] << (2 * TABLEANCHORBITS + TABLEWIDTHBITS);
+        putBits(out, &bitPos, header, 8 * TABLEHEADER);
+        for (int e = 0; e < 2; e++)
+        {
+            for (int d = first + 1; d < last; d++)
+            {
+                putBits(out, &bitPos, zigZag(events[e][d] - events[e][d - 1]), width[e]);
+            }
+            // a short last block is padded, so the sunset stream is always where the decoder expects it
+            bitPos += (size_t)width[e] * (TABLEBLOCK - (last - first));
+        }
+    }
+
+    return (bitPos + 7) / 8;
+}
+
+/**
+ * Decodes one day of a table written by encodeSunTable. The same algorithm as the decoder writeSunDecoder emits
+ *
+ *  Inputs:
+ * table: the table
+ * day: day of the table, from 0
+ * event: 0 sunrise, 1 sunset
+ *
+ *  Output:
+ * Minutes after midnight, or TABLENONE if the event doesn't happen
+ **/
+int decodeSunTable(const uint8_t *table, int day, int event)
+{
+    const uint8_t *block; // the day's block
+    uint32_t header;      // the block's header
+    int width;            // bit width of the event's changes
+    int value;            // the event on the current day
+    size_t bitPos;        // read position (bits)
+
+    block = table + (table[2 * (day / TABLEBLOCK)] | table[2 * (day / TABLEBLOCK) + 1] << 8);
+    header = getBits(block, 0, 8 * TABLEHEADER);
+    value = (header >> (event * TABLEANCHORBITS)) & ((1 << TABLEANCHORBITS) - 1);
+    width = (header >> (2 * TABLEANCHORBITS + event * TABLEWIDTHBITS)) & ((1 << TABLEWIDTHBITS) - 1);
+    // the sunset stream follows the block's sunrise stream, whose width and length are known
+    bitPos = 8 * TABLEHEADER + event * (size_t)((header >> (2 * TABLEANCHORBITS)) & ((1 << TABLEWIDTHBITS) - 1)) * (TABLEBLOCK - 1);
+    for (int k = 0; k < day % TABLEBLOCK; k++, bitPos += width)
+    {
+        value += unZigZag(getBits(block, bitPos, width));
+    }
+
+    return value;
+}
+
+/**
+ * Writes the C decoder for the tables: plain integer C with no library calls, for small devices
+ *
+ *  Inputs:
+ * outFile: file to write to
+ *
+ *  Output:
+ * None
+ **/
+void writeSunDecoder(FILE *outFile)
+{
+    fputs("#include <stdint.h>\n"
+          "\n"
+          "// one site's sunrises and sunsets: every day from January 1 of firstYear, in minutes after local midnight\n"
+          "typedef struct\n"
+          "{\n"
+          "    int16_t firstYear;   // year the table starts\n"
+          "    uint16_t numDays;    // number of days\n"
+          "    const uint8_t *data; // block offsets, then blocks of 32 days\n"
+          "} SunTable;\n"
+          "\n"
+          "/**\n"
+          " * Counts days from 1 March of year 0 to a date of the Gregorian calendar\n"
+          " **/\n"
+          "static int32_t sunCivilDays(int32_t year, int month, int day)\n"
+          "{\n"
+          "    int32_t era;     // 400 year cycle\n"
+          "    uint32_t yoe;    // year of the cycle\n"
+          "    uint32_t doy;    // day of the year, from 1 March\n"
+          "\n"
+          "    year -= month <= 2;\n"
+          "    era = (year >= 0 ? year : year - 399) / 400;\n"
+          "    yoe = (uint32_t)(year - era * 400);\n"
+          "    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;\n"
+          "\n"
+          "    return era * 146097 + (int32_t)(yoe * 365 + yoe / 4 - yoe / 100 + doy);\n"
+          "}\n"
+          "\n"
+          "/**\n"
+          " * Finds a date's sunrise or sunset. Constant time: one block lookup and at most 31 additions\n"
+          " *\n"
+          " *  Inputs:\n"
+          " * table: the site's table\n"
+          " * year, month, day: the date\n"
+          " * event: 0 sunrise, 1 sunset\n"
+          " *\n"
+          " *  Output:\n"
+          " * Minutes after local midnight. -1 if the event doesn't happen, -2 if the date isn't in the table\n"
+          " **/\n"
+          "static int sunTableGet(const SunTable *table, int year, int month, int day, int event)\n"
+          "{\n"
+          "    const uint8_t *block; // the date's block\n"
+          "    uint32_t header;      // the block's anchors and widths\n"
+          "    uint32_t bitPos;      // read position (bits)\n"
+          "    uint32_t code;        // a zig-zag encoded change\n"
+          "    int32_t index;        // day of the table\n"
+          "    int width;            // bit width of the event's changes\n"
+          "    int value;            // the event on the current day\n"
+          "\n"
+          "    index = sunCivilDays(year, month, day) - sunCivilDays(table->firstYear, 1, 1);\n"
+          "    if (index < 0 || index >= table->numDays)\n"
+          "    {\n"
+          "        return -2;\n"
+          "    }\n"
+          "\n"
+          "    block = table->data + (table->data[2 * (index / 32)] | table->data[2 * (index / 32) + 1] << 8);\n"
+          "    header = block[0] | (uint32_t)block[1] << 8 | (uint32_t)block[2] << 16 | (uint32_t)block[3] << 24;\n"
+          "    value = (header >> (event * 11)) & 0x7FF;\n"
+          "    width = (header >> (22 + event * 4)) & 0xF;\n"
+          "    bitPos = 32 + event * ((header >> 22) & 0xF) * 31;\n"
+          "    for (int k = 0; k < index % 32; k++)\n"
+          "    {\n"
+          "        code = 0;\n"
+          "        for (int i = 0; i < width; i++, bitPos++)\n"
+          "        {\n"
+          "            code |= (uint32_t)((block[bitPos >> 3] >> (bitPos & 7)) & 1) << i;\n"
+          "        }\n"
+          "        value += (int)(code >> 1) ^ -(int)(code & 1);\n"
+          "    }\n"
+          "\n"
+          "    return value == 0x7FF ? -1 : value;\n"
+          "}\n",
+          outFile);
+}
+
+/**
+ * Writes a C header with a sunrise/sunset table for each site of a file and the decoder for them. The minutes come
+ * from calcEventSpan, and every day is checked against calcEvent's minute before its site's table is written. Every
+ * day of every table is also checked to decode to the minute it was built from. Each site line is "latitude
+ * longitude timezone". Failures are reported on stderr, and the header is removed.
+ *
+ *  Inputs:
+ * sitesPath: site file
+ * firstYear: first year of the tables
+ * numYears: number of years
+ * outPath: header to write
+ *
+ *  Output:
+ * 1 if it worked, 0 if not
+ **/
+int writeSunTables(const char *sitesPath, int firstYear, int numYears, const char *outPath)
+{
+    char line[BUFSIZ];            // input line
+    double latitude;              // site latitude
+    double longitude;             // site longitude
+    double timeZone;              // site time zone in UTC offset
+    int numDays;                  // days in the tables
+    int16_t *rise;                // each day's sunrise (minutes)
+    int16_t *set;                 // each day's sunset (minutes)
+    uint8_t *table;               // the encoded table
+    size_t tableSize;             // size of the table (bytes)
+    size_t maxSize;               // size of the largest possible table (bytes)
+    size_t totalSize = 0;         // size of all the tables (bytes)
+    int numSites = 0;             // number of sites
+    int mismatches = 0;           // decoded days that differ from the minutes encoded
+    int calcMismatches;           // days at the current site whose minutes differ from calcEvent's
+    int ok = 1;                   // whether every table was encoded
+    double startJDate;            // first day at the current site
+    SpanLanes lanes;              // lanes of the time-major calcEvent kernel
+    double riseTimes[SPANBLOCK];  // a block of days' sunrises, as calcEvent returns them
+    double setTimes[SPANBLOCK];   // a block of days' sunsets, as calcEvent returns them
+    int numBlock;                 // days in the block
+    FILE *inFile;                 // site file
+    FILE *outFile;                // header
+
+    initSpanLanes(&lanes);
+    numDays = 0;
+    for (int y = firstYear; y < firstYear + numYears; y++)
+    {
+        numDays += DAYSINYEAR + isLeapYear(y);
+    }
+    if (numDays > UINT16_MAX)
+    {
+        fprintf(stderr, "%d days don't fit in a table's uint16 day count; use fewer years\n", numDays);
+        return 0;
+    }
+    maxSize = (size_t)(numDays / TABLEBLOCK + 1) * (2 + TABLEHEADER + 2 * (TABLEBLOCK - 1) * 2);
+    rise = malloc(numDays * sizeof(int16_t));
+    set = malloc(numDays * sizeof(int16_t));
+    table = malloc(maxSize);
+    inFile = fopen(sitesPath, "r");
+    outFile = inFile ? fopen(outPath, "w") : NULL;
+    if (!rise || !set || !table || !inFile || !outFile)
+    {
+        if (!rise || !set || !table)
+        {
+            fprintf(stderr, "Out of memory\n");
+        }
+        else
+        {
+            fprintf(stderr, "Couldn't %s %s\n", inFile ? "write" : "read", inFile ? outPath : sitesPath);
+        }
+        free(rise);
+        free(set);
+        free(table);
+        if (inFile)
+        {
+            fclose(inFile);
+        }
+        if (outFile)
+        {
+            fclose(outFile);
+            remove(outPath);
+        }
+        return 0;
+    }
+
+    fprintf(outFile, "// Sunrise and sunset tables for %d to %d, generated by solarCalc table\n\n", firstYear, firstYear + numYears - 1);
+    writeSunDecoder(outFile);
+    while (fgets(line, sizeof(line), inFile))
+    {
+        if (sscanf(line, "%lf %lf %lf", &latitude, &longitude, &timeZone) != 3 ||
+            fabs(latitude) >= LATRANGE || fabs(longitude) >= LONGRANGE || fabs(timeZone) > 13)
+        {
+            continue;
+        }
+
+        startJDate = calcJDate(1, JAN, firstYear, timeZone);
+        calcMismatches = 0;
+        for (int first = 0; first < numDays; first += SPANBLOCK)
+        {
+            numBlock = numDays - first < SPANBLOCK ? numDays - first : SPANBLOCK;
+            calcEventSpan(&lanes, startJDate + first, numBlock, timeZone, longitude, latitude, 1, riseTimes);
+            calcEventSpan(&lanes, startJDate + first, numBlock, timeZone, longitude, latitude, 3, setTimes);
+            for (int d = 0; d < numBlock; d++)
+            {
+                rise[first + d] = tableMinute(riseTimes[d]);
+                set[first + d] = tableMinute(setTimes[d]);
+                calcMismatches += rise[first + d] != tableMinute(calcEvent(startJDate + first + d, timeZone, longitude, latitude, 1)) ||
+                                  set[first + d] != tableMinute(calcEvent(startJDate + first + d, timeZone, longitude, latitude, 3));
+            }
+        }
+        if (calcMismatches > 0)
+        {
+            fprintf(stderr, "%d of %d days at %g, %g differ from calcEvent\n", calcMismatches, numDays, latitude, longitude);
+            ok = 0;
+            break;
+        }
+        memset(table, 0, maxSize);
+        tableSize = encodeSunTable(rise, set, numDays, table);
+        if (tableSize == 0)
+        {
+            fprintf(stderr, "The table for %g, %g is over the 64 KB its block offsets can address; use fewer years\n",
+                    latitude, longitude);
+            ok = 0;
+            break;
+        }
+        for (int d = 0; d < numDays; d++)
+        {
+            mismatches += decodeSunTable(table, d, 0) != rise[d] || decodeSunTable(table, d, 1) != set[d];
+        }
+
+        fprintf(outFile, "\n// %g, %g, UTC%+g: %zu bytes\nstatic const uint8_t sunData%d[%zu] = {", latitude, longitude,
+                timeZone, tableSize, numSites, tableSize);
+        for (size_t i = 0; i < tableSize; i++)
+        {
+            fprintf(outFile, "%s0x%02X%s", i % TABLELINE == 0 ? "\n    " : "", table[i], i + 1 < tableSize ? "," : "");
+        }
+        fprintf(outFile, "\n};\n");
+        totalSize += tableSize;
+        numSites++;
+    }
+
+    fprintf(outFile, "\nstatic const SunTable sunTables[%d] = {", numSites > 0 ? numSites : 1);
+    for (int i = 0; i < numSites; i++)
+    {
+        fprintf(outFile, "%s\n    {%d, %d, sunData%d}", i > 0 ? "," : "", firstYear, numDays, i);
+    }
+    fprintf(outFile, "\n};\n");
+    fprintf(stderr, "%d sites, %zu bytes, %.1f bytes per site-year, %d mismatched days\n", numSites, totalSize,
+            numSites > 0 ? (double)totalSize / numSites / numYears : 0.0, mismatches);
+
+    free(rise);
+    free(set);
+    free(table);
+    fclose(inFile);
+    if (fclose(outFile) != 0 && ok)
+    {
+        fprintf(stderr, "Couldn't write %s\n", outPath);
+        ok = 0;
+    }
+    if (ok && mismatches > 0)
+    {
+        fprintf(stderr, "Not every day decoded exactly\n");
+        ok = 0;
+    }
+    if (!ok)
+    {
+        remove(outPath);
+    }
+
+    return ok;
+}
+
+// SOLVER FUZZING FUNCTIONS
+
+/**
+ * Picks a uniformly distributed random number
+ *
+ *  Inputs:
+ * lo: least value
+ * hi: greatest value
+ *
+ *  Output:
+ * A random number in [lo, hi]
+ **/
+double fuzzRandom(double lo, double hi)
+{
+    return lo + (hi - lo) * rand() / RAND_MAX;
+}
+
+/**
+ * Runs a fuzz case's solver and records how many fixed point iterations it took
+ *
+ *  Inputs:
+ * pointer fuzzCase: the case
+ *
+ *  Output:
+ * Number of calcEventApprox calls
+ **/
+int fuzzCost(FuzzCase *fuzzCase)
+{
+    fuzzCase->iters = 0;
+    if (fuzzCase->solver == FUZZEVENT)
+    {
+        calcEventIters(fuzzCase->jDate, 0, fuzzCase->longitude, fuzzCase->latitude, fuzzCase->option, &fuzzCase->iters);
+    }
+    else
+    {
+        calcEventDayIters(fuzzCase->longitude, fuzzCase->latitude, 0, fuzzCase->jDate, fuzzCase->option, &fuzzCase->iters, NULL);
+    }
+
+    return fuzzCase->iters;
+}
+
+/**
+ * Makes a random input anywhere getCoords accepts, on a day between FUZZFIRSTYEAR and FUZZYEARS later
+ *
+ *  Inputs:
+ * pointer fuzzCase: the case to fill
+ * solver: FUZZEVENT or FUZZDAY
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void randomCase(FuzzCase *fuzzCase, int solver)
+{
+    static const int dayOptions[4] = {-3, -1, 1, 3}; // calcEventDay's options
+
+    fuzzCase->solver = solver;
+    fuzzCase->latitude = fuzzRandom(-LATRANGE, LATRANGE) * (1 - 1e-9);
+    fuzzCase->longitude = fuzzRandom(-LONGRANGE, LONGRANGE) * (1 - 1e-9);
+    fuzzCase->jDate = calcJDate(1, JAN, FUZZFIRSTYEAR, 0) + rand() % (FUZZYEARS * DAYSINYEAR);
+    fuzzCase->option = solver == FUZZEVENT ? 1 + rand() % 3 : dayOptions[rand() % 4];
+    fuzzCase->nsPerCall = 0;
+    fuzzCost(fuzzCase);
+}
+
+/**
+ * Makes a nearby input: the position moves by up to scale degrees, and at coarse scales the date by a few days
+ *
+ *  Inputs:
+ * pointer dst: the case to fill
+ * src: the case to start from
+ * scale: largest move (deg)
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void mutateCase(FuzzCase *dst, const FuzzCase *src, double scale)
+{
+    *dst = *src;
+    dst->latitude = fmax(-LATRANGE, fmin(LATRANGE, src->latitude + fuzzRandom(-scale, scale))) * (1 - 1e-9);
+    dst->longitude = fmax(-LONGRANGE, fmin(LONGRANGE, src->longitude + fuzzRandom(-scale, scale))) * (1 - 1e-9);
+    if (scale >= 1)
+    {
+        dst->jDate += rand() % 7 - 3;
+    }
+    fuzzCost(dst);
+}
+
+/**
+ * Measures a fuzz case's wall time
+ *
+ *  Inputs:
+ * fuzzCase: the case
+ *
+ *  Output:
+ * Average time per call over FUZZREPS calls (ns)
+ **/
+double timeCase(const FuzzCase *fuzzCase)
+{
+    FuzzCase copy;         // the case, to run
+    struct timespec start; // start of the timing
+
+    copy = *fuzzCase;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < FUZZREPS; r++)
+    {
+        fuzzCost(&copy);
+    }
+
+    return elapsedSec(&start) * 1e9 / FUZZREPS;
+}
+
+/**
+ * Adds a case to a list of the FUZZKEEP most expensive if it belongs there
+ *
+ *  Inputs:
+ * worst: the list, most expensive first
+ * pointer numWorst: number of cases in the list
+ * fuzzCase: the case
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void keepWorst(FuzzCase *worst, int *numWorst, const FuzzCase *fuzzCase)
+{
+    int pos; // where the case goes
+
+    pos = *numWorst < FUZZKEEP ? *numWorst : FUZZKEEP;
+    while (pos > 0 && worst[pos - 1].iters < fuzzCase->iters)
+    {
+        pos--;
+    }
+    if (pos >= FUZZKEEP)
+    {
+        return;
+    }
+    memmove(&worst[pos + 1], &worst[pos], (FUZZKEEP - 1 - pos) * sizeof(FuzzCase));
+    worst[pos] = *fuzzCase;
+    if (*numWorst < FUZZKEEP)
+    {
+        (*numWorst)++;
+    }
+}
+
+/**
+ * Writes a regression corpus: one case per line as "solver latitude longitude YYYY MM DD option iterations ns",
+ * with the position written exactly so the iteration count reproduces
+ *
+ *  Inputs:
+ * path: file to write
+ * cases: the cases
+ * numCases: number of cases
+ *
+ *  Output:
+ * 1 if it worked, 0 if not
+ **/
+int writeCorpus(const char *path, const FuzzCase *cases, int numCases)
+{
+    int year, month, day; // the case's date
+    FILE *outFile;        // the corpus
+
+    outFile = fopen(path, "w");
+    if (!outFile)
+    {
+        return 0;
+    }
+    fprintf(outFile, "# solver latitude longitude YYYY MM DD option iterations ns\n");
+    for (int i = 0; i < numCases; i++)
+    {
+        calcDate(cases[i].jDate, 0, &day, &month, &year);
+        fprintf(outFile, "%s %.17g %.17g %04d %02d %02d %d %d %.0f\n", cases[i].solver == FUZZEVENT ? "calcEvent" : "calcEventDay",
+                cases[i].latitude, cases[i].longitude, year, month, day, cases[i].option, cases[i].iters, cases[i].nsPerCall);
+    }
+
+    return fclose(outFile) == 0;
+}
+
+/**
+ * Reads a regression corpus written by writeCorpus. Lines starting with # are comments
+ *
+ *  Inputs:
+ * path: file to read
+ * cases: array in which to store the cases
+ * maxCases: size of the array
+ *
+ *  Output:
+ * Number of cases read, -1 if the file can't be read
+ **/
+int readCorpus(const char *path, FuzzCase *cases, int maxCases)
+{
+    char line[BUFSIZ];    // input line
+    char solver[16];      // solver name
+    int year, month, day; // the case's date
+    int numCases = 0;     // number of cases read
+    FILE *inFile;         // the corpus
+
+    inFile = fopen(path, "r");
+    if (!inFile)
+    {
+        return -1;
+    }
+    while (numCases < maxCases && fgets(line, sizeof(line), inFile))
+    {
+        if (line[0] == '#' || sscanf(line, "%15s %lf %lf %d %d %d %d %d %lf", solver, &cases[numCases].latitude,
+                                     &cases[numCases].longitude, &year, &month, &day, &cases[numCases].option,
+                                     &cases[numCases].iters, &cases[numCases].nsPerCall) != 9)
+        {
+            continue;
+        }
+        cases[numCases].solver = strcmp(solver, "calcEvent") == 0 ? FUZZEVENT : FUZZDAY;
+        cases[numCases].jDate = calcJDate(day, month, year, 0);
+        numCases++;
+    }
+    fclose(inFile);
+
+    return numCases;
+}
+
+// DAYLIGHT CLASSIFIER FUNCTIONS
+
+/**
+ * Empties a light classifier's ephemeris cache
+ *
+ *  Inputs:
+ * pointer cache: the cache
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void initLightCache(LightCache *cache)
+{
+    for (int i = 0; i < LIGHTCACHE; i++)
+    {
+        cache->nodes[i].node = NOEPOCH;
+    }
+    cache->numEvals = 0;
+}
+
+/**
+ * Finds an ephemeris node in the cache, calculating it if it isn't there. Node n is the sun's position at Unix time
+ * n * LIGHTNODESEC. Consecutive nodes go in consecutive slots, so a node and the next one never evict each other.
+ *
+ *  Inputs:
+ * pointer cache: the cache
+ * node: node number
+ *
+ *  Output:
+ * The node
+ **/
+const LightNode *lightNode(LightCache *cache, int64_t node)
+{
+    LightNode *slot; // where the node goes
+    double sunDeclin; // sun declination (deg)
+
+    slot = &cache->nodes[node & (LIGHTCACHE - 1)];
+    if (slot->node != node)
+    {
+        calcSunPos(JDATEUNIX + (double)node * LIGHTNODESEC / SECINDAY, &sunDeclin, &slot->eqTime);
+        slot->sinDec = sind(sunDeclin);
+        slot->cosDec = cosd(sunDeclin);
+        slot->node = node;
+        cache->numEvals++;
+    }
+
+    return slot;
+}
+
+/**
+ * Cosine in degrees by polynomial, with no library calls, so that loops of it vectorize. Accurate to about 1e-10.
+ * Inline, since the vectorizer gives up on loops that call it.
+ *
+ *  Inputs:
+ * x: angle (deg)
+ *
+ *  Output:
+ * cos(x)
+ **/
+static inline double polyCosd(double x)
+{
+    double half; // half of x reduced to [-90, 90] (rad)
+    double h2;   // half squared
+    double c;    // cosine of half
+
+    // adding and subtracting ROUNDMAGIC rounds to the nearest integer in round to nearest mode
+    half = (x - 360 * ((x * (1.0 / 360) + ROUNDMAGIC) - ROUNDMAGIC)) * (DEG2RAD / 2);
+    h2 = half * half;
+    c = 1 + h2 * (-1.0 / 2 + h2 * (1.0 / 24 + h2 * (-1.0 / 720 + h2 * (1.0 / 40320 + h2 * (-1.0 / 3628800 +
+        h2 * (1.0 / 479001600 + h2 * (-1.0 / 87178291200 + h2 * (1.0 / 20922789888000))))))));
+
+    return 2 * c * c - 1;
+}
+
+/**
+ * Classifies every row of a batch as day, civil, nautical, or astronomical twilight, or night, and optionally finds
+ * the sun's elevation. The declination and equation of time are interpolated between ephemeris nodes LIGHTNODESEC
+ * apart, which rows with nearby timestamps share through the cache. Rows are done LIGHTCHUNK at a time: a scalar pass
+ * looks up each row's nodes, then a vectorized pass evaluates the altitude and compares it with the thresholds.
+ *
+ *  Inputs:
+ * batch: the rows. Its elevation and light columns are filled in
+ * pointer cache: ephemeris cache, kept from batch to batch
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void classifyLight(const LightBatch *batch, LightCache *cache)
+{
+    double sinDec[LIGHTCHUNK];    // each row's interpolated sine of the declination
+    double cosDec[LIGHTCHUNK];    // each row's interpolated cosine of the declination
+    double hourAngle[LIGHTCHUNK]; // each row's hour angle, before adding the longitude (deg)
+    double sinAlt[LIGHTCHUNK];    // each row's sine of the altitude
+    const double *latitude;  // the chunk's latitudes
+    const double *longitude; // the chunk's longitudes
+    int8_t *light;           // the chunk's classes
+    double sinRise;          // sine of TWILIGHTANGLE
+    double sinCivil;         // sine of CIVILANGLE
+    double sinNautical;      // sine of NAUTICALANGLE
+    double sinAstro;         // sine of ASTROANGLE
+    int64_t unitsPerNode;    // timestamp units between nodes
+    int64_t node;            // current node number
+    int64_t nodeStart;       // timestamp of the current node
+    int64_t offset;          // a row's units since the current node
+    double invUnits;         // 1 / unitsPerNode
+    const LightNode *lo;     // current node
+    const LightNode *hi;     // node after the current node
+    double angleBase;        // hour angle at the current node, before adding the longitude (deg)
+    double angleSlope;       // change in the hour angle from node to node (deg)
+    size_t numChunk;         // rows in the current chunk
+
+    sinRise = sind(TWILIGHTANGLE);
+    sinCivil = sind(CIVILANGLE);
+    sinNautical = sind(NAUTICALANGLE);
+    sinAstro = sind(ASTROANGLE);
+    unitsPerNode = batch->epochUnits / (SECINDAY / LIGHTNODESEC);
+    invUnits = 1.0 / unitsPerNode;
+    lo = hi = NULL;
+    nodeStart = 0;
+    angleBase = angleSlope = 0;
+
+    for (size_t first = 0; first < batch->numRows; first += LIGHTCHUNK)
+    {
+        numChunk = batch->numRows - first < LIGHTCHUNK ? batch->numRows - first : LIGHTCHUNK;
+        for (size_t k = 0; k < numChunk; k++)
+        {
+            // time-ordered rows mostly stay between the same two nodes, so only look them up when a row leaves them
+            offset = batch->time[first + k] - nodeStart;
+            if (!lo || offset < 0 || offset >= unitsPerNode)
+            {
+                node = batch->time[first + k] / unitsPerNode;
+                node -= batch->time[first + k] % unitsPerNode < 0;
+                nodeStart = node * unitsPerNode;
+                offset = batch->time[first + k] - nodeStart;
+                lo = lightNode(cache, node);
+                hi = lightNode(cache, node + 1);
+                // true solar time / 4 - 180, as altArg, with the longitude added in the vector pass
+                angleBase = ((double)((node % (HRSINDAY * SECINHR / LIGHTNODESEC) + HRSINDAY * SECINHR / LIGHTNODESEC) %
+                                      (HRSINDAY * SECINHR / LIGHTNODESEC)) * LIGHTNODESEC / SECINMIN + lo->eqTime) / 4 - 180;
+                angleSlope = ((double)LIGHTNODESEC / SECINMIN + hi->eqTime - lo->eqTime) / 4;
+            }
+            sinDec[k] = lo->sinDec + offset * invUnits * (hi->sinDec - lo->sinDec);
+            cosDec[k] = lo->cosDec + offset * invUnits * (hi->cosDec - lo->cosDec);
+            hourAngle[k] = angleBase + offset * invUnits * angleSlope;
+        }
+
+        latitude = batch->latitude + first;
+        longitude = batch->longitude + first;
+        light = batch->light + first;
+        OMP(simd)
+        for (size_t k = 0; k < numChunk; k++)
+        {
+            sinAlt[k] = polyCosd(latitude[k] - 90) * sinDec[k] +
+                        polyCosd(latitude[k]) * cosDec[k] * polyCosd(hourAngle[k] + longitude[k]);
+        }
+        OMP(simd)
+        for (size_t k = 0; k < numChunk; k++)
+        {
+            // summed as doubles, since plain SSE2 can't narrow comparison masks to bytes
+            light[k] = (int8_t)((sinAlt[k] > sinAstro ? 1.0 : 0.0) + (sinAlt[k] > sinNautical ? 1.0 : 0.0) +
+                                (sinAlt[k] > sinCivil ? 1.0 : 0.0) + (sinAlt[k] > sinRise ? 1.0 : 0.0));
+        }
+
+        if (batch->elevation)
+        {
+            for (size_t k = 0; k < numChunk; k++)
+            {
+                batch->elevation[first + k] = asin(sinAlt[k] > 1 ? 1 : sinAlt[k] < -1 ? -1 : sinAlt[k]) * RAD2DEG;
+            }
+        }
+    }
+}
+
+/**
+ * Calculates the sun's elevation at one instant directly, with no shared nodes, for checking classifyLight
+ *
+ *  Inputs:
+ * latitude: North/South component of position
+ * longitude: East/west component of position
+ * time: Unix timestamp
+ * epochUnits: units per day of the timestamp
+ *
+ *  Output:
+ * Elevation of the sun's centre (deg), without refraction
+ **/
+double sunElevation(double latitude, double longitude, int64_t time, int64_t epochUnits)
+{
+    double jDate;      // Julian date of the instant
+    double sunDeclin;  // sun declination (deg)
+    double eqOfTime;   // equation of time (minutes)
+    double hourAngle;  // hour angle (deg)
+
+    jDate = JDATEUNIX + (double)time / epochUnits;
+    calcSunPos(jDate, &sunDeclin, &eqOfTime);
+    hourAngle = ((jDate - floor(jDate - 0.5) - 0.5) * HRSINDAY * MININHR + eqOfTime + 4 * longitude) / 4 - 180;
+
+    return asind(sind(latitude) * sind(sunDeclin) + cosd(latitude) * cosd(sunDeclin) * cosd(hourAngle));
+}
+
+// RESIDENT SERVICE FUNCTIONS
+
+/**
+ * Reads the monotonic clock
+ *
+ *  Inputs:
+ * None
+ *
+ *  Output:
+ * Seconds since an arbitrary fixed point
+ **/
+double monoSec(void)
+{
+    struct timespec now; // current time
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Finds the cache slot for a site
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * latitude: North/South component of position
+ * longitude: East/west component of position
+ * tZ: time zone in UTC offset
+ *
+ *  Output:
+ * The site's slot, which may hold another site's period
+ **/
+PolarPeriod *polarCacheSlot(ServeState *state, double latitude, double longitude, double tZ)
+{
+    uint64_t bits[3]; // the site's coordinates and time zone, bit for bit
+    uint64_t hash;    // hash of the bits
+
+    memcpy(&bits[0], &latitude, sizeof(double));
+    memcpy(&bits[1], &longitude, sizeof(double));
+    memcpy(&bits[2], &tZ, sizeof(double));
+    hash = ((bits[0] * 0x9E3779B97F4A7C15ULL) ^ bits[1]) * 0x9E3779B97F4A7C15ULL ^ bits[2];
+    hash ^= hash >> 29;
+
+    return &state->cache[hash % SERVECACHE];
+}
+
+/**
+ * Estimates the last and next events around a polar day or night in a few calcDayType calls. polarPeriodEdge finds
+ * the first days outside the period, which may only have the other event: calcDayType calls a day with one event a
+ * day with sunlight, while calcEvent may only find that event's partner a day further out. So up to ESTIMATEDAYS
+ * further days are tried for each event.
+ *
+ *  Inputs:
+ * pointer period: the period, with its site and day type filled in. Its events are filled in
+ * jDate: Julian date of a day in the period. Must be the beginning of a day
+ * lastEvent: event code of the last event, as calcEvent
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void estimatePolarPeriod(PolarPeriod *period, double jDate, int lastEvent)
+{
+    double *eventDays[2] = {&period->lastEventDay, &period->nextEventDay};    // each event's day
+    double *eventTimes[2] = {&period->lastEventTime, &period->nextEventTime}; // each event's time
+
+    for (int i = 0; i < 2; i++)
+    {
+        *eventDays[i] = polarPeriodEdge(jDate, period->tZ, period->longitude, period->latitude, 2 * i - 1, calcDayType);
+        for (int k = 0; k <= ESTIMATEDAYS; k++)
+        {
+            *eventTimes[i] = calcEvent(*eventDays[i], period->tZ, period->longitude, period->latitude, i == 0 ? lastEvent : 4 - lastEvent);
+            if (*eventTimes[i] >= -1 && *eventTimes[i] < 2)
+            {
+                break;
+            }
+            *eventTimes[i] = NAN;
+            *eventDays[i] += k < ESTIMATEDAYS ? 2 * i - 1 : 0;
+        }
+    }
+}
+
+/**
+ * Finds the last and next events around a polar day or night. Every day of a polar period has the same answer, so an
+ * exact answer for a site is kept and reused for any later date inside the same period. Otherwise calcEventDay walks
+ * to the events, unless the walk is predicted to miss the deadline, or does miss it. Then the answer is estimated from
+ * estimatePolarPeriod, which is flagged as being up to ESTIMATEDAYS days off.
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * jDate: Julian date of a day in the period. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ * dayType: -1 polar day, -2 polar night
+ * deadline: monoSec time the answer is due
+ * pointer period: variable in which to store the answer
+ *
+ *  Output:
+ * Where the answer came from: SERVEEXACT, SERVECACHED, SERVEPREDICTED, or SERVETIMEDOUT
+ **/
+int solvePolarPeriod(ServeState *state, double jDate, double tZ, double longitude, double latitude, int dayType, double deadline, PolarPeriod *period)
+{
+    PolarPeriod *slot; // the site's cache slot
+    int lastEvent;     // event code of the last event, as calcEvent
+    int source;        // where the answer came from
+    double start;      // when the walk started (monoSec)
+    double numDays;    // days the walk checked
+    double walkDeadline; // deadline less the time kept back for the event times
+    PolarPeriod estimate; // the estimate, in case the walk misses the deadline
+
+    slot = polarCacheSlot(state, latitude, longitude, tZ);
+    if (slot->dayType == dayType && slot->latitude == latitude && slot->longitude == longitude && slot->tZ == tZ &&
+        slot->lastEventDay < jDate && jDate < slot->nextEventDay)
+    {
+        *period = *slot;
+        return SERVECACHED;
+    }
+
+    lastEvent = dayType == -1 ? 1 : 3;
+    period->latitude = latitude;
+    period->longitude = longitude;
+    period->tZ = tZ;
+    period->dayType = dayType;
+    estimatePolarPeriod(period, jDate, lastEvent);
+
+    // both walks check every day of the period, plus the two event days
+    numDays = period->nextEventDay - period->lastEventDay + 1;
+    walkDeadline = deadline - SERVERESERVEDAYS * state->nsPerDay / 1e9;
+    source = SERVEPREDICTED;
+    if (monoSec() + numDays * state->nsPerDay / 1e9 <= walkDeadline)
+    {
+        start = monoSec();
+        estimate = *period;
+        period->lastEventDay = calcEventDayIters(longitude, latitude, tZ, jDate, -lastEvent, NULL, &walkDeadline);
+        if (period->lastEventDay != MISSEDDEADLINE)
+        {
+            period->nextEventDay = calcEventDayIters(longitude, latitude, tZ, jDate, 4 - lastEvent, NULL, &walkDeadline);
+        }
+        if (period->lastEventDay != MISSEDDEADLINE && period->nextEventDay != MISSEDDEADLINE)
+        {
+            numDays = (period->lastEventDay == NOEVENTDAY ? MAXEVENTDAYS : jDate - period->lastEventDay + 1) +
+                      (period->nextEventDay == NOEVENTDAY ? MAXEVENTDAYS : period->nextEventDay - jDate + 1);
+            state->nsPerDay += SERVEEWMA * ((monoSec() - start) * 1e9 / numDays - state->nsPerDay);
+            period->lastEventTime = period->lastEventDay == NOEVENTDAY ? NAN : calcEvent(period->lastEventDay, tZ, longitude, latitude, lastEvent);
+            period->nextEventTime = period->nextEventDay == NOEVENTDAY ? NAN : calcEvent(period->nextEventDay, tZ, longitude, latitude, 4 - lastEvent);
+            source = SERVEEXACT;
+        }
+        else
+        {
+            *period = estimate;
+            source = SERVETIMEDOUT;
+        }
+    }
+
+    if (source == SERVEEXACT && period->lastEventDay != NOEVENTDAY && period->nextEventDay != NOEVENTDAY)
+    {
+        *slot = *period;
+    }
+
+    return source;
+}
+
+/**
+ * Prints an event of serve mode's answers as " YYYY-MM-DD HH:MM", or " none" if there isn't one
+ *
+ *  Inputs:
+ * jDate: Julian date of the event's day, NOEVENTDAY if there isn't one
+ * time: time of the event (decimal day), NAN if it isn't known
+ * tZ: time zone in UTC offset
+ *
+ *  Output:
+ * None
+ **/
+void printServeEvent(double jDate, double time, double tZ)
+{
+    int year, month, day; // date of the event
+
+    if (jDate == NOEVENTDAY)
+    {
+        printf(" none");
+        return;
+    }
+    calcDate(jDate, tZ, &day, &month, &year);
+    printf(" %04d-%02d-%02d ", year, month, day);
+    if (isnan(time))
+    {
+        printf("--:--");
+    }
+    else
+    {
+        printClock(time);
+    }
+}
+
+/**
+ * Prints serve mode's counters on one line
+ *
+ *  Inputs:
+ * pointer out: stream to print to
+ * state: the service state
+ *
+ *  Output:
+ * None
+ **/
+void printServeStats(FILE *out, const ServeState *state)
+{
+    fprintf(out, "requests %ld exact %ld cached %ld predicted %ld timedout %ld degraded %.2f%% late %ld maxus %.0f\n",
+            state->numRequests, state->numSources[SERVEEXACT], state->numSources[SERVECACHED],
+            state->numSources[SERVEPREDICTED], state->numSources[SERVETIMEDOUT],
+            state->numRequests ? 100.0 * (state->numSources[SERVEPREDICTED] + state->numSources[SERVETIMEDOUT]) / state->numRequests : 0,
+            state->numLate, state->maxLatency * 1e6);
+}
+
+/**
+ * Answers one serve mode request. A day with a sunrise or sunset is always solved exactly with calcEvent, which takes
+ * a few microseconds. A polar day or night is answered by solvePolarPeriod.
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * jDate: Julian date of the day. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ * start: monoSec time the request arrived
+ * budget: time allowed for the answer (s)
+ *
+ *  Output:
+ * None
+ **/
+void serveRequest(ServeState *state, double jDate, double tZ, double longitude, double latitude, double start, double budget)
+{
+    const char *sources[] = {"exact", "cached", "estimate", "estimate"}; // answer flags by source
+    PolarPeriod period; // a polar period's answer
+    int dayType;        // the type of day, as calcDayType
+    int source;         // where the answer came from
+    int errDays;        // error bound of the answer (days)
+    double latency;     // time taken (s)
+
+    dayType = calcDayType(jDate, tZ, longitude, latitude);
+    if (dayType > 0)
+    {
+        source = SERVEEXACT;
+        printf("exact 0");
+        for (int e = 1; e <= 3; e++)
+        {
+            printf(" %c ", "?RNS"[e]);
+            printClock(calcEvent(jDate, tZ, longitude, latitude, e));
+        }
+    }
+    else
+    {
+        source = solvePolarPeriod(state, jDate, tZ, longitude, latitude, dayType, start + budget, &period);
+        // where calcEvent finds no event near the edges (within about 0.2 deg of a pole), its walk can end up to
+        // MAXEVENTDAYS days away
+        errDays = source < SERVEPREDICTED ? 0 : isnan(period.lastEventTime) || isnan(period.nextEventTime) ? MAXEVENTDAYS : ESTIMATEDAYS;
+        printf("%s %d %s", sources[source], errDays * HRSINDAY * MININHR, dayType == -1 ? "day" : "night");
+        printServeEvent(period.lastEventDay, period.lastEventTime, tZ);
+        printServeEvent(period.nextEventDay, period.nextEventTime, tZ);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    latency = monoSec() - start;
+    state->numRequests++;
+    state->numSources[source]++;
+    state->numLate += latency > budget;
+    state->maxLatency = fmax(state->maxLatency, latency);
+}
+
+// PLACEMENT FUNCTIONS
+
+/**
+ * Reads a Linux CPU list such as "0-3,8,10-11"
+ *
+ *  Inputs:
+ * path: file holding the list
+ * pointer cpus: array of maxCpus in which to set 1 for each CPU listed
+ * maxCpus: number of CPUs the array can hold. Higher CPUs are skipped
+ *
+ *  Output:
+ * 1 if the file could be read, 0 if not
+ **/
+int readCpuList(const char *path, unsigned char *cpus, int maxCpus)
+{
+    FILE *listFile;  // the list
+    int first, last; // a range of CPUs
+    char sep;        // character after a range
+
+    listFile = fopen(path, "r");
+    if (!listFile)
+    {
+        return 0;
+    }
+    while (fscanf(listFile, "%d", &first) == 1)
+    {
+        last = first;
+        sep = fgetc(listFile);
+        if (sep == '-' && fscanf(listFile, "%d", &last) == 1)
+        {
+            sep = fgetc(listFile);
+        }
+        for (int c = first; c <= last && c < maxCpus; c++)
+        {
+            cpus[c] = 1;
+        }
+        if (sep != ',')
+        {
+            break;
+        }
+    }
+    fclose(listFile);
+
+    return 1;
+}
+
+/**
+ * Chooses a CPU for each worker of a placed grid job. The CPUs the process may run on are taken one node at a time,
+ * round robin, so consecutive workers land on different sockets and a partial run uses every node's memory
+ * bandwidth. Nodes are read from /sys/devices/system/node; without it, every CPU is taken to be on node 0.
+ *
+ *  Inputs:
+ * pointer plan: the placement to fill
+ * numThreads: number of workers, 0 for one per CPU
+ * pin: whether to pin each worker to its CPU
+ * hugePages: whether to ask for transparent huge pages
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void planPlacement(GridPlacement *plan, int numThreads, int pin, int hugePages)
+{
+    unsigned char allowed[MAXTHREADS] = {0}; // whether the process may run on each CPU
+    unsigned char nodeCpus[MAXTHREADS];      // whether each CPU is on the node being read
+    int cpuNode[MAXTHREADS] = {0};           // node of each CPU
+    int order[MAXTHREADS];                   // allowed CPUs, taking one node at a time
+    int next[MAXNODES] = {0};                // next CPU to look at on each node
+    int numNodes = 1;                        // number of nodes
+    int added;                               // whether a round took any CPU
+    char path[BUFSIZ];                       // a node's CPU list
+    long numOnline;                          // number of CPUs online
+
+    numOnline = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int c = 0; c < numOnline && c < MAXTHREADS; c++)
+    {
+        allowed[c] = 1;
+    }
+#ifdef __linux__
+    cpu_set_t mask; // CPUs the process may run on
+
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0)
+    {
+        for (int c = 0; c < MAXTHREADS && c < CPU_SETSIZE; c++)
+        {
+            allowed[c] = CPU_ISSET(c, &mask);
+        }
+    }
+#endif
+    for (int node = 0; node < MAXNODES; node++)
+    {
+        snprintf(path, BUFSIZ, "/sys/devices/system/node/node%d/cpulist", node);
+        memset(nodeCpus, 0, sizeof(nodeCpus));
+        if (readCpuList(path, nodeCpus, MAXTHREADS))
+        {
+            for (int c = 0; c < MAXTHREADS; c++)
+            {
+                cpuNode[c] = nodeCpus[c] ? node : cpuNode[c];
+            }
+            numNodes = node + 1;
+        }
+    }
+
+    plan->numCpus = 0;
+    do
+    {
+        added = 0;
+        for (int node = 0; node < numNodes; node++)
+        {
+            while (next[node] < MAXTHREADS && !(allowed[next[node]] && cpuNode[next[node]] == node))
+            {
+                next[node]++;
+            }
+            if (next[node] < MAXTHREADS)
+            {
+                order[plan->numCpus++] = next[node]++;
+                added = 1;
+            }
+        }
+    } while (added);
+    if (plan->numCpus == 0)
+    {
+        order[plan->numCpus++] = 0;
+    }
+
+    plan->numThreads = numThreads < 1 ? plan->numCpus : numThreads > MAXTHREADS ? MAXTHREADS : numThreads;
+    plan->pin = pin;
+    plan->hugePages = hugePages;
+    for (int t = 0; t < plan->numThreads; t++)
+    {
+        plan->cpus[t] = order[t % plan->numCpus];
+        plan->nodes[t] = cpuNode[plan->cpus[t]];
+    }
+}
+
+/**
+ * Pins the calling thread to one CPU, so the memory it first touches stays on that CPU's node
+ *
+ *  Inputs:
+ * cpu: the CPU
+ *
+ *  Output:
+ * 1 if it worked, 0 if not (always 0 off Linux)
+ **/
+int pinThread(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t mask; // the one CPU
+
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+
+    return sched_setaffinity(0, sizeof(mask), &mask) == 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Allocates memory for a worker of a placed grid job. The memory isn't touched, so under Linux's default first-touch
+ * policy its pages are placed on the node of whichever thread writes them first. With huge pages, the block is
+ * aligned to and rounded up to HUGEPAGESIZE and the kernel is asked to back it with transparent huge pages.
+ *
+ *  Inputs:
+ * size: bytes to allocate
+ * hugePages: whether to ask for huge pages
+ *
+ *  Output:
+ * The memory, to be released with free, or NULL if it couldn't be allocated
+ **/
+void *allocPlaced(size_t size, int hugePages)
+{
+    void *block; // the memory
+
+    if (!hugePages)
+    {
+        return malloc(size);
+    }
+    size = (size + HUGEPAGESIZE - 1) / HUGEPAGESIZE * HUGEPAGESIZE;
+    block = aligned_alloc(HUGEPAGESIZE, size);
+#ifdef MADV_HUGEPAGE
+    if (block)
+    {
+        madvise(block, size, MADV_HUGEPAGE);
+    }
+#endif
+
+    return block;
+}
+
+/**
+ * Calculates one worker's band of rows of a grid job, as runGrid. The worker allocates and fills its own site arrays,
+ * copy of the per-date terms, and stripe buffer, so all of them are on its own node, and writes each stripe straight
+ * to its place in the output file.
+ *
+ *  Inputs:
+ * job: the grid job
+ * rowBegin: first row (latitude) of the band
+ * rowEnd: one past the last row of the band
+ * fd: output file, or -1 to calculate without writing
+ * offset: where the band starts in the file (bytes)
+ * naive: whether to use calcEvent for every site instead of the tiled engine
+ * hugePages: whether to ask for huge pages for the band's arrays
+ *
+ *  Output:
+ * 1 if it worked, 0 if memory couldn't be allocated or the file couldn't be written
+ **/
+int runGridBand(const GridJob *job, int rowBegin, int rowEnd, int fd, off_t offset, int naive, int hugePages)
+{
+    SiteArrays sites; // the band's sites
+    DateEphem *ephs;  // per-date terms
+    void *out;        // output for one stripe of sites
+    size_t valueSize; // size of one output value
+    size_t siteSize;  // size of one site's output
+    int stripeEnd;    // one past the last site of the current stripe
+    int ok = 1;       // whether every stripe was written
+
+    valueSize = job->epochUnits == 0 ? sizeof(float) : sizeof(int64_t);
+    siteSize = (size_t)job->numDays * 3 * valueSize;
+    sites.numSites = (rowEnd - rowBegin) * job->numLon;
+    sites.longitude = allocPlaced(sites.numSites * sizeof(double), hugePages);
+    sites.latitude = allocPlaced(sites.numSites * sizeof(double), hugePages);
+    sites.secLat = allocPlaced(sites.numSites * sizeof(double), hugePages);
+    sites.tanLat = allocPlaced(sites.numSites * sizeof(double), hugePages);
+    ephs = allocPlaced(job->numDays * sizeof(DateEphem), hugePages);
+    out = allocPlaced(SITEBLOCK * siteSize, hugePages);
+    if (!sites.longitude || !sites.latitude || !sites.secLat || !sites.tanLat || !ephs || !out)
+    {
+        freeSiteArrays(&sites);
+        free(ephs);
+        free(out);
+        return 0;
+    }
+
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        for (int j = 0; j < job->numLon; j++)
+        {
+            sites.latitude[(i - rowBegin) * job->numLon + j] = job->latMin + i * job->step;
+            sites.longitude[(i - rowBegin) * job->numLon + j] = job->lonMin + j * job->step;
+        }
+    }
+    prepSiteArrays(&sites);
+    for (int d = 0; d < job->numDays; d++)
+    {
+        calcDateEphem(&ephs[d], job->startJDate + d);
+    }
+
+    for (int siteBegin = 0; siteBegin < sites.numSites && ok; siteBegin += SITEBLOCK)
+    {
+        stripeEnd = siteBegin + SITEBLOCK < sites.numSites ? siteBegin + SITEBLOCK : sites.numSites;
+        for (int dayBegin = 0; dayBegin < job->numDays && !naive; dayBegin += DATEBLOCK)
+        {
+            gridTile(job, &sites, ephs, siteBegin, stripeEnd, dayBegin,
+                     dayBegin + DATEBLOCK < job->numDays ? dayBegin + DATEBLOCK : job->numDays, out);
+        }
+        for (int i = siteBegin; i < stripeEnd && naive; i++)
+        {
+            gridNaiveRow(job, &sites, siteBegin, i, out);
+        }
+        if (fd >= 0)
+        {
+            ok = pwrite(fd, out, (stripeEnd - siteBegin) * siteSize, offset + siteBegin * siteSize) ==
+                 (ssize_t)((stripeEnd - siteBegin) * siteSize);
+        }
+    }
+
+    freeSiteArrays(&sites);
+    free(ephs);
+    free(out);
+
+    return ok;
+}
+
+/**
+ * Calculates rows of a grid job with several threads and writes them to a file, byte for byte as runGrid does. The
+ * rows are split into one band per worker, sized by predicted cost as in shard mode, and each worker keeps its band's
+ * memory on its own node (see runGridBand). Bands never share a page of working memory, so workers on different
+ * sockets don't pull each other's data across the interconnect.
+ *
+ *  Inputs:
+ * job: the grid job
+ * rowBegin: first row (latitude) to calculate
+ * rowEnd: one past the last row to calculate
+ * fd: output file, or -1 to calculate without writing
+ * naive: whether to use calcEvent for every site instead of the tiled engine
+ * plan: number of workers, their CPUs, and whether to pin them and use huge pages
+ *
+ *  Output:
+ * 1 if it worked, 0 if memory couldn't be allocated or the file couldn't be written
+ **/
+int runGridPlaced(const GridJob *job, int rowBegin, int rowEnd, int fd, int naive, const GridPlacement *plan)
+{
+    GridJob band;     // the rows to calculate, as a job of their own
+    int *bounds;      // first row of each worker's band, counted from rowBegin
+    int numWorkers;   // number of bands
+    size_t rowSize;   // size of one row's output
+    int failed = 0;   // whether any band failed
+
+    band = *job;
+    band.latMin = job->latMin + rowBegin * job->step;
+    band.numLat = rowEnd - rowBegin;
+    numWorkers = plan->numThreads < band.numLat ? plan->numThreads : band.numLat;
+    rowSize = (size_t)job->numLon * job->numDays * 3 * (job->epochUnits == 0 ? sizeof(float) : sizeof(int64_t));
+    bounds = malloc((numWorkers + 1) * sizeof(int));
+    if (!bounds)
+    {
+        return 0;
+    }
+    planShards(&band, numWorkers, bounds);
+
+#ifdef __linux__
+    cpu_set_t mask; // the calling thread's CPUs, as it runs worker 0
+    int savedMask;  // whether mask was read
+
+    savedMask = sched_getaffinity(0, sizeof(mask), &mask) == 0;
+#endif
+    OMP(parallel for num_threads(numWorkers) schedule(static, 1) reduction(| : failed))
+    for (int k = 0; k < numWorkers; k++)
+    {
+        if (plan->pin)
+        {
+            pinThread(plan->cpus[k]);
+        }
+        failed |= !runGridBand(job, rowBegin + bounds[k], rowBegin + bounds[k + 1], fd, (off_t)(bounds[k] * rowSize),
+                               naive, plan->hugePages);
+    }
+#ifdef __linux__
+    if (savedMask && plan->pin)
+    {
+        sched_setaffinity(0, sizeof(mask), &mask);
+    }
+#endif
+
+    free(bounds);
+
+    return !failed;
+}
+
+// PROFILING FUNCTIONS
+
+/**
+ * Opens the hardware counters for a profile: cycles, instructions, branch misses, and cache misses, counted in user
+ * space for this thread. They're opened as one group so they're always counted over the same instants. Counters the
+ * machine or kernel doesn't provide (no PMU, as in many VMs, or perf_event_paranoid too high) are left out, and if
+ * there are none the profile measures time only.
+ *
+ *  Inputs:
+ * pointer prof: the profile to set up
+ *
+ *  Output:
+ * Number of counters opened
+ **/
+int openProfile(Profile *prof)
+{
+    memset(prof, 0, sizeof(Profile));
+    for (int c = 0; c < NUMCOUNTERS; c++)
+    {
+        prof->fds[c] = -1;
+        prof->slots[c] = -1;
+    }
+
+#ifdef __linux__
+    const uint64_t configs[NUMCOUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                           PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES}; // counter events
+    struct perf_event_attr attr; // a counter's settings
+
+    for (int c = 0; c < NUMCOUNTERS; c++)
+    {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[c];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = prof->numOpen == 0;
+        prof->fds[c] = syscall(SYS_perf_event_open, &attr, 0, -1, prof->numOpen ? prof->fds[PROFCYCLES] : -1, 0);
+        if (prof->fds[c] >= 0)
+        {
+            prof->slots[c] = prof->numOpen++;
+        }
+        else if (c == PROFCYCLES)
+        {
+            // without cycles there's no group leader to follow, and no IPC
+            break;
+        }
+    }
+    if (prof->numOpen)
+    {
+        ioctl(prof->fds[PROFCYCLES], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+
+    return prof->numOpen;
+}
+
+/**
+ * Closes a profile's counters
+ *
+ *  Inputs:
+ * pointer prof: the profile
+ *
+ *  Output:
+ * None
+ **/
+void closeProfile(Profile *prof)
+{
+    for (int c = NUMCOUNTERS - 1; c >= 0; c--)
+    {
+        if (prof->fds[c] >= 0)
+        {
+            close(prof->fds[c]);
+            prof->fds[c] = -1;
+        }
+    }
+    prof->numOpen = 0;
+}
+
+/**
+ * Reads a profile's counters, all at the same instant
+ *
+ *  Inputs:
+ * prof: the profile
+ * pointer values: array of NUMCOUNTERS in which to store each counter's value, 0 for counters that aren't open
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void readProfCounters(const Profile *prof, uint64_t *values)
+{
+    uint64_t group[NUMCOUNTERS + 1] = {0}; // number of counters, then their values in the order they were opened
+
+    if (prof->numOpen && read(prof->fds[PROFCYCLES], group, sizeof(group)) < (ssize_t)sizeof(uint64_t))
+    {
+        group[0] = 0;
+    }
+    for (int c = 0; c < NUMCOUNTERS; c++)
+    {
+        values[c] = prof->slots[c] >= 0 && (uint64_t)prof->slots[c] < group[0] ? group[1 + prof->slots[c]] : 0;
+    }
+}
+
+/**
+ * Enters or leaves a stage, charging what happened since the last change to the innermost stage that was entered
+ * (PROFOTHER if none). The convergence loops run while walking to a polar event are charged to polar handling.
+ *
+ *  Inputs:
+ * pointer prof: the profile
+ * stage: stage to enter, or -1 to leave the innermost one
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void changeStage(Profile *prof, int stage)
+{
+    uint64_t values[NUMCOUNTERS]; // counter values now
+    double nowNs;                 // time now (ns)
+    int current;                  // stage being charged
+
+    readProfCounters(prof, values);
+    nowNs = monoSec() * 1e9;
+    current = prof->depth ? prof->stack[prof->depth - 1] : PROFOTHER;
+    for (int c = 0; c < NUMCOUNTERS; c++)
+    {
+        prof->counts[current][c] += values[c] - prof->last[c];
+        prof->last[c] = values[c];
+    }
+    prof->ns[current] += nowNs - prof->lastNs;
+    prof->lastNs = nowNs;
+    prof->charges[current]++;
+
+    if (stage < 0)
+    {
+        prof->depth -= prof->depth > 0;
+    }
+    else if (prof->depth < PROFDEPTH)
+    {
+        stage = stage == PROFSOLVE && current == PROFPOLAR ? PROFPOLAR : stage;
+        prof->stack[prof->depth++] = stage;
+        prof->entries[stage]++;
+    }
+}
+
+/**
+ * Enters a stage of the profile being recorded, if there is one. Does nothing without SOLARPROFILE
+ *
+ *  Inputs:
+ * stage: PROFEPHEM, PROFSOLVE, PROFPOLAR, PROFENUM, or PROFOUTPUT
+ *
+ *  Output:
+ * None
+ **/
+static inline void profEnter(int stage)
+{
+#ifdef SOLARPROFILE
+    if (activeProfile)
+    {
+        changeStage(activeProfile, stage);
+    }
+#endif
+}
+
+/**
+ * Leaves the innermost stage of the profile being recorded, if there is one. Does nothing without SOLARPROFILE
+ *
+ *  Inputs:
+ * None
+ *
+ *  Output:
+ * None
+ **/
+static inline void profLeave(void)
+{
+#ifdef SOLARPROFILE
+    if (activeProfile)
+    {
+        changeStage(activeProfile, -1);
+    }
+#endif
+}
+
+/**
+ * Makes a libm call for one of the degree trig functions while a profile is being recorded. The call is counted
+ * against the innermost stage, and every PROFSAMPLE-th call is kept so that replayLibm can time the stage's own mix
+ * of functions and arguments. Timing each call in place would mostly time the clock.
+ *
+ *  Inputs:
+ * func: the libm function
+ * arg: its argument
+ *
+ *  Output:
+ * func(arg)
+ **/
+double profLibm(double (*func)(double), double arg)
+{
+    Profile *prof = activeProfile; // the profile being recorded
+    int stage;                     // stage making the call
+    long sample;                   // where the call goes if it's kept
+
+    stage = prof->depth ? prof->stack[prof->depth - 1] : PROFOTHER;
+    if (stage < NUMSTAGES && prof->libmCalls[stage] % PROFSAMPLE == 0)
+    {
+        sample = prof->libmCalls[stage] / PROFSAMPLE % PROFREPLAY;
+        prof->sampleFuncs[stage][sample] = func;
+        prof->sampleArgs[stage][sample] = arg;
+    }
+    prof->libmCalls[stage]++;
+
+    return func(arg);
+}
+
+/**
+ * Clears a profile's per-stage counts and starts charging from now
+ *
+ *  Inputs:
+ * pointer prof: the profile
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void resetProfile(Profile *prof)
+{
+    memset(prof->counts, 0, sizeof(prof->counts));
+    memset(prof->ns, 0, sizeof(prof->ns));
+    memset(prof->charges, 0, sizeof(prof->charges));
+    memset(prof->entries, 0, sizeof(prof->entries));
+    memset(prof->libmCalls, 0, sizeof(prof->libmCalls));
+    prof->depth = 0;
+    readProfCounters(prof, prof->last);
+    prof->lastNs = monoSec() * 1e9;
+}
+
+/**
+ * Orders doubles, for qsort
+ *
+ *  Inputs:
+ * a: pointer to the first double
+ * b: pointer to the second double
+ *
+ *  Output:
+ * Negative, 0, or positive as for qsort
+ **/
+int compareDoubles(const void *a, const void *b)
+{
+    return (*(const double *)a > *(const double *)b) - (*(const double *)a < *(const double *)b);
+}
+
+/**
+ * Finds the median of some values
+ *
+ *  Inputs:
+ * pointer values: the values, which are sorted in place
+ * numValues: number of values
+ *
+ *  Output:
+ * The middle value (the upper one of the middle two if there's an even number)
+ **/
+double medianOf(double *values, int numValues)
+{
+    qsort(values, numValues, sizeof(double), compareDoubles);
+
+    return values[numValues / 2];
+}
+
+/**
+ * Measures what a stage change itself adds to the stage it charges (its bookkeeping, the end of one counter read,
+ * and the start of the next), so printProfile can take it out. The cost is the median of PROFBATCHES batches, so a burst of noise doesn't
+ * skew it. Then clears the profile.
+ *
+ *  Inputs:
+ * pointer prof: the profile, opened
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void calibrateProfile(Profile *prof)
+{
+    double batchNs[PROFBATCHES];                  // cost measured by each batch (ns)
+    double batchCounts[NUMCOUNTERS][PROFBATCHES]; // change counts measured by each batch
+
+    for (int b = 0; b < PROFBATCHES; b++)
+    {
+        resetProfile(prof);
+        for (int i = 0; i < PROFCALIB / PROFBATCHES; i++)
+        {
+            changeStage(prof, PROFCALIBSTAGE);
+            changeStage(prof, -1);
+        }
+        batchNs[b] = prof->ns[PROFCALIBSTAGE] / prof->charges[PROFCALIBSTAGE];
+        for (int c = 0; c < NUMCOUNTERS; c++)
+        {
+            batchCounts[c][b] = prof->counts[PROFCALIBSTAGE][c] / prof->charges[PROFCALIBSTAGE];
+        }
+    }
+    prof->changeNs = medianOf(batchNs, PROFBATCHES);
+    for (int c = 0; c < NUMCOUNTERS; c++)
+    {
+        prof->changeCounts[c] = medianOf(batchCounts[c], PROFBATCHES);
+    }
+
+    resetProfile(prof);
+}
+
+/**
+ * Times each stage's sampled libm calls (see profLibm) by replaying them, PROFREPEATS times over in each of
+ * PROFBATCHES batches, and keeps the median time and cycles per call. Replaying right after the run, on the run's own
+ * arguments, keeps the estimate close to what the calls cost during the run. Cycles don't change with the clock
+ * speed, so printProfile uses them when the counters are available.
+ *
+ *  Inputs:
+ * pointer prof: the profile, after the run
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void replayLibm(Profile *prof)
+{
+    double batchNs[PROFBATCHES];     // time per call measured by each batch (ns)
+    double batchCycles[PROFBATCHES]; // cycles per call measured by each batch
+    uint64_t before[NUMCOUNTERS];    // counter values before a batch
+    uint64_t after[NUMCOUNTERS];     // counter values after a batch
+    long numSamples;                 // calls kept for the stage
+    double startNs;                  // time before a batch (ns)
+    volatile double sink = 0;        // keeps the calls from being optimized away
+
+    for (int st = 0; st < NUMSTAGES; st++)
+    {
+        numSamples = (prof->libmCalls[st] + PROFSAMPLE - 1) / PROFSAMPLE;
+        numSamples = numSamples < PROFREPLAY ? numSamples : PROFREPLAY;
+        prof->libmNs[st] = 0;
+        prof->libmCycles[st] = 0;
+        for (int b = 0; b < PROFBATCHES && numSamples; b++)
+        {
+            readProfCounters(prof, before);
+            startNs = monoSec() * 1e9;
+            for (int r = 0; r < PROFREPEATS; r++)
+            {
+                for (long i = 0; i < numSamples; i++)
+                {
+                    sink += prof->sampleFuncs[st][i](prof->sampleArgs[st][i]);
+                }
+            }
+            batchNs[b] = (monoSec() * 1e9 - startNs) / (PROFREPEATS * numSamples);
+            readProfCounters(prof, after);
+            batchCycles[b] = (double)(after[PROFCYCLES] - before[PROFCYCLES]) / (PROFREPEATS * numSamples);
+        }
+        if (numSamples)
+        {
+            prof->libmNs[st] = medianOf(batchNs, PROFBATCHES);
+            prof->libmCycles[st] = medianOf(batchCycles, PROFBATCHES);
+        }
+    }
+}
+
+/**
+ * Prints a profile as a table of stages, and a line saying whether the run was mostly trig, branch misses, or output.
+ * Each stage's counts have the calibrated cost of its stage changes taken out. libm shares are estimated from the
+ * number of libm calls each stage made and replayLibm's cost per call.
+ *
+ *  Inputs:
+ * pointer out: stream to print to
+ * prof: the profile
+ *
+ *  Output:
+ * None
+ **/
+void printProfile(FILE *out, const Profile *prof)
+{
+    const char *names[NUMSTAGES] = {"other", "ephemeris", "convergence", "polar", "enumeration", "output"}; // stage names
+    const char *bounds[3] = {"trig-bound", "branch-bound", "I/O-bound"}; // verdicts
+    double counts[NUMSTAGES][NUMCOUNTERS]; // counts without stage changes
+    double ns[NUMSTAGES];                  // time without stage changes (ns)
+    double totals[NUMCOUNTERS] = {0};      // counts over all stages
+    double totalNs = 0;                    // time over all stages (ns)
+    double stageLibmNs[NUMSTAGES] = {0};   // estimated time in libm in each stage (ns)
+    double libmNs = 0;                     // estimated time in libm over all stages (ns)
+    double shares[3];                      // trig, branch miss, and output shares of the run
+    char missShare[16];                    // branch miss share as printed
+    int bound = 0;                         // largest share
+    int have[NUMCOUNTERS];                 // whether each counter was measured
+    long totalEntries = 0;                 // times any stage was entered
+
+    for (int c = 0; c < NUMCOUNTERS; c++)
+    {
+        have[c] = prof->slots[c] >= 0;
+    }
+    for (int st = 0; st < NUMSTAGES; st++)
+    {
+        for (int c = 0; c < NUMCOUNTERS; c++)
+        {
+            counts[st][c] = fmax(prof->counts[st][c] - prof->charges[st] * prof->changeCounts[c], 0);
+            totals[c] += counts[st][c];
+        }
+        ns[st] = fmax(prof->ns[st] - prof->charges[st] * prof->changeNs, 0);
+        totalNs += ns[st];
+        totalEntries += prof->entries[st];
+        // in cycles if there are counters, as they don't change with the clock speed between the run and the replay
+        stageLibmNs[st] = prof->libmCalls[st] * (have[PROFCYCLES] && counts[st][PROFCYCLES] > 0 ?
+                                                 prof->libmCycles[st] / counts[st][PROFCYCLES] * ns[st] : prof->libmNs[st]);
+        libmNs += stageLibmNs[st];
+    }
+
+    if (!prof->numOpen)
+    {
+        fprintf(out, "hardware counters unavailable, timing only\n");
+    }
+    fprintf(out, "%-12s %10s %10s %6s %10s %10s %5s %8s %8s %6s\n", "stage", "entries", "ms", "time%", "Mcycles",
+            "Minstr", "IPC", "brmiss/k", "cmiss/k", "libm%");
+    for (int st = 0; st <= NUMSTAGES; st++)
+    {
+        const double *c = st < NUMSTAGES ? counts[st] : totals; // the row's counts
+        double rowNs = st < NUMSTAGES ? ns[st] : totalNs;        // the row's time
+        double rowLibm = st < NUMSTAGES ? stageLibmNs[st] : libmNs; // the row's time in libm
+
+        fprintf(out, "%-12s %10ld %10.2f %5.1f%%", st < NUMSTAGES ? names[st] : "total",
+                st < NUMSTAGES ? prof->entries[st] : totalEntries, rowNs / 1e6, totalNs > 0 ? 100 * rowNs / totalNs : 0);
+        if (have[PROFCYCLES] && have[PROFINSTRS])
+        {
+            fprintf(out, " %10.2f %10.2f %5.2f", c[PROFCYCLES] / 1e6, c[PROFINSTRS] / 1e6,
+                    c[PROFCYCLES] > 0 ? c[PROFINSTRS] / c[PROFCYCLES] : 0);
+        }
+        else
+        {
+            fprintf(out, " %10s %10s %5s", "n/a", "n/a", "n/a");
+        }
+        for (int k = PROFBRANCHMISS; k <= PROFCACHEMISS; k++)
+        {
+            if (have[k] && have[PROFINSTRS])
+            {
+                fprintf(out, " %8.2f", c[PROFINSTRS] > 0 ? 1000 * c[k] / c[PROFINSTRS] : 0);
+            }
+            else
+            {
+                fprintf(out, " %8s", "n/a");
+            }
+        }
+        fprintf(out, " %5.1f%%\n", rowNs > 0 ? fmin(100 * rowLibm / rowNs, 100) : 0);
+    }
+
+    // a branch miss costs roughly PROFMISSCYCLES cycles of refetch
+    shares[0] = totalNs > 0 ? libmNs / totalNs : 0;
+    shares[1] = have[PROFCYCLES] && have[PROFBRANCHMISS] && totals[PROFCYCLES] > 0 ? PROFMISSCYCLES * totals[PROFBRANCHMISS] / totals[PROFCYCLES] : 0;
+    shares[2] = totalNs > 0 ? ns[PROFOUTPUT] / totalNs : 0;
+    for (int k = 1; k < 3; k++)
+    {
+        bound = shares[k] > shares[bound] ? k : bound;
+    }
+    snprintf(missShare, sizeof(missShare), have[PROFCYCLES] && have[PROFBRANCHMISS] ? "%.0f%%" : "n/a", 100 * shares[1]);
+    fprintf(out, "%s: trig %.0f%%, branch misses %s, output %.0f%% of the time\n", bounds[bound], 100 * shares[0], missShare,
+            100 * shares[2]);
+}
+
+// TRACK FUNCTIONS
+
+/**
+ * Starts a track with no samples
+ *
+ *  Inputs:
+ * pointer track: the track
+ * epochUnits: units per day of the timestamps
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void initTrack(TrackState *track, int64_t epochUnits)
+{
+    initLightCache(&track->cache);
+    track->epochUnits = epochUnits;
+    track->sinRise = sind(TWILIGHTANGLE);
+    track->nodesPerUnit = (double)SECINDAY / LIGHTNODESEC / epochUnits;
+    track->stepUnits = (double)epochUnits * TRACKSTEPSEC / SECINDAY;
+    track->tolUnits = (double)epochUnits * TRACKTOLSEC / SECINDAY;
+    track->numSamples = 0;
+    track->numEvals = 0;
+}
+
+/**
+ * Interpolates the observer's position along the track's latest segment. Latitude and longitude are interpolated
+ * linearly, the longitude the short way round, which is close to the great circle over the distance between samples.
+ *
+ *  Inputs:
+ * track: the track
+ * time: timestamp within the segment
+ * pointer latitude: variable in which to store the North/South component of position
+ * pointer longitude: variable in which to store the East/west component of position, in [-180, 180)
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void trackPosition(const TrackState *track, double time, double *latitude, double *longitude)
+{
+    double frac;    // fraction of the segment before time
+    double lonStep; // change in longitude over the segment, the short way round (deg)
+
+    if (time == track->time[1])
+    {
+        // the end of every walk, and for densely sampled tracks nearly every call
+        *latitude = track->latitude[1];
+        *longitude = track->longitude[1];
+        return;
+    }
+    frac = track->time[1] > track->time[0] ? (time - track->time[0]) / (track->time[1] - track->time[0]) : 0;
+    lonStep = track->longitude[1] - track->longitude[0];
+    lonStep -= 360 * floor((lonStep + 180) / 360);
+    *latitude = track->latitude[0] + frac * (track->latitude[1] - track->latitude[0]);
+    *longitude = track->longitude[0] + frac * lonStep;
+    *longitude -= 360 * floor((*longitude + 180) / 360);
+}
+
+/**
+ * Calculates sin(altitude) - sin(TWILIGHTANGLE) for an observer, positive while the sun is up. The declination and
+ * equation of time are interpolated between the cached hourly ephemeris nodes, as in classifyLight.
+ *
+ *  Inputs:
+ * pointer track: the track, whose cache holds the nodes
+ * latitude: North/South component of position
+ * longitude: East/west component of position
+ * time: timestamp, in the track's units
+ *
+ *  Output:
+ * sin(altitude) - sin(TWILIGHTANGLE)
+ **/
+double trackAltArg(TrackState *track, double latitude, double longitude, double time)
+{
+    double nodeTime;     // time in nodes
+    int64_t node;        // node at or before time
+    double frac;         // fraction of the way to the next node
+    const LightNode *lo; // node at or before time
+    const LightNode *hi; // node after lo
+    double hourAngle;    // hour angle (deg)
+
+    nodeTime = time * track->nodesPerUnit;
+    node = (int64_t)nodeTime;
+    node -= node > nodeTime;
+    frac = nodeTime - node;
+    lo = lightNode(&track->cache, node);
+    hi = lightNode(&track->cache, node + 1);
+    // true solar time / 4 - 180, as altArg
+    hourAngle = ((double)((node % (HRSINDAY * SECINHR / LIGHTNODESEC) + HRSINDAY * SECINHR / LIGHTNODESEC) %
+                          (HRSINDAY * SECINHR / LIGHTNODESEC)) * LIGHTNODESEC / SECINMIN + lo->eqTime +
+                 frac * ((double)LIGHTNODESEC / SECINMIN + hi->eqTime - lo->eqTime)) / 4 - 180 + longitude;
+    track->numEvals++;
+
+    return polyCosd(latitude - 90) * (lo->sinDec + frac * (hi->sinDec - lo->sinDec)) +
+           polyCosd(latitude) * (lo->cosDec + frac * (hi->cosDec - lo->cosDec)) * polyCosd(hourAngle) - track->sinRise;
+}
+
+/**
+ * Adds a sample to the end of a track, starting a new segment from the last sample. The events in the segment are
+ * then produced by nextTrackEvent, which must be called until it returns 0 before the next sample is added.
+ *
+ *  Inputs:
+ * pointer track: the track
+ * latitude: North/South component of the sample's position
+ * longitude: East/west component of the sample's position
+ * time: the sample's timestamp. Must be later than the last sample's
+ *
+ *  Output:
+ * 1 if the sample was added, 0 if it isn't later than the last sample
+ **/
+int addTrackSample(TrackState *track, double latitude, double longitude, double time)
+{
+    if (track->numSamples > 0 && time <= track->time[1])
+    {
+        return 0;
+    }
+
+    if (track->numSamples++ == 0)
+    {
+        track->latitude[1] = latitude;
+        track->longitude[1] = longitude;
+        track->time[1] = time;
+        track->walkArg = trackAltArg(track, latitude, longitude, time);
+    }
+    // the walk was left at the end of the last segment, which is where this one starts
+    track->latitude[0] = track->latitude[1];
+    track->longitude[0] = track->longitude[1];
+    track->time[0] = track->time[1];
+    track->latitude[1] = latitude;
+    track->longitude[1] = longitude;
+    track->time[1] = time;
+    track->walkTime = track->time[0];
+
+    return 1;
+}
+
+/**
+ * Produces the next sunrise or sunset in a track's latest segment. The segment is walked in steps of at most
+ * TRACKSTEPSEC, so that a long gap between samples can't hide a sunset and the following sunrise, and a step whose ends
+ * have the sun on different sides of TWILIGHTANGLE is narrowed down to TRACKTOLSEC by regula falsi (Illinois). Two
+ * events within one step, which only happens when the sun barely grazes the horizon, are both missed.
+ *
+ *  Inputs:
+ * pointer track: the track
+ * pointer event: variable in which to store the event
+ *
+ *  Output:
+ * 1 if an event was produced, 0 if the segment is finished
+ **/
+int nextTrackEvent(TrackState *track, TrackEvent *event)
+{
+    double stepEnd;   // end of the current step
+    double endArg;    // trackAltArg at stepEnd
+    double lo;        // start of the event's bracket
+    double hi;        // end of the event's bracket
+    double loArg;     // trackAltArg at lo, halved when hi moved twice in a row
+    double hiArg;     // trackAltArg at hi, halved when lo moved twice in a row
+    double mid;       // point tried within the bracket
+    double midArg;    // trackAltArg at mid
+    int lastMoved;    // which end of the bracket moved last: -1 lo, 1 hi, 0 neither
+    double latitude;  // North/South component of position at a point tried
+    double longitude; // East/west component of position at a point tried
+
+    while (track->walkTime < track->time[1])
+    {
+        stepEnd = fmin(track->walkTime + track->stepUnits, track->time[1]);
+        trackPosition(track, stepEnd, &latitude, &longitude);
+        endArg = trackAltArg(track, latitude, longitude, stepEnd);
+        if ((endArg > 0) == (track->walkArg > 0))
+        {
+            track->walkTime = stepEnd;
+            track->walkArg = endArg;
+            continue;
+        }
+
+        lo = track->walkTime;
+        loArg = track->walkArg;
+        hi = stepEnd;
+        hiArg = endArg;
+        lastMoved = 0;
+        for (int i = 0; i < TRACKMAXITERS && hi - lo > track->tolUnits; i++)
+        {
+            mid = lo + (hi - lo) * loArg / (loArg - hiArg);
+            trackPosition(track, mid, &latitude, &longitude);
+            midArg = trackAltArg(track, latitude, longitude, mid);
+            if ((midArg > 0) == (loArg > 0))
+            {
+                lo = mid;
+                loArg = midArg;
+                hiArg /= lastMoved == -1 ? 2 : 1;
+                lastMoved = -1;
+            }
+            else
+            {
+                hi = mid;
+                hiArg = midArg;
+                loArg /= lastMoved == 1 ? 2 : 1;
+                lastMoved = 1;
+            }
+        }
+
+        event->type = endArg > 0 ? 1 : 3;
+        event->time = lo + (hi - lo) * loArg / (loArg - hiArg);
+        trackPosition(track, event->time, &event->latitude, &event->longitude);
+        track->walkTime = stepEnd;
+        track->walkArg = endArg;
+        return 1;
+    }
+
+    return 0;
+}
+
+// TIME-MAJOR EVENT FUNCTIONS
+
+/**
+ * Tests a sign by copying it, with no comparison, so that loops of it vectorize. Masks made with comparisons get
+ * turned back into branches, which the vectorizer can't if-convert around floating point arithmetic
+ *
+ *  Inputs:
+ * v: number
+ *
+ *  Output:
+ * 1 if v is positive or +0, 0 if it's negative or -0
+ **/
+static inline double nonNegMask(double v)
+{
+    return copysign(0.5, v) + 0.5;
+}
+
+/**
+ * Square root by Newton's method from a bit-level first guess, with no library calls, so that loops of it vectorize.
+ * Exact to rounding. Inline, for the same reason as polyCosd.
+ *
+ *  Inputs:
+ * x: number, from 0 to 1e300
+ *
+ *  Output:
+ * Square root of x
+ **/
+static inline double polySqrt(double x)
+{
+    uint64_t bits; // bits of x, then of the first guess
+    double r;      // 1 / sqrt(x)
+
+    // 1e-300 keeps the guess for 0 from overflowing, and is lost in rounding for anything else
+    x += 1e-300;
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5FE6EB50C7B537A9ULL - (bits >> 1);
+    memcpy(&r, &bits, sizeof(r));
+    // each step squares the relative error, from about 3% to below rounding
+    r *= 1.5 - 0.5 * x * r * r;
+    r *= 1.5 - 0.5 * x * r * r;
+    r *= 1.5 - 0.5 * x * r * r;
+    r *= 1.5 - 0.5 * x * r * r;
+
+    return x * r;
+}
+
+/**
+ * Arccosine in degrees by series, with no library calls, so that loops of it vectorize. Accurate to about 1e-12.
+ * Inline, for the same reason as polyCosd.
+ *
+ *  Inputs:
+ * x: cosine. Values outside [-1, 1] are clamped
+ *
+ *  Output:
+ * acos(x) (deg)
+ **/
+static inline double polyAcosd(double x)
+{
+    double a;     // |x|, at most 1
+    double small; // 1 if a is at most 0.5, 0 if not
+    double y;     // argument of the arcsine series, at most 0.5
+    double z;     // y squared
+    double s;     // arcsine of y (deg)
+    double c;     // arccosine of a (deg)
+
+    a = fabs(x);
+    a -= nonNegMask(a - 1) * (a - 1);
+    small = nonNegMask(0.5 - a);
+    // acos(a) = 2 * asin(sqrt((1 - a) / 2)) keeps the series' argument small near 1. Blended rather than branched on
+    y = small * a + (1 - small) * polySqrt((1 - a) / 2);
+    z = y * y;
+    s = y * RAD2DEG * (1 + z * (1.0 / 6 + z * (3.0 / 40 + z * (5.0 / 112 + z * (35.0 / 1152 + z * (63.0 / 2816 +
+        z * (231.0 / 13312 + z * (143.0 / 10240 + z * (6435.0 / 557056 + z * (12155.0 / 1245184 +
+        z * (46189.0 / 5505024 + z * (88179.0 / 12058624 + z * (676039.0 / 104857600 + z * (1300075.0 / 226492416 +
+        z * (5014575.0 / 973078528 + z * (9694845.0 / 2080374784 + z * (100180065.0 / 23622320128 +
+        z * (116680311.0 / 30064771072 + z * (2268783825.0 / 635655159808)))))))))))))))))));
+    c = small * (90 - s) + (1 - small) * 2 * s;
+
+    return c + (1 - nonNegMask(x)) * (180 - 2 * c);
+}
+
+/**
+ * Empties the lanes of the time-major calcEvent kernel and zeroes their counts
+ *
+ *  Inputs:
+ * pointer lanes: the lanes
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void initSpanLanes(SpanLanes *lanes)
+{
+    memset(lanes, 0, sizeof(SpanLanes));
+    for (int k = 0; k < SPANLANES; k++)
+    {
+        lanes->task[k] = -1;
+    }
+}
+
+/**
+ * Calculates calcEvent for each of a run of consecutive days at one site, vectorized across the days. The days are
+ * done SPANBLOCK at a time. Each day's two passes (from the beginning and from the end of the day) are handed out to
+ * SPANLANES lanes, and a vectorized sweep takes every lane one calcEventApprox step, with calcSunPos's terms by
+ * polynomial. A lane whose fixed point has stopped is masked out of the sweep and, before the next one, is given the
+ * next pass, so the lanes stay full while slow days near the polar day/night limits converge. Where the vectorized
+ * terms' rounding could change an answer's minute or a stopping decision (an answer within SPANGUARD of a half minute,
+ * or the sun within SPANEDGE of only just rising), the day is redone by calcEvent, so the answers are calcEvent's.
+ *
+ *  Inputs:
+ * pointer lanes: the lanes, whose counts are added to
+ * startJDate: Julian date of the first day. Must be the beginning of a day
+ * numDays: number of days
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ * event: 1 sunrise, 2 solar noon, 3 sunset
+ * pointer times: array of numDays in which to store each day's event as calcEvent would return it
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void calcEventSpan(SpanLanes *lanes, double startJDate, int numDays, double tZ, double longitude, double latitude,
+                   int event, double *times)
+{
+    double beginAns[SPANBLOCK]; // each day's answer from the beginning of the day
+    double endAns[SPANBLOCK];   // each day's answer from the end of the day
+    double redo[SPANBLOCK];     // nonzero for days that have to be redone by calcEvent
+    double properTimeZone;      // the time zone if it were perfect, as calcEvent
+    double riseSec;             // sin(TWILIGHTANGLE) / cos(latitude)
+    double tanLat;              // tangent of the latitude
+    double side;                // -1 sunrise, 0 solar noon, 1 sunset: sign of the hour angle in the answer
+    double finalAns;            // a day's answer
+    double minute;              // a day's answer in minutes
+    int numBlock;               // days in the current block
+    int nextTask;               // next pass to hand out, day * 2 + pass
+    int numBusy;                // lanes with a pass
+
+    properTimeZone = longitude / 15;
+    riseSec = sind(TWILIGHTANGLE) / cosd(latitude);
+    tanLat = tand(latitude);
+    side = event - 2;
+
+    for (int first = 0; first < numDays; first += SPANBLOCK)
+    {
+        numBlock = numDays - first < SPANBLOCK ? numDays - first : SPANBLOCK;
+        for (int d = 0; d < numBlock; d++)
+        {
+            redo[d] = 0;
+        }
+        nextTask = 0;
+
+        while (1)
+        {
+            // hand back the answers of lanes that have stopped, and give them the next pass
+            numBusy = 0;
+            for (int k = 0; k < SPANLANES; k++)
+            {
+                if (lanes->task[k] >= 0 && lanes->active[k] == 0)
+                {
+                    if (lanes->task[k] % 2 == 0)
+                    {
+                        beginAns[lanes->task[k] / 2] = lanes->ans[k];
+                    }
+                    else
+                    {
+                        endAns[lanes->task[k] / 2] = lanes->ans[k];
+                    }
+                    redo[lanes->task[k] / 2] += lanes->close[k];
+                    lanes->task[k] = -1;
+                }
+                if (lanes->task[k] < 0 && nextTask < 2 * numBlock)
+                {
+                    lanes->task[k] = nextTask;
+                    lanes->jDate[k] = startJDate + first + nextTask / 2;
+                    lanes->ans[k] = nextTask % 2 == 0 ? BEGINDAY : ENDDAY;
+                    lanes->iters[k] = 0;
+                    lanes->active[k] = 1;
+                    lanes->close[k] = 0;
+                    nextTask++;
+                }
+                numBusy += lanes->task[k] >= 0;
+            }
+            if (numBusy == 0)
+            {
+                break;
+            }
+            lanes->numSweeps++;
+            lanes->numSteps += numBusy;
+
+            OMP(simd)
+            for (int k = 0; k < SPANLANES; k++)
+            {
+                double jCent;       // Julian century of the lane's instant
+                double meanLong;    // geometric mean longitude of the sun (deg)
+                double meanAnom;    // geometric mean anomaly of the sun (deg)
+                double sinAnom;     // sine of the mean anomaly
+                double cosAnom;     // cosine of the mean anomaly
+                double sin2Long;    // sine of twice the mean longitude
+                double cos2Long;    // cosine of twice the mean longitude
+                double eccent;      // Earth orbit eccentricity
+                double appLong;     // apparent longitude of the sun (deg)
+                double omega;       // longitude of the moon's ascending node, for nutation (deg)
+                double obliq;       // corrected obliquity of the ecliptic (deg)
+                double cosObliq;    // cosine of the obliquity
+                double varY;        // tan^2(obliq / 2)
+                double sinDec;      // sine of the declination
+                double cosDec;      // cosine of the declination
+                double eqOfTime;    // equation of time (minutes)
+                double funcArg;     // cosine of the hour angle of the event
+                double next;        // the lane's next answer
+                double nextMinute;  // next, rounded to the minute (minutes)
+                double moving;      // 1 if the fixed point hasn't stopped after this step, 0 if it has
+
+                // calcSunPos at the lane's day plus its answer. The multiple angles come from the double and triple
+                // angle formulas rather than more polynomials
+                jCent = (lanes->jDate[k] + lanes->ans[k] - JDATE2000 - 1) / JULCENTURY;
+                meanLong = 280.46646 + jCent * (36000.76983 + jCent * 0.0003032);
+                meanAnom = 357.52911 + jCent * (35999.05029 - 0.0001537 * jCent);
+                sinAnom = polyCosd(meanAnom - 90);
+                cosAnom = polyCosd(meanAnom);
+                sin2Long = polyCosd(2 * meanLong - 90);
+                cos2Long = polyCosd(2 * meanLong);
+                eccent = 0.016708634 - jCent * (0.000042037 + 0.0000001267 * jCent);
+                omega = 125.04 - 1934.136 * jCent;
+                appLong = meanLong + sinAnom * (1.914602 - jCent * (0.004817 + 0.000014 * jCent)) +
+                          2 * sinAnom * cosAnom * (0.019993 - 0.000101 * jCent) + sinAnom * (3 - 4 * sinAnom * sinAnom) * 0.000289 -
+                          0.00569 - 0.00478 * polyCosd(omega - 90);
+                obliq = (HRSINDAY - 1) + (26 + ((21.448 - jCent * (46.815 + jCent * (0.00059 - jCent * 0.001813)))) / MININHR) / MININHR +
+                        0.00256 * polyCosd(omega);
+                sinDec = polyCosd(obliq - 90) * polyCosd(appLong - 90);
+                cosDec = polySqrt(1 - sinDec * sinDec);
+                cosObliq = polyCosd(obliq);
+                varY = (1 - cosObliq) / (1 + cosObliq);
+                eqOfTime = 4 * RAD2DEG * (varY * sin2Long - 2 * eccent * sinAnom + 4 * eccent * varY * sinAnom * cos2Long -
+                                          0.5 * varY * varY * 2 * sin2Long * cos2Long - 1.25 * eccent * eccent * 2 * sinAnom * cosAnom);
+
+                // calcEventApprox's event, -100 if the sun doesn't rise or set
+                funcArg = (riseSec - tanLat * sinDec) / cosDec;
+                next = (720 - 4.0 * longitude - eqOfTime + properTimeZone * MININHR) / (HRSINDAY * MININHR) +
+                       side * polyAcosd(funcArg) * 4.0 / (HRSINDAY * MININHR);
+                next -= nonNegMask(fabs(funcArg) - 1) * (next + 100);
+
+                // calcEvent's stopping rule, as masks. The minutes are whole numbers, and rounding half to even
+                // differs from round only at a half minute, which is too close to call anyway
+                nextMinute = (next * (HRSINDAY * MININHR) + ROUNDMAGIC) - ROUNDMAGIC;
+                moving = nonNegMask(next + 1) * nonNegMask(2 - next) *
+                         nonNegMask(fabs(nextMinute - ((lanes->ans[k] * (HRSINDAY * MININHR) + ROUNDMAGIC) - ROUNDMAGIC)) - 0.5) *
+                         nonNegMask(fabs(next - lanes->ans[k]) - EVENTTOL) * nonNegMask(MAXEVENTITER - 1.5 - lanes->iters[k]);
+                lanes->close[k] += lanes->active[k] *
+                                   (nonNegMask(fabs(next * (HRSINDAY * MININHR) - nextMinute) - (0.5 - SPANGUARD * HRSINDAY * MININHR)) +
+                                    nonNegMask(SPANEDGE - fabs(fabs(funcArg) - 1)));
+                lanes->ans[k] += lanes->active[k] * (next - lanes->ans[k]);
+                lanes->iters[k] += lanes->active[k];
+                lanes->active[k] *= moving;
+            }
+        }
+
+        for (int d = 0; d < numBlock; d++)
+        {
+            finalAns = fmax(endAns[d], beginAns[d]) - properTimeZone / HRSINDAY + tZ / HRSINDAY;
+            minute = finalAns * HRSINDAY * MININHR;
+            if (redo[d] > 0 || (finalAns >= -1 && fabs(minute - round(minute)) > 0.5 - SPANGUARD * HRSINDAY * MININHR))
+            {
+                finalAns = calcEvent(startJDate + first + d, tZ, longitude, latitude, event);
+                lanes->numRedone++;
+            }
+            times[first + d] = finalAns;
+        }
+    }
+}
+
+// TILE SERVICE FUNCTIONS
+
+/**
+ * Names a tile layer, as it appears in tile paths
+ *
+ *  Inputs:
+ * layer: TILERISE, TILESET, or TILELENGTH
+ *
+ *  Output:
+ * The layer's name
+ **/
+const char *tileLayerName(int layer)
+{
+    static const char *layerNames[NUMTILELAYERS] = {"rise", "set", "length"}; // names by layer
+
+    return layerNames[layer];
+}
+
+/**
+ * Finds the latitude of a row of samples on the Web Mercator pyramid. Samples are at the north-west corner of their
+ * pixel, so row 2r at one zoom is the same double as row r at the zoom above it.
+ *
+ *  Inputs:
+ * zoom: zoom level
+ * row: row of pixels, counted from 0 at the north edge of the world
+ *
+ *  Output:
+ * Latitude (deg)
+ **/
+double tileLatitude(int zoom, long row)
+{
+    return atan(sinh(M_PI * (1 - 2.0 * row / ((double)TILESIZE * (1L << zoom))))) * RAD2DEG;
+}
+
+/**
+ * Finds the longitude of a column of samples on the Web Mercator pyramid, as tileLatitude
+ *
+ *  Inputs:
+ * zoom: zoom level
+ * column: column of pixels, counted from 0 at 180°W
+ *
+ *  Output:
+ * Longitude (deg)
+ **/
+double tileLongitude(int zoom, long column)
+{
+    return 360.0 * column / ((double)TILESIZE * (1L << zoom)) - LONGRANGE;
+}
+
+/**
+ * Calculates a tile with the grid engine. Every pixel shares the date's ephemeris terms, and every pixel of a row its
+ * latitude terms. Rise and set are UTC minutes after midnight as grid mode writes them (NaN where the event doesn't
+ * happen); length is the minutes of sunlight in the solar day, as stats mode counts them.
+ *
+ *  Inputs:
+ * key: the tile
+ * pixels: array of TILEPIXELS values to fill, row by row from the north-west corner
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void computeTile(const TileKey *key, float *pixels)
+{
+    DateEphem eph;    // the date's ephemeris terms
+    double latitude;  // latitude of the current row
+    double longitude; // longitude of the current column
+    double secLat;    // 1 / cos(latitude)
+    double tanLat;    // tangent of the latitude
+    double rise;      // sunrise (decimal day, local solar time). Less than -1 if it doesn't happen or isn't needed
+    double set;       // sunset (decimal day, local solar time). Less than -1 if it doesn't happen or isn't needed
+    double eventTime; // the layer's event (decimal day, local solar time)
+    float *out;       // the current pixel
+
+    calcDateEphem(&eph, calcJDate(key->date % 100, key->date / 100 % 100, key->date / 10000, 0));
+    for (int j = 0; j < TILESIZE; j++)
+    {
+        latitude = tileLatitude(key->zoom, (long)key->y * TILESIZE + j);
+        secLat = 1 / cosd(latitude);
+        tanLat = tand(latitude);
+        for (int i = 0; i < TILESIZE; i++)
+        {
+            longitude = tileLongitude(key->zoom, (long)key->x * TILESIZE + i);
+            out = &pixels[j * TILESIZE + i];
+            rise = key->layer == TILESET ? -100 : gridEvent(&eph, secLat, tanLat, 1, NULL);
+            set = key->layer == TILERISE ? -100 : gridEvent(&eph, secLat, tanLat, 3, NULL);
+            if (key->layer == TILELENGTH)
+            {
+                if (rise < -1 && set < -1)
+                {
+                    *out = gridDayStatus(&eph, secLat, tanLat) == 1 ? HRSINDAY * MININHR : 0;
+                }
+                else
+                {
+                    *out = ((set < -1 ? 1 : set) - (rise < -1 ? 0 : rise)) * HRSINDAY * MININHR;
+                }
+            }
+            else
+            {
+                eventTime = key->layer == TILERISE ? rise : set;
+                *out = eventTime < -1 ? NAN : (eventTime - longitude / (15 * HRSINDAY)) * HRSINDAY * MININHR;
+            }
+        }
+    }
+}
+
+/**
+ * Allocates tile mode's memory cache
+ *
+ *  Inputs:
+ * pointer state: the service state to set up
+ * capacity: number of tiles the memory cache holds
+ * cacheDir: directory of the disk cache
+ *
+ *  Output:
+ * 1 if the allocation worked, 0 if not
+ **/
+int initTileState(TileState *state, int capacity, const char *cacheDir)
+{
+    state->capacity = capacity;
+    state->numBuckets = 2 * capacity;
+    state->entries = malloc(capacity * sizeof(TileEntry));
+    state->pixels = malloc((size_t)capacity * TILEPIXELS * sizeof(float));
+    state->buckets = malloc(state->numBuckets * sizeof(int));
+    if (!state->entries || !state->pixels || !state->buckets)
+    {
+        free(state->entries);
+        free(state->pixels);
+        free(state->buckets);
+        return 0;
+    }
+    for (int b = 0; b < state->numBuckets; b++)
+    {
+        state->buckets[b] = -1;
+    }
+    for (int e = 0; e < capacity; e++)
+    {
+        state->entries[e].pixels = state->pixels + (size_t)e * TILEPIXELS;
+    }
+    state->numUsed = 0;
+    state->newest = state->oldest = -1;
+    state->cacheDir = cacheDir;
+    for (int d = 0; d < TILEDATES; d++)
+    {
+        state->popDates[d] = 0;
+        state->popCounts[d] = 0;
+    }
+    state->queueHead = state->queueLen = 0;
+    state->numRequests = state->numPrefetched = state->numErrors = 0;
+    for (int s = 0; s < 4; s++)
+    {
+        state->numSources[s] = 0;
+    }
+    state->computeSec = 0;
+
+    return 1;
+}
+
+/**
+ * Finds the hash bucket of a tile in the memory cache
+ *
+ *  Inputs:
+ * state: the service state
+ * key: the tile
+ *
+ *  Output:
+ * Index of the bucket
+ **/
+int tileBucket(const TileState *state, const TileKey *key)
+{
+    uint64_t hash; // hash of the key
+
+    hash = ((uint64_t)key->date * NUMTILELAYERS + key->layer) * 0x9E3779B97F4A7C15ULL ^ key->zoom;
+    hash = hash * 0x9E3779B97F4A7C15ULL ^ ((uint64_t)key->x << 32 | (uint32_t)key->y);
+    hash *= 0x9E3779B97F4A7C15ULL;
+
+    return (hash >> 32) % state->numBuckets;
+}
+
+/**
+ * Checks whether two keys name the same tile
+ *
+ *  Inputs:
+ * a: a tile
+ * b: another tile
+ *
+ *  Output:
+ * 1 if they're the same, 0 if not
+ **/
+int sameTile(const TileKey *a, const TileKey *b)
+{
+    return a->layer == b->layer && a->date == b->date && a->zoom == b->zoom && a->x == b->x && a->y == b->y;
+}
+
+/**
+ * Takes an entry out of the memory cache's use order
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * e: the entry
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void unlinkTile(TileState *state, int e)
+{
+    TileEntry *entry = &state->entries[e]; // the entry
+
+    if (entry->newer >= 0)
+    {
+        state->entries[entry->newer].older = entry->older;
+    }
+    else
+    {
+        state->newest = entry->older;
+    }
+    if (entry->older >= 0)
+    {
+        state->entries[entry->older].newer = entry->newer;
+    }
+    else
+    {
+        state->oldest = entry->newer;
+    }
+}
+
+/**
+ * Puts an entry at the front of the memory cache's use order
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * e: the entry, which mustn't be in the use order
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void linkNewestTile(TileState *state, int e)
+{
+    state->entries[e].newer = -1;
+    state->entries[e].older = state->newest;
+    if (state->newest >= 0)
+    {
+        state->entries[state->newest].newer = e;
+    }
+    state->newest = e;
+    if (state->oldest < 0)
+    {
+        state->oldest = e;
+    }
+}
+
+/**
+ * Looks a tile up in the memory cache, making it the most recently used if it's there
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * key: the tile
+ *
+ *  Output:
+ * The tile's pixels, or NULL if it isn't cached
+ **/
+float *findCachedTile(TileState *state, const TileKey *key)
+{
+    for (int e = state->buckets[tileBucket(state, key)]; e >= 0; e = state->entries[e].chain)
+    {
+        if (sameTile(&state->entries[e].key, key))
+        {
+            unlinkTile(state, e);
+            linkNewestTile(state, e);
+            return state->entries[e].pixels;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Adds a tile to the memory cache, evicting the least recently used tile if the cache is full
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * key: the tile, which mustn't be cached already
+ * pixels: the tile's pixels
+ *
+ *  Output:
+ * The cached copy of the pixels
+ **/
+float *cacheTile(TileState *state, const TileKey *key, const float *pixels)
+{
+    int e;     // the entry to fill
+    int *link; // link to the evicted entry in its bucket's chain
+
+    if (state->numUsed < state->capacity)
+    {
+        e = state->numUsed++;
+    }
+    else
+    {
+        e = state->oldest;
+        unlinkTile(state, e);
+        for (link = &state->buckets[tileBucket(state, &state->entries[e].key)]; *link != e; link = &state->entries[*link].chain)
+        {
+        }
+        *link = state->entries[e].chain;
+    }
+
+    state->entries[e].key = *key;
+    memcpy(state->entries[e].pixels, pixels, TILEPIXELS * sizeof(float));
+    state->entries[e].chain = state->buckets[tileBucket(state, key)];
+    state->buckets[tileBucket(state, key)] = e;
+    linkNewestTile(state, e);
+
+    return state->entries[e].pixels;
+}
+
+/**
+ * Builds a tile's path in the disk cache: cacheDir/layer/YYYY-MM-DD/zoom/x/y.f32
+ *
+ *  Inputs:
+ * state: the service state
+ * key: the tile
+ * path: array to fill
+ * pathSize: size of the array
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void tilePath(const TileState *state, const TileKey *key, char *path, size_t pathSize)
+{
+    snprintf(path, pathSize, "%s/%s/%04d-%02d-%02d/%d/%d/%d.f32", state->cacheDir, tileLayerName(key->layer),
+             key->date / 10000, key->date / 100 % 100, key->date % 100, key->zoom, key->x, key->y);
+}
+
+/**
+ * Reads a tile from the disk cache
+ *
+ *  Inputs:
+ * state: the service state
+ * key: the tile
+ * pixels: array of TILEPIXELS values to fill
+ *
+ *  Output:
+ * 1 if the tile was there, 0 if not
+ **/
+int readDiskTile(const TileState *state, const TileKey *key, float *pixels)
+{
+    char path[BUFSIZ]; // the tile's file
+    FILE *inFile;      // the tile's file
+    size_t numRead;    // values read
+
+    tilePath(state, key, path, sizeof(path));
+    inFile = fopen(path, "rb");
+    if (!inFile)
+    {
+        return 0;
+    }
+    numRead = fread(pixels, sizeof(float), TILEPIXELS, inFile);
+    fclose(inFile);
+
+    return numRead == TILEPIXELS;
+}
+
+/**
+ * Writes a tile to the disk cache, making its directories as needed. The tile is written to a temporary file and
+ * renamed into place, so a reader never sees part of a tile. Failures only cost the cache entry, so they're ignored.
+ *
+ *  Inputs:
+ * state: the service state
+ * key: the tile
+ * pixels: the tile's pixels
+ *
+ *  Output:
+ * None
+ **/
+void writeDiskTile(const TileState *state, const TileKey *key, const float *pixels)
+{
+    char path[BUFSIZ];         // the tile's file
+    char tmpPath[BUFSIZ + 32]; // the file being written
+    FILE *outFile;             // the file being written
+    size_t numWritten;         // values written
+
+    tilePath(state, key, path, sizeof(path));
+    for (char *slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/'))
+    {
+        *slash = '\0';
+        mkdir(path, 0755);
+        *slash = '/';
+    }
+    snprintf(tmpPath, sizeof(tmpPath), "%s.%d.tmp", path, (int)getpid());
+    outFile = fopen(tmpPath, "wb");
+    if (!outFile)
+    {
+        return;
+    }
+    numWritten = fwrite(pixels, sizeof(float), TILEPIXELS, outFile);
+    if (fclose(outFile) != 0 || numWritten != TILEPIXELS || rename(tmpPath, path) != 0)
+    {
+        unlink(tmpPath);
+    }
+}
+
+/**
+ * Derives a tile from its four children at the next zoom, when they're all in the memory or disk cache. The layers
+ * are point samples at pixel corners, so the tile's samples are exactly every other row and column of its children's
+ * and the result is bit for bit the computed tile. A layer averaged over each pixel couldn't be derived this way.
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * key: the tile
+ * pixels: array of TILEPIXELS values to fill
+ *
+ *  Output:
+ * 1 if the tile was derived, 0 if a child isn't cached
+ **/
+int deriveTile(TileState *state, const TileKey *key, float *pixels)
+{
+    TileKey children[4];     // the tile's children: north-west, north-east, south-west, south-east
+    const float *child;      // the current child's pixels
+    char path[BUFSIZ];       // a child's file in the disk cache
+    int half = TILESIZE / 2; // size of a child's quarter of the tile (pixels)
+
+    if (key->zoom >= TILEMAXZOOM)
+    {
+        return 0;
+    }
+    for (int c = 0; c < 4; c++)
+    {
+        children[c] = *key;
+        children[c].zoom++;
+        children[c].x = 2 * key->x + c % 2;
+        children[c].y = 2 * key->y + c / 2;
+        tilePath(state, &children[c], path, sizeof(path));
+        if (!findCachedTile(state, &children[c]) && access(path, R_OK) != 0)
+        {
+            return 0;
+        }
+    }
+
+    for (int c = 0; c < 4; c++)
+    {
+        child = findCachedTile(state, &children[c]);
+        if (!child)
+        {
+            if (!readDiskTile(state, &children[c], state->child))
+            {
+                return 0;
+            }
+            child = state->child;
+        }
+        for (int j = 0; j < half; j++)
+        {
+            for (int i = 0; i < half; i++)
+            {
+                pixels[(c / 2 * half + j) * TILESIZE + c % 2 * half + i] = child[2 * j * TILESIZE + 2 * i];
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Gets a tile from the memory cache, the disk cache, its children, or the grid engine, in that order. Tiles that
+ * weren't on disk are written there, and every tile ends up in the memory cache.
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * key: the tile
+ * pointer source: variable in which to store where the tile came from: TILEMEMORY, TILEDISK, TILEDERIVED, or
+ *                 TILECOMPUTED
+ *
+ *  Output:
+ * The tile's pixels, valid until the next tile is cached
+ **/
+const float *getTile(TileState *state, const TileKey *key, int *source)
+{
+    const float *pixels;   // the cached tile
+    struct timespec start; // when the calculation started
+
+    pixels = findCachedTile(state, key);
+    if (pixels)
+    {
+        *source = TILEMEMORY;
+        return pixels;
+    }
+
+    if (readDiskTile(state, key, state->scratch))
+    {
+        *source = TILEDISK;
+    }
+    else
+    {
+        if (deriveTile(state, key, state->scratch))
+        {
+            *source = TILEDERIVED;
+        }
+        else
+        {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            computeTile(key, state->scratch);
+            state->computeSec += elapsedSec(&start);
+            *source = TILECOMPUTED;
+        }
+        writeDiskTile(state, key, state->scratch);
+    }
+
+    return cacheTile(state, key, state->scratch);
+}
+
+/**
+ * Counts a request for a date, and queues the date's coarse tiles for prefetching the time it becomes popular. The
+ * finest prefetched zoom is queued first, so every coarser tile is derived from tiles already cached.
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * date: the requested date as YYYYMMDD
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void countTileDate(TileState *state, int date)
+{
+    int slot = date % TILEDATES; // the date's counter, which may be counting another date
+    TileKey key;                 // a tile to prefetch
+
+    if (state->popDates[slot] != date)
+    {
+        state->popDates[slot] = date;
+        state->popCounts[slot] = 0;
+    }
+    if (++state->popCounts[slot] != TILEPOPULAR)
+    {
+        return;
+    }
+
+    key.date = date;
+    for (key.zoom = TILEPREFETCHZOOM; key.zoom >= 0; key.zoom--)
+    {
+        for (key.layer = 0; key.layer < NUMTILELAYERS; key.layer++)
+        {
+            for (key.y = 0; key.y < 1 << key.zoom; key.y++)
+            {
+                for (key.x = 0; key.x < 1 << key.zoom && state->queueLen < TILEQUEUE; key.x++)
+                {
+                    state->queue[(state->queueHead + state->queueLen++) % TILEQUEUE] = key;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Prefetches the next queued tile, unless it's already in the memory cache
+ *
+ *  Inputs:
+ * pointer state: the service state, with at least one tile queued
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void prefetchTile(TileState *state)
+{
+    TileKey key = state->queue[state->queueHead]; // the tile
+    int source;                                   // where the tile came from
+
+    state->queueHead = (state->queueHead + 1) % TILEQUEUE;
+    state->queueLen--;
+    if (!findCachedTile(state, &key))
+    {
+        getTile(state, &key, &source);
+        state->numPrefetched++;
+    }
+}
+
+/**
+ * Parses a tile request path: /layer/YYYY-MM-DD/zoom/x/y, optionally ending in .f32
+ *
+ *  Inputs:
+ * path: the request path
+ * pointer key: variable in which to store the tile
+ *
+ *  Output:
+ * 1 if the path names a tile, 0 if not
+ **/
+int parseTilePath(const char *path, TileKey *key)
+{
+    char layerName[16]; // layer name
+    int year;           // year
+    int month;          // month of the year
+    int day;            // day of the month
+    int length = 0;     // characters parsed
+
+    if (sscanf(path, "/%15[a-z]/%d-%d-%d/%d/%d/%d%n", layerName, &year, &month, &day, &key->zoom, &key->x, &key->y,
+               &length) != 7 ||
+        (path[length] != '\0' && strcmp(path + length, ".f32") != 0))
+    {
+        return 0;
+    }
+    for (key->layer = 0; key->layer < NUMTILELAYERS && strcmp(layerName, tileLayerName(key->layer)) != 0; key->layer++)
+    {
+    }
+    if (key->layer == NUMTILELAYERS || year < 1 || year > 9999 || month < 1 || month > NUMMONTHS || day < 1 ||
+        day > monthLen(month, year) || key->zoom < 0 || key->zoom > TILEMAXZOOM || key->x < 0 ||
+        key->x >= 1 << key->zoom || key->y < 0 || key->y >= 1 << key->zoom)
+    {
+        return 0;
+    }
+    key->date = year * 10000 + month * 100 + day;
+
+    return 1;
+}
+
+/**
+ * Sends all of a buffer on a socket. A client that has gone away just loses the rest of its answer.
+ *
+ *  Inputs:
+ * fd: the socket
+ * data: the buffer
+ * size: size of the buffer (bytes)
+ *
+ *  Output:
+ * None
+ **/
+void sendAll(int fd, const void *data, size_t size)
+{
+    ssize_t numSent; // bytes sent by one call
+
+    while (size > 0)
+    {
+        numSent = send(fd, data, size, MSG_NOSIGNAL);
+        if (numSent <= 0)
+        {
+            return;
+        }
+        data = (const char *)data + numSent;
+        size -= numSent;
+    }
+}
+
+/**
+ * Prints tile mode's counters
+ *
+ *  Inputs:
+ * outFile: where to print them
+ * state: the service state
+ *
+ *  Output:
+ * None
+ **/
+void printTileStats(FILE *outFile, const TileState *state)
+{
+    fprintf(outFile, "requests %ld memory %ld disk %ld derived %ld computed %ld errors %ld\n", state->numRequests,
+            state->numSources[TILEMEMORY], state->numSources[TILEDISK], state->numSources[TILEDERIVED],
+            state->numSources[TILECOMPUTED], state->numErrors);
+    fprintf(outFile, "prefetched %ld queued %d cached %d of %d compute %.3f s\n", state->numPrefetched, state->queueLen,
+            state->numUsed, state->capacity, state->computeSec);
+}
+
+/**
+ * Answers one HTTP request on a connection, then closes it. GET of a tile path answers the tile's raw float32 pixels,
+ * with its source in an X-Tile-Source header; GET /stats answers the counters as text.
+ *
+ *  Inputs:
+ * pointer state: the service state
+ * fd: the connection
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void serveTileConnection(TileState *state, int fd)
+{
+    static const char *sourceNames[4] = {"memory", "disk", "derived", "computed"}; // names by source
+    char request[BUFSIZ];                                                          // start of the request
+    char path[BUFSIZ];                                                             // request path
+    char header[BUFSIZ];                                                           // response header
+    char *body;                                                                    // text response body
+    size_t bodySize;                                                               // size of the text body (bytes)
+    FILE *bodyFile;                                                                // stream writing the text body
+    size_t length = 0;                                                             // bytes of the request read
+    ssize_t numRead;                                                               // bytes read by one call
+    TileKey key;                                                                   // the requested tile
+    const float *pixels;                                                           // the tile's pixels
+    int source;                                                                    // where the tile came from
+
+    while (length < sizeof(request) - 1 && !memchr(request, '\n', length))
+    {
+        numRead = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+        if (numRead <= 0)
+        {
+            break;
+        }
+        length += numRead;
+    }
+    request[length] = '\0';
+
+    if (sscanf(request, "GET %1023s HTTP/", path) == 1 && strcmp(path, "/stats") == 0)
+    {
+        bodyFile = open_memstream(&body, &bodySize);
+        printTileStats(bodyFile, state);
+        fclose(bodyFile);
+        snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain\r\nContent-Length: %zu\r\n\r\n", bodySize);
+        sendAll(fd, header, strlen(header));
+        sendAll(fd, body, bodySize);
+        free(body);
+    }
+    else if (sscanf(request, "GET %1023s HTTP/", path) == 1 && parseTilePath(path, &key))
+    {
+        countTileDate(state, key.date);
+        pixels = getTile(state, &key, &source);
+        state->numRequests++;
+        state->numSources[source]++;
+        snprintf(header, sizeof(header),
+                 "HTTP/1.0 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Length: %zu\r\n"
+                 "Access-Control-Allow-Origin: *\r\nCache-Control: max-age=86400\r\nX-Tile-Source: %s\r\n\r\n",
+                 TILEPIXELS * sizeof(float), sourceNames[source]);
+        sendAll(fd, header, strlen(header));
+        sendAll(fd, pixels, TILEPIXELS * sizeof(float));
+    }
+    else
+    {
+        state->numErrors++;
+        snprintf(header, sizeof(header), "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n\r\nnot found\n");
+        sendAll(fd, header, strlen(header));
+    }
+    close(fd);
+}
+
+/**
+ * Asks tile mode to stop after the request it's answering
+ *
+ *  Inputs:
+ * sig: the signal
+ *
+ *  Output:
+ * None
+ **/
+void stopTiles(int sig)
+{
+    (void)sig;
+    tilesStopping = 1;
+}
+
+// TERMINATOR FUNCTIONS
+
+/**
+ * Finds the point where the sun is overhead at an instant
+ *
+ *  Inputs:
+ * jDate: Julian date of the instant (fractional days allowed)
+ * pointer latitude: variable in which to store the latitude of the point (the sun's declination)
+ * pointer longitude: variable in which to store the longitude of the point, in [-180, 180]
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void subsolarPoint(double jDate, double *latitude, double *longitude)
+{
+    double eqOfTime; // equation of time (minutes)
+
+    calcSunPos(jDate, latitude, &eqOfTime);
+    *longitude = (HRS12HR * MININHR - (jDate - floor(jDate - 0.5) - 0.5) * HRSINDAY * MININHR - eqOfTime) / 4;
+    *longitude -= 360 * round(*longitude / 360);
+}
+
+/**
+ * Arctangent of y / x in degrees, in the right quadrant, by polynomial, with no library calls, so that loops of it
+ * vectorize. The angle is folded to at most 45°, then halved with the norm of (x, y): tan(a / 2) = y / (x + r), which
+ * leaves the polynomial an argument of at most tan(22.5°). The polynomial interpolates atan(w) / w at the Chebyshev
+ * nodes of that range, which takes 8 terms where the Taylor series takes 14. Accurate to about 3e-11. Inline, for
+ * the same reason as polyCosd.
+ *
+ *  Inputs:
+ * y: sine component
+ * x: cosine component
+ * r: sqrt(x^2 + y^2), which the caller already has
+ *
+ *  Output:
+ * atan2(y, x) (deg)
+ **/
+static inline double polyAtan2d(double y, double x, double r)
+{
+    double u;    // |x|
+    double v;    // |y|
+    double swap; // 1 if v is at least u, so the angle is folded about 45°, 0 if not
+    double w;    // tangent of half the folded angle, at most tan(22.5°)
+    double z;    // w squared
+    double a;    // the angle (deg)
+
+    u = fabs(x);
+    v = fabs(y);
+    swap = nonNegMask(v - u);
+    w = (v + swap * (u - v)) / (u + swap * (v - u) + r);
+    z = w * w;
+    a = 2 * w * RAD2DEG * (0.9999999999992447 + z * (-0.33333333276922494 + z * (0.19999993053555815 +
+        z * (-0.14285386553752139 + z * (0.11103456908947464 + z * (-0.08992552906150912 + z * (0.06974197686595265 +
+        z * -0.03765510601291402)))))));
+    a += swap * (90 - 2 * a);
+    a += (1 - nonNegMask(x)) * (180 - 2 * a);
+
+    return copysign(a, y);
+}
+
+/**
+ * Calculates the line where the sun is at a given altitude at an instant, as a closed ring of vertices. The line is
+ * the small circle of radius 90° - altitude around the subsolar point, so each vertex is placed analytically at an
+ * even step of azimuth around that point, with no search. The circle is symmetric about the subsolar meridian, so
+ * only half of it is calculated and the other half is mirrored. The azimuths come from a table of TERMBLOCK steps by
+ * the angle sum formulas, and the loops have no library calls and vectorize.
+ *
+ *  Inputs:
+ * jDate: Julian date of the instant (fractional days allowed)
+ * altitude: altitude of the sun's centre (deg), in (-90, 0]
+ * numVertices: number of vertices. Must be even
+ * latitude: array of numVertices latitudes to fill
+ * longitude: array of numVertices longitudes to fill, in [-180, 180]
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void calcTerminator(double jDate, double altitude, int numVertices, double *latitude, double *longitude)
+{
+    double cosStep[TERMBLOCK];  // cosines of the first TERMBLOCK azimuths
+    double sinStep[TERMBLOCK];  // sines of the first TERMBLOCK azimuths
+    double subLat;              // latitude of the subsolar point
+    double subLong;             // longitude of the subsolar point
+    double sinSub;              // sine of the subsolar latitude
+    double cosSub;              // cosine of the subsolar latitude
+    double sinAlt;              // sine of the altitude: cosine of the circle's radius
+    double cosAlt;              // cosine of the altitude: sine of the circle's radius
+    double azStep;              // azimuth between vertices, seen from the subsolar point (deg)
+    double cosBase;             // cosine of a block's first azimuth
+    double sinBase;             // sine of a block's first azimuth
+    int half = numVertices / 2; // vertex due south of the subsolar point
+    int blockLen;               // vertices in a block
+
+    subsolarPoint(jDate, &subLat, &subLong);
+    sinSub = sind(subLat);
+    cosSub = cosd(subLat);
+    sinAlt = sind(altitude);
+    cosAlt = cosd(altitude);
+    azStep = 360.0 / numVertices;
+    OMP(simd)
+    for (int j = 0; j < TERMBLOCK; j++)
+    {
+        cosStep[j] = polyCosd(azStep * j);
+        sinStep[j] = polyCosd(azStep * j - 90);
+    }
+
+    // the eastern half, from due north to due south, with longitudes relative to the subsolar meridian
+    for (int b = 0; b <= half; b += TERMBLOCK)
+    {
+        cosBase = cosd(azStep * b);
+        sinBase = sind(azStep * b);
+        blockLen = half + 1 - b < TERMBLOCK ? half + 1 - b : TERMBLOCK;
+        OMP(simd)
+        for (int j = 0; j < blockLen; j++)
+        {
+            double cosAz; // cosine of the vertex's azimuth
+            double x;     // vertex's unit vector towards the subsolar meridian at the equator
+            double y;     // vertex's unit vector towards 90° east of it
+            double z;     // vertex's unit vector towards the north pole
+            double r;     // distance of the vertex from the polar axis: cosine of its latitude
+
+            cosAz = cosBase * cosStep[j] - sinBase * sinStep[j];
+            x = cosSub * sinAlt - sinSub * cosAlt * cosAz;
+            y = cosAlt * (sinBase * cosStep[j] + cosBase * sinStep[j]);
+            z = sinSub * sinAlt + cosSub * cosAlt * cosAz;
+            r = polySqrt(x * x + y * y);
+            latitude[b + j] = polyAtan2d(z, r, 1);
+            longitude[b + j] = polyAtan2d(y, x, r);
+        }
+    }
+
+    // the western half is the mirror image
+    OMP(simd)
+    for (int k = 1; k < half; k++)
+    {
+        double west = subLong - longitude[k]; // longitude of the mirrored vertex
+
+        latitude[numVertices - k] = latitude[k];
+        longitude[numVertices - k] = west - 360 * ((west * (1.0 / 360) + ROUNDMAGIC) - ROUNDMAGIC);
+    }
+    OMP(simd)
+    for (int k = 0; k <= half; k++)
+    {
+        double east = subLong + longitude[k]; // longitude of the vertex
+
+        longitude[k] = east - 360 * ((east * (1.0 / 360) + ROUNDMAGIC) - ROUNDMAGIC);
+    }
+}
+
+/**
+ * Cuts a terminator ring into pieces where it crosses the antimeridian, so no piece has a segment that wraps around
+ * the map. Each cut adds a vertex on both sides of the antimeridian, interpolated along the segment. The circle meets
+ * the antimeridian at most twice: a ring that doesn't cross it is one closed piece; one that crosses it once (the
+ * terminator goes around a pole) is one piece from one side of the map to the other; one that crosses it twice is two
+ * pieces that each start and end on the same side.
+ *
+ *  Inputs:
+ * latitude: the ring's latitudes
+ * longitude: the ring's longitudes, in [-180, 180]
+ * numVertices: number of vertices in the ring
+ * cutLat: array of at least numVertices + 2 * TERMPIECES + 1 latitudes to fill with the pieces, one after another
+ * cutLong: array to fill with the pieces' longitudes, as cutLat
+ * starts: array of TERMPIECES + 1 to fill with where each piece starts in cutLat, and where the last one ends
+ *
+ *  Output:
+ * Number of pieces
+ **/
+int cutTerminator(const double *latitude, const double *longitude, int numVertices, double *cutLat, double *cutLong, int *starts)
+{
+    int first = -1;     // first vertex after a crossing, -1 if there isn't one
+    int numPieces = 0;  // pieces so far
+    int numCut = 0;     // vertices stored so far
+    int k;              // current vertex
+    int next;           // vertex after it
+    double side;        // the antimeridian on the current vertex's side of the map (deg)
+    double wrapped;     // the next vertex's longitude on the current vertex's side of the map (deg)
+    double crossLat;    // latitude where the segment crosses the antimeridian
+
+    for (k = 0; k < numVertices && first < 0; k++)
+    {
+        if (fabs(longitude[(k + 1) % numVertices] - longitude[k]) > LONGRANGE)
+        {
+            first = (k + 1) % numVertices;
+        }
+    }
+    if (first < 0)
+    {
+        memcpy(cutLat, latitude, numVertices * sizeof(double));
+        memcpy(cutLong, longitude, numVertices * sizeof(double));
+        cutLat[numVertices] = latitude[0];
+        cutLong[numVertices] = longitude[0];
+        starts[0] = 0;
+        starts[1] = numVertices + 1;
+        return 1;
+    }
+
+    for (int i = 0; i <= numVertices; i++)
+    {
+        k = (first + numVertices + i - 1) % numVertices;
+        next = (k + 1) % numVertices;
+        if (fabs(longitude[next] - longitude[k]) > LONGRANGE)
+        {
+            side = longitude[k] > 0 ? LONGRANGE : -LONGRANGE;
+            wrapped = longitude[next] + 2 * side;
+            crossLat = latitude[k] + (side - longitude[k]) / (wrapped - longitude[k]) * (latitude[next] - latitude[k]);
+            if (i > 0)
+            {
+                cutLat[numCut] = crossLat;
+                cutLong[numCut++] = side;
+            }
+            if (i == numVertices || numPieces == TERMPIECES)
+            {
+                break;
+            }
+            starts[numPieces++] = numCut;
+            cutLat[numCut] = crossLat;
+            cutLong[numCut++] = -side;
+        }
+        if (i < numVertices)
+        {
+            cutLat[numCut] = latitude[next];
+            cutLong[numCut++] = longitude[next];
+        }
+    }
+    starts[numPieces] = numCut;
+
+    return numPieces;
+}
+
+/**
+ * Prints one band of a terminator as a GeoJSON feature. As polygons, each piece is closed into the region where the
+ * sun is below the band's altitude: a piece that crosses the whole map is closed along the edge of the map at the
+ * pole that's in the dark, and the others are closed on themselves. Rings are printed counterclockwise, as RFC 7946
+ * asks. As lines, the pieces are printed as they are.
+ *
+ *  Inputs:
+ * name: name of the band
+ * altitude: altitude of the band (deg)
+ * subLat: latitude of the subsolar point
+ * cutLat: the pieces' latitudes, from cutTerminator
+ * cutLong: the pieces' longitudes, from cutTerminator
+ * starts: where each piece starts, from cutTerminator
+ * numPieces: number of pieces
+ * lines: 1 to print lines, 0 to print polygons
+ * ringLat: scratch array with room for the longest piece plus 3 vertices
+ * ringLong: scratch array as ringLat
+ *
+ *  Output:
+ * None (pointers)
+ **/
+void printTerminatorFeature(const char *name, double altitude, double subLat, const double *cutLat, const double *cutLong,
+                            const int *starts, int numPieces, int lines, double *ringLat, double *ringLong)
+{
+    double poleLat = subLat > 0 ? -LATRANGE : LATRANGE; // the pole in the dark, when the terminator goes around it
+    double area;                                        // twice the signed area of the ring (deg^2)
+    int numRing;                                        // vertices in the ring
+    int v;                                              // vertex being printed
+
+    printf("{\"type\":\"Feature\",\"properties\":{\"name\":\"%s\",\"altitude\":%g},\"geometry\":{\"type\":\"%s\",\"coordinates\":[",
+           name, altitude, lines ? "MultiLineString" : "MultiPolygon");
+    for (int p = 0; p < numPieces; p++)
+    {
+        numRing = starts[p + 1] - starts[p];
+        memcpy(ringLat, cutLat + starts[p], numRing * sizeof(double));
+        memcpy(ringLong, cutLong + starts[p], numRing * sizeof(double));
+        area = 0;
+        if (!lines)
+        {
+            if (ringLong[0] != ringLong[numRing - 1])
+            {
+                ringLat[numRing] = ringLat[numRing + 1] = poleLat;
+                ringLong[numRing] = ringLong[numRing - 1];
+                ringLong[numRing + 1] = ringLong[0];
+                numRing += 2;
+            }
+            if (ringLat[0] != ringLat[numRing - 1] || ringLong[0] != ringLong[numRing - 1])
+            {
+                ringLat[numRing] = ringLat[0];
+                ringLong[numRing++] = ringLong[0];
+            }
+            // shoelace formula
+            for (int i = 0; i < numRing - 1; i++)
+            {
+                area += ringLong[i] * ringLat[i + 1] - ringLong[i + 1] * ringLat[i];
+            }
+        }
+
+        printf("%s%s[", p > 0 ? "," : "", lines ? "" : "[");
+        for (int i = 0; i < numRing; i++)
+        {
+            v = area < 0 ? numRing - 1 - i : i;
+            printf("%s[%.6f,%.6f]", i > 0 ? "," : "", ringLong[v], ringLat[v]);
+        }
+        printf("]%s", lines ? "" : "]");
+    }
+    printf("]}}");
+}
+
+// LIBRARY FUNCTIONS
+
+/**
+ * Gives the version of the batch interface the library was built with (see solarCalc.h)
+ *
+ *  Inputs:
+ * None
+ *
+ *  Output:
+ * SOLARABIVERSION
+ **/
+int solarAbiVersion(void)
+{
+    return SOLARABIVERSION;
+}
+
+/**
+ * Calculates sunrise, solar noon, and sunset for arrays of sites and dates, exactly as calcEvent does for one. Each
+ * element is independent, so the elements are split between threads in blocks, handed out as threads finish since
+ * polar elements take more iterations. Results are written straight into the caller's arrays.
+ *
+ *  Inputs:
+ * latitude: latitudes (deg, - is south, + is north)
+ * longitude: longitudes (deg, - is west, + is east)
+ * timeZone: time zones in UTC offset (hrs)
+ * jDate: Julian dates of the beginning of each day, as calcJDate gives
+ * count: number of elements in every array
+ * rise: output sunrise, decimal day in local time. NaN if the sun doesn't rise. May be NULL
+ * noon: output solar noon, as rise. May be NULL
+ * set: output sunset, as rise. May be NULL
+ * status: output day type, as calcDayType. May be NULL
+ * numThreads: number of threads to calculate with, 0 for one per CPU
+ *
+ *  Output:
+ * 1 if the arguments were valid, 0 if not (nothing is written)
+ **/
+int solarEvents(const double *latitude, const double *longitude, const double *timeZone, const double *jDate,
+                size_t count, double *rise, double *noon, double *set, int8_t *status, int numThreads)
+{
+    double *outs[3] = {rise, noon, set}; // output for each event
+
+    if (numThreads < 0 || (count > 0 && (!latitude || !longitude || !timeZone || !jDate)))
+    {
+        return 0;
+    }
+    numThreads = numThreads > 0 ? numThreads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    numThreads = numThreads < 1 ? 1 : numThreads > MAXTHREADS ? MAXTHREADS : numThreads;
+
+    OMP(parallel for num_threads(numThreads) schedule(dynamic, SITEBLOCK) if (count > SITEBLOCK))
+    for (size_t i = 0; i < count; i++)
+    {
+        double eventTime; // event time (decimal day, local time)
+
+        for (int e = 0; e < 3; e++)
+        {
+            if (outs[e])
+            {
+                eventTime = calcEvent(jDate[i], timeZone[i], longitude[i], latitude[i], e + 1);
+                outs[e][i] = eventTime < -1 ? NAN : eventTime;
+            }
+        }
+        if (status)
+        {
+            status[i] = calcDayType(jDate[i], timeZone[i], longitude[i], latitude[i]);
+        }
+    }
+
+    return 1;
+}
+
+// COLUMNAR OUTPUT FUNCTIONS
+
+/**
+ * Creates a columnar result file for a band of a grid job and maps it into memory. The file is laid out like Arrow
+ * buffers: a column per field, values and validity bitmaps aligned to COLALIGN bytes, bitmaps LSB first. Under
+ * /dev/shm the file is a shared memory segment that other processes can map and read in place.
+ *
+ *  Inputs:
+ * pointer cols: the buffers to fill in
+ * path: file to create
+ * job: the grid job
+ * rowBegin: first raster row of the band
+ * rowEnd: one past the last raster row of the band
+ *
+ *  Output:
+ * 1 if it worked, 0 if the file couldn't be created or mapped
+ **/
+int openColumns(ColBuffers *cols, const char *path, const GridJob *job, int rowBegin, int rowEnd)
+{
+    const char *names[NUMCOLUMNS] = {"rise", "noon", "set", "dayLength", "status", "civilDawn", "civilDusk",
+                                     "nauticalDawn", "nauticalDusk", "astroDawn", "astroDusk"}; // column names
+    ColHeader *header;  // the file's header
+    ColEntry *entries;  // the file's column descriptions
+    uint64_t numRows;   // number of rows
+    uint64_t offset;    // where the next buffer goes
+    int fd;             // file descriptor
+
+    numRows = (uint64_t)(rowEnd - rowBegin) * job->numLon * job->numDays;
+    offset = sizeof(ColHeader) + NUMCOLUMNS * sizeof(ColEntry);
+    offset = (offset + COLALIGN - 1) / COLALIGN * COLALIGN;
+    cols->size = offset;
+    for (int c = 0; c < NUMCOLUMNS; c++)
+    {
+        cols->size += c == COLDAYLEN || c == COLSTATUS ? 0 : (numRows / 8 + COLALIGN) / COLALIGN * COLALIGN;
+        cols->size += (numRows * (c == COLSTATUS ? 1 : sizeof(float)) + COLALIGN - 1) / COLALIGN * COLALIGN;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, cols->size) != 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return 0;
+    }
+    cols->base = mmap(NULL, cols->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (cols->base == MAP_FAILED)
+    {
+        return 0;
+    }
+
+    // the file starts out zeroed, so every bitmap starts out all invalid
+    header = (ColHeader *)cols->base;
+    entries = (ColEntry *)(cols->base + sizeof(ColHeader));
+    header->numRows = numRows;
+    header->numColumns = NUMCOLUMNS;
+    header->numDays = job->numDays;
+    header->numLat = rowEnd - rowBegin;
+    header->numLon = job->numLon;
+    header->latMin = job->latMin + rowBegin * job->step;
+    header->lonMin = job->lonMin;
+    header->step = job->step;
+    header->startJDate = job->startJDate;
+    for (int c = 0; c < NUMCOLUMNS; c++)
+    {
+        strncpy(entries[c].name, names[c], COLNAMELEN - 1);
+        entries[c].type = c == COLSTATUS ? COLINT8 : COLFLOAT32;
+        entries[c].nullable = c != COLDAYLEN && c != COLSTATUS;
+        entries[c].validOffset = 0;
+        cols->valid[c] = NULL;
+        if (entries[c].nullable)
+        {
+            entries[c].validOffset = offset;
+            cols->valid[c] = cols->base + offset;
+            offset += (numRows / 8 + COLALIGN) / COLALIGN * COLALIGN;
+        }
+        entries[c].dataOffset = offset;
+        cols->data[c] = cols->base + offset;
+        offset += (numRows * (c == COLSTATUS ? 1 : sizeof(float)) + COLALIGN - 1) / COLALIGN * COLALIGN;
+    }
+
+    return 1;
+}
+
+/**
+ * Marks a columnar result file complete and unmaps it
+ *
+ *  Inputs:
+ * pointer cols: the file's buffers
+ *
+ *  Output:
+ * None
+ **/
+void closeColumns(ColBuffers *cols)
+{
+    memcpy(((ColHeader *)cols->base)->magic, COLMAGIC, sizeof(COLMAGIC));
+    msync(cols->base, cols->size, MS_SYNC);
+    munmap(cols->base, cols->size);
+}
+
+/**
+ * Stores a time in one of a columnar result file's nullable columns
+ *
+ *  Inputs:
+ * pointer cols: the file's buffers
+ * column: the column
+ * row: the row
+ * utcTime: decimal day in UTC. Less than -1 means there's no value
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void setColTime(ColBuffers *cols, int column, size_t row, double utcTime)
+{
+    if (utcTime < -1)
+    {
+        ((float *)cols->data[column])[row] = NAN;
+    }
+    else
+    {
+        ((float *)cols->data[column])[row] = utcTime * HRSINDAY * MININHR;
+        cols->valid[column][row / 8] |= 1 << (row % 8);
+    }
+}
+
+/**
+ * Calculates one tile of a grid job into a columnar result file, as gridTile. Adds day length, day status, and the
+ * civil, nautical, and astronomical twilight times.
+ *
+ *  Inputs:
+ * job: the grid job
+ * sites: the sites being calculated
+ * ephs: the job's per-date terms
+ * siteBegin: first site of the tile
+ * siteEnd: one past the last site of the tile
+ * dayBegin: first day of the tile
+ * dayEnd: one past the last day of the tile
+ * firstRow: row of the first of the sites' first day
+ * pointer cols: the file's buffers
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void gridTileColumns(const GridJob *job, const SiteArrays *sites, const DateEphem *ephs, int siteBegin, int siteEnd, int dayBegin, int dayEnd, size_t firstRow, ColBuffers *cols)
+{
+    double solarShift;     // offset from local solar time to UTC (decimal day)
+    double times[3];       // rise, noon, and set (decimal day, local solar time)
+    double twilightTime;   // a twilight time (decimal day, local solar time)
+    int status;            // day status, as calcDayType
+    size_t row;            // the site and day's row
+
+    for (int i = siteBegin; i < siteEnd; i++)
+    {
+        solarShift = sites->longitude[i] / (15 * HRSINDAY);
+        for (int d = dayBegin; d < dayEnd; d++)
+        {
+            row = firstRow + (size_t)i * job->numDays + d;
+            for (int e = 0; e < 3; e++)
+            {
+                times[e] = gridEvent(&ephs[d], sites->secLat[i], sites->tanLat[i], e + 1, NULL);
+                setColTime(cols, COLRISE + e, row, times[e] < -1 ? times[e] : times[e] - solarShift);
+            }
+
+            status = (times[0] >= -1) + (times[2] >= -1);
+            if (status == 0)
+            {
+                status = gridDayStatus(&ephs[d], sites->secLat[i], sites->tanLat[i]) == 1 ? -1 : -2;
+            }
+            ((int8_t *)cols->data[COLSTATUS])[row] = status;
+            ((float *)cols->data[COLDAYLEN])[row] = status < 0 ? (status == -1) * HRSINDAY * MININHR
+                                                               : ((times[2] < -1 ? 1 : times[2]) - (times[0] < -1 ? 0 : times[0])) * HRSINDAY * MININHR;
+
+            for (int t = 0; t < NUMTWILIGHTS; t++)
+            {
+                for (int e = 1; e <= 3; e += 2)
+                {
+                    twilightTime = gridEventAt(&ephs[d], ephs[d].twilightA[t], sites->secLat[i], sites->tanLat[i], e, NULL);
+                    setColTime(cols, COLTWILIGHT + 2 * t + e / 2, row, twilightTime < -1 ? twilightTime : twilightTime - solarShift);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Calculates a band of rows of a grid job straight into a memory-mapped columnar result file
+ *
+ *  Inputs:
+ * job: the grid job
+ * rowBegin: first row (latitude) of the band
+ * rowEnd: one past the last row of the band
+ * path: file to create
+ *
+ *  Output:
+ * 1 if it worked, 0 if not
+ **/
+int runGridColumns(const GridJob *job, int rowBegin, int rowEnd, const char *path)
+{
+    SiteArrays sites; // the band's sites
+    DateEphem *ephs;  // per-date terms
+    ColBuffers cols;  // the output file
+    int stripeEnd;    // one past the last site of the current stripe
+
+    ephs = malloc(job->numDays * sizeof(DateEphem));
+    if (!ephs || !allocSiteArrays(&sites, (rowEnd - rowBegin) * job->numLon))
+    {
+        free(ephs);
+        return 0;
+    }
+    if (!openColumns(&cols, path, job, rowBegin, rowEnd))
+    {
+        freeSiteArrays(&sites);
+        free(ephs);
+        return 0;
+    }
+
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        for (int j = 0; j < job->numLon; j++)
+        {
+            sites.latitude[(i - rowBegin) * job->numLon + j] = job->latMin + i * job->step;
+            sites.longitude[(i - rowBegin) * job->numLon + j] = job->lonMin + j * job->step;
+        }
+    }
+    prepSiteArrays(&sites);
+    for (int d = 0; d < job->numDays; d++)
+    {
+        calcDateEphem(&ephs[d], job->startJDate + d);
+    }
+
+    for (int siteBegin = 0; siteBegin < sites.numSites; siteBegin += SITEBLOCK)
+    {
+        stripeEnd = siteBegin + SITEBLOCK < sites.numSites ? siteBegin + SITEBLOCK : sites.numSites;
+        for (int dayBegin = 0; dayBegin < job->numDays; dayBegin += DATEBLOCK)
+        {
+            gridTileColumns(job, &sites, ephs, siteBegin, stripeEnd, dayBegin,
+                            dayBegin + DATEBLOCK < job->numDays ? dayBegin + DATEBLOCK : job->numDays, 0, &cols);
+        }
+    }
+
+    closeColumns(&cols);
+    freeSiteArrays(&sites);
+    free(ephs);
+
+    return 1;
+}
+
+// DISPLAY FUNCTIONS
+
+/**
+ * Prints coordinates with N/S and a degree symbol
+ *
+ *  Inputs:
+ * longitude: longitude, with negative for west and positive for east
+ * latitude: latitude, negative is south and positive is north
+ *
+ *  Output:
+ * None
+ **/
+void printCoords(double longitude, double latitude)
+{
+    char latDirection = 'N';  // latitude cardinal direction
+    char longDirection = 'E'; // longitude cardinal direction
+    int longDecimals;         // number of decimal places in the longitude coordinate
+    int latDecimals;          // number of decimal places in the latitude coordinate
+
+    longDecimals = numDecimals(longitude);
+    latDecimals = numDecimals(latitude);
+
+    if (latitude < 0)
+    {
+        latDirection = 'S';
+    }
+
+    if (longitude < 0)
+    {
+        longDirection = 'W';
+    }
+
+    printf("%.*lf%c %c, %.*lf%c %c",
+           latDecimals, fabs(latitude), DEGCODE, latDirection,
+           longDecimals, fabs(longitude), DEGCODE, longDirection);
+}
+
+/**
+ * Prints a date to as DD Monthname, YYYY
+ *
+ *  Inputs:
+ * jDate: Julian date to print
+ *
+ *  Output:
+ * None
+ **/
+void printDate(double jDate)
+{
+    int day;   // day of the month
+    int month; // month of the year
+    int year;  // standard calendar year
+
+    calcDate(jDate, 0, &day, &month, &year);
+
+    printf("%02d ", day);
+    switch (month)
+    {
+    case JAN:
+        printf("January");
+        break;
+    case FEB:
+        printf("February");
+        break;
+    case MAR:
+        printf("March");
+        break;
+    case APR:
+        printf("April");
+        break;
+    case MAY:
+        printf("May");
+        break;
+    case JUN:
+        printf("June");
+        break;
+    case JUL:
+        printf("July");
+        break;
+    case AUG:
+        printf("August");
+        break;
+    case SEP:
+        printf("September");
+        break;
+    case OCT:
+        printf("October");
+        break;
+    case NOV:
+        printf("November");
+        break;
+    case DEC:
+        printf("December");
+        break;
+    }
+    printf(", %d", year);
+}
+
+/**
+ * Prints a time in both 24 and 12 hour format
+ *
+ *  Inputs:
+ * fracDay: the time of day as a decimal day
+ *
+ *  Output:
+ * None
+ **/
+void dispTime(double fracDay)
+{
+    int hrs;   // hours
+    int min;   // mins
+    int hrs12; // 12hr hours
+
+    hrs = hours(fracDay);
+    hrs12 = hours12Hr(fracDay);
+    min = minutes(fracDay);
+
+    if (fracDay >= 0 && fracDay < 1)
+    {
+        printf("%02d:%02d (%d:%02d %cM)", hours(fracDay), minutes(fracDay),
+               hours12Hr(fracDay), minutes(fracDay), hrType12Hr(fracDay));
+    }
+    else if (fracDay >= -1 && fracDay < 0)
+    {
+        fracDay++;
+        printf("%02d:%02d (%d:%02d %cM) the previous date", hours(fracDay), minutes(fracDay),
+               hours12Hr(fracDay), minutes(fracDay), hrType12Hr(fracDay));
+    }
+    else if (fracDay >= 1 && fracDay < 2)
+    {
+        fracDay--;
+        printf("%02d:%02d (%d:%02d %cM) the previous date", hours(fracDay), minutes(fracDay),
+               hours12Hr(fracDay), minutes(fracDay), hrType12Hr(fracDay));
+    }
+    else
+    {
+        printf("None");
+    }
+}
+
+/**
+ * Prints the output for a nominal day with a sunrise or sunset. Shows sunrise, sunset, and solar noon times
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ *
+ *  Output:
+ * None
+ **/
+void nominalOutput(double jDate, double timeZone, double longitude, double latitude)
+{
+    double riseTime; // sunrise time (decimal day - local time)
+    double setTime;  // sunset time (decimal day - local time)
+    double solNoon;  // solar noon (decimal day - local time)
+    double duration; // amount of sunlight (decimal day)
+
+    riseTime = calcEvent(jDate, timeZone, longitude, latitude, 1);
+    solNoon = calcEvent(jDate, timeZone, longitude, latitude, 2);
+    setTime = calcEvent(jDate, timeZone, longitude, latitude, 3);
+    duration = setTime - riseTime;
+
+    printf("\nSunrise: ");
+    dispTime(riseTime);
+
+    printf("\nSolar Noon: ");
+    dispTime(solNoon);
+
+    printf("\nSunset: ");
+    dispTime(setTime);
+
+    if (setTime >= -1 && riseTime >= -1)
+    {
+        printf("\nThere are %d hrs and %d minutes of sunlight", hours(duration), minutes(duration));
+    }
+
+    printf("\n\n");
+}
+
+/**
+ * Prints a time of day as HH:MM in 24 hour format. A time on another date (as calcEvent gives when the time zone is
+ * far from solar time) is followed by the number of days it's off by, as +1 for the next date or -1 the previous
+ *
+ *  Inputs:
+ * fracDay: the time as a decimal day from the beginning of the date
+ *
+ *  Output:
+ * None
+ **/
+void printClock(double fracDay)
+{
+    int dayShift; // whole days the time is off the date by
+
+    fracDay = roundToMin(fracDay);
+    dayShift = (int)floor(fracDay);
+    fracDay -= dayShift;
+
+    printf("%02d:%02d", hours(fracDay), minutes(fracDay));
+    if (dayShift != 0)
+    {
+        printf("%+d", dayShift);
+    }
+}
+
+/**
+ * Prints every sunrise, solar noon, and sunset of a day, as found by calcDayEvents. Used near the poles, where a day
+ * can have two sunsets or only one event.
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ *
+ *  Output:
+ * None
+ **/
+void enumOutput(double jDate, double timeZone, double longitude, double latitude)
+{
+    SolarEvent events[MAXDAYEVENTS]; // the day's events
+    int numEvents;                   // number of events
+    int sunUp;                       // whether the sun is up at the beginning of the day
+    double duration = 0;             // amount of sunlight (decimal day)
+    double lastRise = 0;             // start of the current period of sunlight (decimal day)
+
+    numEvents = calcDayEvents(jDate, timeZone, longitude, latitude, events, &sunUp);
+
+    for (int i = 0; i < numEvents; i++)
+    {
+        switch (events[i].type)
+        {
+        case 1:
+            printf("\nSunrise: ");
+            lastRise = events[i].time;
+            sunUp = 1;
+            break;
+        case 2:
+            printf("\nSolar Noon: ");
+            break;
+        case 3:
+            printf("\nSunset: ");
+            duration += events[i].time - lastRise;
+            sunUp = 0;
+            break;
+        }
+        dispTime(events[i].time);
+    }
+    if (sunUp)
+    {
+        duration += 1 - lastRise;
+    }
+
+    printf("\nThere are %d hrs and %d minutes of sunlight", hours(duration), minutes(duration));
+    printf("\n\n");
+}
+
+/**
+ * Prints the output for a day with neither sunrise nor sunset. Displays last event and next event dates and times.
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ * status: The day type as determined by calcDayType
+ *
+ *  Output:
+ * None
+ **/
+void extremeLatOutput(double jDate, double timeZone, double longitude, double latitude, int status)
+{
+    double lastEventDay;  // Julian date for the last event
+    double nextEventDay;  // Julain date for the next event
+    double lastEventTime; // time for the last event (decimal day)
+    double nextEventTime; // time for the next event (decimal day)
+    double noon;          // solar noon time
+    int numDays;          // number of days between two events
+    int numHrs;           // number of excess hours between two events
+    int numMins;          // number of excess minutes between two events
+    double diff;          // difference between jDates of the two events (decimal day)
+
+    switch (status)
+    {
+    case -1:
+        lastEventDay = calcEventDay(longitude, latitude, timeZone, jDate, -1);
+        nextEventDay = calcEventDay(longitude, latitude, timeZone, jDate, 3);
+        lastEventTime = calcEvent(lastEventDay, timeZone, longitude, latitude, 1);
+        nextEventTime = calcEvent(nextEventDay, timeZone, longitude, latitude, 3);
+        break;
+    case -2:
+        lastEventDay = calcEventDay(longitude, latitude, timeZone, jDate, -3);
+        nextEventDay = calcEventDay(longitude, latitude, timeZone, jDate, 1);
+        nextEventTime = calcEvent(nextEventDay, timeZone, longitude, latitude, 1);
+        lastEventTime = calcEvent(lastEventDay, timeZone, longitude, latitude, 3);
+    }
+    noon = calcEvent(jDate, timeZone, longitude, latitude, 2);
+
+    if (lastEventDay == NOEVENTDAY || nextEventDay == NOEVENTDAY)
+    {
+        printf("%s\n\n", status == -1 ? "The sun doesn't set. It's day for all 24hrs." : "The sun doesn't rise. It's night for all 24hrs.");
+        printf("The %s %s couldn't be found within %d days.", lastEventDay == NOEVENTDAY ? "last" : "next",
+               (lastEventDay == NOEVENTDAY) == (status == -1) ? "sunrise" : "sunset", MAXEVENTDAYS);
+        return;
+    }
+
+    numMins = (minutes(1 - lastEventTime) + minutes(nextEventTime)) % MININHR;
+    numHrs = hours(1 - lastEventTime) + hours(nextEventTime) + (minutes(1 - lastEventTime) + minutes(nextEventTime)) / MININHR;
+    diff = nextEventDay - lastEventDay;
+    numDays = floor(diff - (numHrs / (double)HRSINDAY) - numMins / ((double)HRSINDAY * MININHR));
+
+    switch (status)
+    {
+    case -1:
+        printf("The sun doesn't set. It's day for all 24hrs.\n\n");
+        printf("\nThe sun rose on ");
+        printDate(lastEventDay);
+        printf(", at ");
+        dispTime(lastEventTime);
+        printf("\nThe sun will set on ");
+        printDate(nextEventDay);
+        printf(", at ");
+        dispTime(nextEventTime);
+        printf("\nThe solar day lasts %d days, %d hours, and %d minutes", numDays, numHrs, numMins);
+        break;
+    case -2:
+        printf("The sun doesn't rise. It's night for all 24hrs.\n\n");
+        printf("The sun set on ");
+        printDate(lastEventDay);
+        printf(", at ");
+        dispTime(lastEventTime);
+        printf("\nThe sun will rise on ");
+        printDate(nextEventDay);
+        printf(", at ");
+        dispTime(nextEventTime);
+        printf("\nThe solar night lasts %d days, %d hours, and %d minutes", numDays, numHrs, numMins);
+        break;
+    }
+}
+
+/**
+ * Calls the respective print functions to print the total output
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * longitude: East/west component of position find solar event
+ * latitude: North/South component of position find solar event
+ *
+ *  Output:
+ * None
+ **/
+void printAll(double jDate, double timeZone, double longitude, double latitude)
+{
+    int dayStatus; // whether the sun rises, sets, or both
+    int dayType;   // The type of day: all night, all day, sunrise and sunsent, or just one?
+
+    dayType = calcDayType(jDate, timeZone, longitude, latitude);
+
+    printf("\n\n\t");
+    printDate(jDate);
+    printf("\n\t");
+    printCoords(longitude, latitude);
+    printf("\n\n");
+    if (dayType > 0 && fabs(latitude) > ENUMLAT)
+    { // there can be more than one sunrise or sunset
+        enumOutput(jDate, timeZone, longitude, latitude);
+    }
+    else if (dayType > 0)
+    { // there's a sunrise or sunset
+        nominalOutput(jDate, timeZone, longitude, latitude);
+    }
+    else
+    { // there's neither a sunrise nor a sunset
+        extremeLatOutput(jDate, timeZone, longitude, latitude, dayType);
+    }
+}
+
+// BATCH FUNCTIONS
+
+/**
+ * Runs the non-interactive mode named on the command line
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments. argv[1] is the mode
+ *
+ *  Output:
+ * Program exit status
+ **/
+int runMode(int argc, char *argv[])
+{
+    int status = 1; // exit status
+
+    if (strcmp(argv[1], "batch") == 0)
+    {
+        status = batchMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "range") == 0)
+    {
+        status = rangeMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "grid") == 0)
+    {
+        status = gridMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "stats") == 0)
+    {
+        status = statsMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "shard") == 0)
+    {
+        status = shardMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "colread") == 0)
+    {
+        status = colReadMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "horizon") == 0)
+    {
+        status = horizonMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "inverse") == 0)
+    {
+        status = inverseMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "accuracy") == 0)
+    {
+        status = accuracyMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "table") == 0)
+    {
+        status = tableMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "fuzz") == 0)
+    {
+        status = fuzzMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "light") == 0)
+    {
+        status = lightMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "serve") == 0)
+    {
+        status = serveMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "scale") == 0)
+    {
+        status = scaleMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "profile") == 0)
+    {
+        status = profileMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "track") == 0)
+    {
+        status = trackMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "span") == 0)
+    {
+        status = spanMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "tiles") == 0)
+    {
+        status = tileMode(argc, argv);
+    }
+    else if (strcmp(argv[1], "terminator") == 0)
+    {
+        status = terminatorMode(argc, argv);
+    }
+    else
+    {
+        fprintf(stderr, "Unknown mode: %s\n", argv[1]);
+        fprintf(stderr, "Usage: %s [batch | range | grid | stats | shard | colread | horizon | inverse | accuracy | table | fuzz | light | serve | scale | profile | track | span | tiles | terminator]\n", argv[0]);
+    }
+
+    return status;
+}
+
+/**
+ * Reads one query per line from stdin as "latitude longitude timezone YYYY MM DD" and prints the day's events for each.
+ * The time zone is either a UTC offset or an IANA zone name like America/New_York. With "profile", prints a profile of
+ * the run's stages to stderr at the end (see printProfile).
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: batch [profile]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int batchMode(int argc, char *argv[])
+{
+    char inputStr[BUFSIZ];  // input line
+    char zoneStr[TZNAMELEN]; // time zone as entered
+    char *zoneEnd;           // end of the time zone if it's a number
+    double latitude;         // latitude (deg)
+    double longitude;        // longitude (deg)
+    double timeZone;         // time zone in UTC offset
+    int year;                // year
+    int month;               // month of the year
+    int day;                 // day of the month
+    int lineNum = 0;         // input line number
+    double jDate;            // Julian date of the day
+    TzCache zoneCache;       // IANA zones loaded so far
+    const TzZone *zone;      // the line's IANA zone, NULL for a fixed offset
+    Profile prof;            // stage profile, with "profile"
+
+    if (argc > 3 || (argc == 3 && strcmp(argv[2], "profile") != 0))
+    {
+        fprintf(stderr, "Usage: %s batch [profile] < queries.txt\n", argv[0]);
+        return 1;
+    }
+#ifndef SOLARPROFILE
+    if (argc == 3)
+    {
+        fprintf(stderr, "%s was built without profiling. Rebuild with -DSOLARPROFILE to use batch profile\n", argv[0]);
+        return 1;
+    }
+#endif
+    if (argc == 3)
+    {
+        openProfile(&prof);
+        calibrateProfile(&prof);
+        activeProfile = &prof;
+    }
+
+    zoneCache.numZones = 0;
+    while (fgets(inputStr, BUFSIZ, stdin) != NULL)
+    {
+        lineNum++;
+        zone = NULL;
+        timeZone = 0;
+        if (sscanf(inputStr, "%lf %lf %63s %d %d %d", &latitude, &longitude, zoneStr, &year, &month, &day) == 6)
+        {
+            timeZone = strtod(zoneStr, &zoneEnd);
+            if (*zoneEnd != '\0')
+            {
+                zone = findTzZone(&zoneCache, zoneStr);
+                timeZone = zone ? 0 : HRSINDAY;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Skipping invalid input on line %d\n", lineNum);
+            continue;
+        }
+        if (fabs(latitude) >= LATRANGE || fabs(longitude) >= LONGRANGE || fabs(timeZone) > 13 || year <= 0 ||
+            month < 1 || month > NUMMONTHS || day < 1 || day > monthLen(month, year))
+        {
+            fprintf(stderr, "Skipping invalid input on line %d\n", lineNum);
+            continue;
+        }
+        jDate = calcJDate(day, month, year, timeZone);
+        if (zone)
+        {
+            timeZone = zoneDayOffset(zone, jDate);
+        }
+        profEnter(PROFOUTPUT);
+        printf("%04d-%02d-%02d %g %g", year, month, day, latitude, longitude);
+        profLeave();
+        batchOutput(jDate, timeZone, longitude, latitude, zone);
+    }
+
+    freeTzCache(&zoneCache);
+    if (activeProfile)
+    {
+        profEnter(PROFOUTPUT);
+        fflush(stdout);
+        profLeave();
+        activeProfile = NULL;
+        replayLibm(&prof);
+        printProfile(stderr, &prof);
+        closeProfile(&prof);
+    }
+
+    return 0;
+}
+
+/**
+ * Prints one batch output line: the day's events as R/N/S followed by HH:MM, or "day"/"night" if the sun neither
+ * rises nor sets. Above ENUMLAT the events come from calcDayEvents, otherwise from calcEvent.
+ *
+ *  Inputs:
+ * jDate: Julian date to check. Must be the beginning of a day
+ * tZ: time zone in UTC offset (for an IANA zone, its offset at the beginning of the day)
+ * longitude: East/west component of position
+ * latitude: North/South component of position
+ * zone: IANA zone to give wall clock times in, or NULL to use tZ throughout
+ *
+ *  Output:
+ * None
+ **/
+void batchOutput(double jDate, double timeZone, double longitude, double latitude, const TzZone *zone)
+{
+    SolarEvent events[MAXDAYEVENTS]; // the day's events
+    int numEvents = 0;               // number of events
+    int sunUp;                       // whether the sun is up at the beginning of the day
+    int dayType;                     // the type of day, as calcDayType
+
+    if (fabs(latitude) > ENUMLAT)
+    {
+        numEvents = calcDayEvents(jDate, timeZone, longitude, latitude, events, &sunUp);
+        if (numEvents == 1)
+        {
+            numEvents = 0;
+            printf(sunUp ? " day" : " night");
+        }
+    }
+    else
+    {
+        dayType = calcDayType(jDate, timeZone, longitude, latitude);
+        if (dayType > 0)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                events[i].type = i + 1;
+                events[i].time = calcEvent(jDate, timeZone, longitude, latitude, i + 1);
+            }
+            numEvents = 3;
+        }
+        else
+        {
+            printf(dayType == -1 ? " day" : " night");
+        }
+    }
+
+    profEnter(PROFOUTPUT);
+    for (int i = 0; i < numEvents; i++)
+    {
+        printf(" %c ", "?RNS"[events[i].type]);
+        printClock(zone ? zoneLocalTime(zone, jDate, timeZone, events[i].time) : events[i].time);
+    }
+    printf("\n");
+    profLeave();
+}
+
+/**
+ * Prints every sunrise and sunset at a site between two dates, one per line as "YYYY-MM-DD R|S HH:MM". The time zone
+ * is either a UTC offset or an IANA zone name.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: range latitude longitude timezone YYYY MM DD YYYY MM DD (end date inclusive)
+ *
+ *  Output:
+ * Program exit status
+ **/
+int rangeMode(int argc, char *argv[])
+{
+    EventIter it;         // the event iterator
+    SolarEvent event;     // current event
+    double latitude;      // latitude (deg)
+    double longitude;     // longitude (deg)
+    double timeZone;      // time zone in UTC offset
+    int date[6];          // start and end year, month, day
+    double startJDate;    // first day
+    double endJDate;      // day after the last day
+    double eventJDate;    // day of the current event
+    double shownJDate;    // day the printed calendar date refers to
+    int day;              // printed day of the month
+    int month;            // printed month
+    int year;             // printed year
+    char *zoneEnd;        // end of the time zone if it's a number
+    TzCache zoneCache;    // the IANA zone, if one was given
+    const TzZone *zone;   // the IANA zone, NULL for a fixed offset
+    double dayShift;      // whole days the wall clock time moved the event by
+
+    if (argc != 11)
+    {
+        fprintf(stderr, "Usage: %s range latitude longitude timezone YYYY MM DD YYYY MM DD\n", argv[0]);
+        return 1;
+    }
+    latitude = atof(argv[2]);
+    longitude = atof(argv[3]);
+    timeZone = strtod(argv[4], &zoneEnd);
+    zoneCache.numZones = 0;
+    zone = NULL;
+    if (*zoneEnd != '\0')
+    {
+        zone = findTzZone(&zoneCache, argv[4]);
+        timeZone = zone ? 0 : HRSINDAY;
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        date[i] = atoi(argv[5 + i]);
+    }
+    if (fabs(latitude) >= LATRANGE || fabs(longitude) >= LONGRANGE || fabs(timeZone) > 13 ||
+        date[0] <= 0 || date[1] < 1 || date[1] > NUMMONTHS || date[2] < 1 || date[2] > monthLen(date[1], date[0]) ||
+        date[3] <= 0 || date[4] < 1 || date[4] > NUMMONTHS || date[5] < 1 || date[5] > monthLen(date[4], date[3]))
+    {
+        fprintf(stderr, "Invalid coordinates, time zone, or date\n");
+        return 1;
+    }
+
+    startJDate = calcJDate(date[2], date[1], date[0], timeZone);
+    endJDate = calcJDate(date[5], date[4], date[3], timeZone) + 1;
+    if (zone)
+    {
+        // the events are found with the zone's offset on the first day, then moved onto its wall clock one by one
+        timeZone = zoneDayOffset(zone, startJDate);
+    }
+    // where the time zone is far from solar time, a day's events can land on the date before or after it, so the days
+    // either side of the range are solved too and every event is kept or dropped by the date it lands on
+    initEventIter(&it, startJDate - 1, endJDate + 1, timeZone, longitude, latitude);
+
+    // the calendar date is stepped along with the events rather than recalculated for each one
+    calcDate(startJDate - 1, 0, &day, &month, &year);
+    shownJDate = startJDate - 1;
+    while (nextEvent(&it, &eventJDate, &event))
+    {
+        if (zone)
+        {
+            event.time = zoneLocalTime(zone, eventJDate, timeZone, event.time);
+            dayShift = floor(event.time);
+            eventJDate += dayShift;
+            event.time -= dayShift;
+        }
+        if (eventJDate < startJDate || eventJDate >= endJDate)
+        {
+            continue;
+        }
+        while (shownJDate < eventJDate)
+        {
+            advanceDate(&day, &month, &year);
+            shownJDate += 1;
+        }
+        printf("%04d-%02d-%02d %c ", year, month, day, event.type == 1 ? 'R' : 'S');
+        printClock(event.time);
+        printf("\n");
+    }
+
+    freeTzCache(&zoneCache);
+
+    return 0;
+}
+
+/**
+ * Reads the raster and dates of a grid job from the command line
+ *
+ *  Inputs:
+ * pointer job: the job to fill
+ * args: command line arguments starting at latMin: latMin latMax lonMin lonMax step YYYY MM DD numDays
+ *
+ *  Output:
+ * 1 if the arguments are valid, 0 if not
+ **/
+int parseGridJob(GridJob *job, char *args[])
+{
+    double latMax;        // latitude of the last row (deg)
+    double lonMax;        // longitude of the last column (deg)
+    int year, month, day; // first date
+
+    job->latMin = atof(args[0]);
+    latMax = atof(args[1]);
+    job->lonMin = atof(args[2]);
+    lonMax = atof(args[3]);
+    job->step = atof(args[4]);
+    year = atoi(args[5]);
+    month = atoi(args[6]);
+    day = atoi(args[7]);
+    job->numDays = atoi(args[8]);
+    if (job->step <= 0 || job->latMin > latMax || job->lonMin > lonMax ||
+        fmax(fabs(job->latMin), fabs(latMax)) >= LATRANGE || fmax(fabs(job->lonMin), fabs(lonMax)) >= LONGRANGE ||
+        year <= 0 || month < 1 || month > NUMMONTHS || day < 1 || day > monthLen(month, year) || job->numDays < 1)
+    {
+        return 0;
+    }
+
+    job->numLat = (int)floor((latMax - job->latMin) / job->step + 1e-9) + 1;
+    job->numLon = (int)floor((lonMax - job->lonMin) / job->step + 1e-9) + 1;
+    job->startJDate = calcJDate(day, month, year, 0);
+    job->epochUnits = 0;
+
+    return 1;
+}
+
+/**
+ * Sets a grid job to write Unix timestamps
+ *
+ *  Inputs:
+ * pointer job: the grid job
+ * units: "s" for seconds or "ms" for milliseconds
+ *
+ *  Output:
+ * 1 if the units are valid, 0 if not
+ **/
+int parseEpochUnits(GridJob *job, const char *units)
+{
+    if (strcmp(units, "s") == 0)
+    {
+        job->epochUnits = SECINDAY;
+    }
+    else if (strcmp(units, "ms") == 0)
+    {
+        job->epochUnits = (int64_t)SECINDAY * MSINSEC;
+    }
+
+    return job->epochUnits != 0;
+}
+
+/**
+ * Calculates a band of rows of a grid job and writes them to a file. A band's output is the same bytes as that part
+ * of the whole job's output, so bands calculated separately can be concatenated.
+ *
+ *  Inputs:
+ * job: the grid job
+ * rowBegin: first row (latitude) of the band
+ * rowEnd: one past the last row of the band
+ * outFile: file to write to
+ * naive: whether to use calcEvent for every site instead of the tiled engine
+ *
+ *  Output:
+ * 1 if it worked, 0 if memory couldn't be allocated or the file couldn't be written
+ **/
+int runGrid(const GridJob *job, int rowBegin, int rowEnd, FILE *outFile, int naive)
+{
+    SiteArrays sites; // the band's sites
+    DateEphem *ephs;  // per-date terms
+    void *out;        // output for one stripe of sites
+    size_t valueSize; // size of one output value
+    size_t numValues; // number of values in the current stripe
+    int stripeEnd;    // one past the last site of the current stripe
+    int written = 1;  // whether every stripe was written
+
+    valueSize = job->epochUnits == 0 ? sizeof(float) : sizeof(int64_t);
+    ephs = malloc(job->numDays * sizeof(DateEphem));
+    out = malloc((size_t)SITEBLOCK * job->numDays * 3 * valueSize);
+    if (!ephs || !out || !allocSiteArrays(&sites, (rowEnd - rowBegin) * job->numLon))
+    {
+        free(ephs);
+        free(out);
+        return 0;
+    }
+
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        for (int j = 0; j < job->numLon; j++)
+        {
+            sites.latitude[(i - rowBegin) * job->numLon + j] = job->latMin + i * job->step;
+            sites.longitude[(i - rowBegin) * job->numLon + j] = job->lonMin + j * job->step;
+        }
+    }
+    prepSiteArrays(&sites);
+    for (int d = 0; d < job->numDays; d++)
+    {
+        calcDateEphem(&ephs[d], job->startJDate + d);
+    }
+
+    // stripes of SITEBLOCK sites are contiguous in the output; within a stripe, tiles step through DATEBLOCK days
+    for (int siteBegin = 0; siteBegin < sites.numSites && written; siteBegin += SITEBLOCK)
+    {
+        stripeEnd = siteBegin + SITEBLOCK < sites.numSites ? siteBegin + SITEBLOCK : sites.numSites;
+        for (int dayBegin = 0; dayBegin < job->numDays && !naive; dayBegin += DATEBLOCK)
+        {
+            gridTile(job, &sites, ephs, siteBegin, stripeEnd, dayBegin,
+                     dayBegin + DATEBLOCK < job->numDays ? dayBegin + DATEBLOCK : job->numDays, out);
+        }
+        for (int i = siteBegin; i < stripeEnd && naive; i++)
+        {
+            gridNaiveRow(job, &sites, siteBegin, i, out);
+        }
+        numValues = (size_t)(stripeEnd - siteBegin) * job->numDays * 3;
+        written = fwrite(out, valueSize, numValues, outFile) == numValues;
+    }
+
+    freeSiteArrays(&sites);
+    free(ephs);
+    free(out);
+
+    return written;
+}
+
+/**
+ * Calculates sunrise, solar noon, and sunset for every point of a latitude/longitude raster over a run of days, and
+ * writes them as float32 UTC minutes after midnight (NaN where the event doesn't happen), or with "epoch" as int64
+ * Unix timestamps (NOEPOCH where the event doesn't happen). The output is ordered [site][day][event] with sites in
+ * rows of increasing latitude, then longitude. With "columnar", writes a columnar result file instead (see openColumns).
+ * With "threads", "pin", or "hugepages", calculates with several threads, each keeping its memory on its own NUMA node
+ * (see runGridPlaced).
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: grid latMin latMax lonMin lonMax step YYYY MM DD numDays outFile [naive] [rows R0 R1]
+ *       [epoch s|ms] [columnar] [threads N] [pin] [hugepages]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int gridMode(int argc, char *argv[])
+{
+    GridJob job;        // the raster and dates
+    FILE *outFile;      // output file
+    int naive = 0;      // whether to use calcEvent for every row instead of the tiled engine
+    int rowBegin = 0;   // first row to calculate
+    int rowEnd = -1;    // one past the last row to calculate
+    int valid;          // whether the arguments are valid
+    int columnar = 0;   // whether to write a columnar result file
+    int placed = 0;     // whether to calculate with several threads
+    int numThreads = 0; // number of threads, 0 for one per CPU
+    int pin = 0;        // whether to pin the threads
+    int hugePages = 0;  // whether to ask for huge pages
+    GridPlacement plan; // where the threads run
+    int fd;             // output file, for the threads
+    double start;       // wall clock time at the start (monoSec)
+    clock_t startClock; // processor time at the start
+
+    valid = argc >= 12 && parseGridJob(&job, argv + 2);
+    for (int i = 12; i < argc && valid; i++)
+    {
+        if (strcmp(argv[i], "naive") == 0)
+        {
+            naive = 1;
+        }
+        else if (strcmp(argv[i], "rows") == 0 && i + 2 < argc)
+        {
+            rowBegin = atoi(argv[i + 1]);
+            rowEnd = atoi(argv[i + 2]);
+            i += 2;
+        }
+        else if (strcmp(argv[i], "epoch") == 0 && i + 1 < argc)
+        {
+            valid = parseEpochUnits(&job, argv[++i]);
+        }
+        else if (strcmp(argv[i], "columnar") == 0)
+        {
+            columnar = 1;
+        }
+        else if (strcmp(argv[i], "threads") == 0 && i + 1 < argc)
+        {
+            numThreads = atoi(argv[++i]);
+            valid = numThreads >= 0;
+            placed = 1;
+        }
+        else if (strcmp(argv[i], "pin") == 0)
+        {
+            pin = placed = 1;
+        }
+        else if (strcmp(argv[i], "hugepages") == 0)
+        {
+            hugePages = placed = 1;
+        }
+        else
+        {
+            valid = 0;
+        }
+    }
+    if (valid && rowEnd == -1)
+    {
+        rowEnd = job.numLat;
+    }
+    if (!valid || rowBegin < 0 || rowEnd > job.numLat || rowBegin >= rowEnd || (columnar && (naive || job.epochUnits || placed)))
+    {
+        fprintf(stderr, "Usage: %s grid latMin latMax lonMin lonMax step YYYY MM DD numDays outFile [naive] [rows R0 R1] [epoch s|ms] [columnar] [threads N] [pin] [hugepages]\n", argv[0]);
+        return 1;
+    }
+
+    if (placed)
+    {
+        planPlacement(&plan, numThreads, pin, hugePages);
+        fd = open(argv[11], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            fprintf(stderr, "Couldn't open %s\n", argv[11]);
+            return 1;
+        }
+        start = monoSec();
+        if (!runGridPlaced(&job, rowBegin, rowEnd, fd, naive, &plan) || close(fd) != 0)
+        {
+            fprintf(stderr, "Couldn't allocate the raster or write %s\n", argv[11]);
+            return 1;
+        }
+        fprintf(stderr, "%d sites x %d days on %d threads in %.2f s (%.1f ns per site-day)\n", (rowEnd - rowBegin) * job.numLon,
+                job.numDays, plan.numThreads < rowEnd - rowBegin ? plan.numThreads : rowEnd - rowBegin, monoSec() - start,
+                (monoSec() - start) * 1e9 / ((double)(rowEnd - rowBegin) * job.numLon * job.numDays));
+        return 0;
+    }
+
+    if (columnar)
+    {
+        startClock = clock();
+        if (!runGridColumns(&job, rowBegin, rowEnd, argv[11]))
+        {
+            fprintf(stderr, "Couldn't create %s\n", argv[11]);
+            return 1;
+        }
+        fprintf(stderr, "%d sites x %d days in %.2f s\n", (rowEnd - rowBegin) * job.numLon, job.numDays,
+                (double)(clock() - startClock) / CLOCKS_PER_SEC);
+        return 0;
+    }
+
+    outFile = fopen(argv[11], "wb");
+    if (!outFile)
+    {
+        fprintf(stderr, "Couldn't open %s\n", argv[11]);
+        return 1;
+    }
+
+    startClock = clock();
+    if (!runGrid(&job, rowBegin, rowEnd, outFile, naive) | (fclose(outFile) != 0))
+    {
+        fprintf(stderr, "Couldn't allocate the raster or write %s\n", argv[11]);
+        return 1;
+    }
+    fprintf(stderr, "%d sites x %d days in %.2f s (%.1f ns per site-day)\n", (rowEnd - rowBegin) * job.numLon, job.numDays,
+            (double)(clock() - startClock) / CLOCKS_PER_SEC,
+            (double)(clock() - startClock) / CLOCKS_PER_SEC * 1e9 / ((double)(rowEnd - rowBegin) * job.numLon * job.numDays));
+
+    return 0;
+}
+
+/**
+ * Calculates yearly statistics for every point of a latitude/longitude raster and writes one SiteYearStats record per
+ * site and year (sites in the same order as grid mode, years in order within a site). Sites are calculated in
+ * parallel, a stripe at a time.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: stats latMin latMax lonMin lonMax step YYYY numYears outFile
+ *
+ *  Output:
+ * Program exit status
+ **/
+int statsMode(int argc, char *argv[])
+{
+    SiteArrays sites;       // the raster's sites
+    DateEphem *ephs;        // per-date terms
+    SiteYearStats *out;     // records for one stripe of sites
+    FILE *outFile;          // output file
+    double latMin, latMax;  // latitude range (deg)
+    double lonMin, lonMax;  // longitude range (deg)
+    double step;            // raster spacing (deg)
+    int numLat, numLon;     // raster dimensions
+    int firstYear;          // first year
+    int numYears;           // number of years
+    int numDays = 0;        // number of days in all the years
+    double startJDate;      // Julian date of the first day
+    int stripeEnd;          // one past the last site of the current stripe
+    time_t startTime;       // wall clock time at the start
+
+    if (argc != 10)
+    {
+        fprintf(stderr, "Usage: %s stats latMin latMax lonMin lonMax step YYYY numYears outFile\n", argv[0]);
+        return 1;
+    }
+    latMin = atof(argv[2]);
+    latMax = atof(argv[3]);
+    lonMin = atof(argv[4]);
+    lonMax = atof(argv[5]);
+    step = atof(argv[6]);
+    firstYear = atoi(argv[7]);
+    numYears = atoi(argv[8]);
+    if (step <= 0 || latMin > latMax || lonMin > lonMax || fmax(fabs(latMin), fabs(latMax)) >= LATRANGE ||
+        fmax(fabs(lonMin), fabs(lonMax)) >= LONGRANGE || firstYear <= 0 || numYears < 1)
+    {
+        fprintf(stderr, "Invalid raster or years\n");
+        return 1;
+    }
+
+    numLat = (int)floor((latMax - latMin) / step + 1e-9) + 1;
+    numLon = (int)floor((lonMax - lonMin) / step + 1e-9) + 1;
+    for (int y = 0; y < numYears; y++)
+    {
+        numDays += DAYSINYEAR + isLeapYear(firstYear + y);
+    }
+    startJDate = calcJDate(1, JAN, firstYear, 0);
+
+    outFile = fopen(argv[9], "wb");
+    ephs = malloc(numDays * sizeof(DateEphem));
+    out = malloc((size_t)STATSTRIPE * numYears * sizeof(SiteYearStats));
+    if (!outFile || !ephs || !out || !allocSiteArrays(&sites, numLat * numLon))
+    {
+        fprintf(stderr, "Couldn't open %s or allocate the raster\n", argv[9]);
+        return 1;
+    }
+
+    startTime = time(NULL);
+    for (int i = 0; i < numLat; i++)
+    {
+        for (int j = 0; j < numLon; j++)
+        {
+            sites.latitude[i * numLon + j] = latMin + i * step;
+            sites.longitude[i * numLon + j] = lonMin + j * step;
+        }
+    }
+    prepSiteArrays(&sites);
+    for (int d = 0; d < numDays; d++)
+    {
+        calcDateEphem(&ephs[d], startJDate + d);
+    }
+
+    for (int siteBegin = 0; siteBegin < sites.numSites; siteBegin += STATSTRIPE)
+    {
+        stripeEnd = siteBegin + STATSTRIPE < sites.numSites ? siteBegin + STATSTRIPE : sites.numSites;
+        OMP(parallel for schedule(dynamic, SITEBLOCK))
+        for (int i = siteBegin; i < stripeEnd; i++)
+        {
+            siteYearStats(&sites, ephs, i, firstYear, numYears, out + (size_t)(i - siteBegin) * numYears);
+        }
+        fwrite(out, sizeof(SiteYearStats), (size_t)(stripeEnd - siteBegin) * numYears, outFile);
+    }
+
+    fprintf(stderr, "%d sites x %d years in %.0f s\n", sites.numSites, numYears, difftime(time(NULL), startTime));
+
+    fclose(outFile);
+    freeSiteArrays(&sites);
+    free(ephs);
+    free(out);
+
+    return 0;
+}
+
+/**
+ * Predicts the cost of one row of a grid job from the number of solver iterations on a sample of its days. The
+ * solver doesn't depend on longitude, so one site stands for the whole row.
+ *
+ *  Inputs:
+ * job: the grid job
+ * sampleEphs: per-date terms for every SHARDSAMPLE-th day of the job
+ * numSamples: number of sampled days
+ * row: the row
+ *
+ *  Output:
+ * Predicted cost, in solver iterations plus one per event written
+ **/
+double rowCost(const GridJob *job, const DateEphem *sampleEphs, int numSamples, int row)
+{
+    double latitude; // latitude of the row (deg)
+    double secLat;   // 1 / cos(latitude)
+    double tanLat;   // tangent of the latitude
+    int iters = 0;   // iterations over the sample
+
+    latitude = job->latMin + row * job->step;
+    secLat = 1 / cosd(latitude);
+    tanLat = tand(latitude);
+    for (int d = 0; d < numSamples; d++)
+    {
+        for (int e = 1; e <= 3; e++)
+        {
+            gridEvent(&sampleEphs[d], secLat, tanLat, e, &iters);
+        }
+    }
+
+    return ((double)iters / numSamples + 3) * job->numDays * job->numLon;
+}
+
+/**
+ * Splits a grid job into contiguous bands of rows with roughly equal predicted cost
+ *
+ *  Inputs:
+ * job: the grid job
+ * numShards: number of bands. No more than the number of rows
+ * bounds: array of numShards + 1 in which to store the first row of each band, then the number of rows
+ *
+ *  Output:
+ * None (pointer)
+ **/
+void planShards(const GridJob *job, int numShards, int *bounds)
+{
+    DateEphem *sampleEphs; // per-date terms for the sampled days
+    double *costs;         // predicted cost of each row
+    double total = 0;      // predicted cost of the job
+    double sum = 0;        // predicted cost of the rows so far
+    int numSamples;        // number of sampled days
+    int shard = 1;         // next band to start
+
+    numSamples = (job->numDays + SHARDSAMPLE - 1) / SHARDSAMPLE;
+    sampleEphs = malloc(numSamples * sizeof(DateEphem));
+    costs = malloc(job->numLat * sizeof(double));
+    for (int d = 0; d < numSamples; d++)
+    {
+        calcDateEphem(&sampleEphs[d], job->startJDate + d * SHARDSAMPLE);
+    }
+    for (int i = 0; i < job->numLat; i++)
+    {
+        costs[i] = rowCost(job, sampleEphs, numSamples, i);
+        total += costs[i];
+    }
+
+    // cut after the row that takes the running cost past each band's share, leaving a row for every later band
+    bounds[0] = 0;
+    for (int i = 0; i < job->numLat && shard < numShards; i++)
+    {
+        sum += costs[i];
+        if (sum >= total * shard / numShards || job->numLat - (i + 1) == numShards - shard)
+        {
+            bounds[shard++] = i + 1;
+        }
+    }
+    bounds[numShards] = job->numLat;
+
+    free(sampleEphs);
+    free(costs);
+}
+
+/**
+ * Runs a grid job as several processes, one per band of rows, then joins their outputs in row order. The result is
+ * byte for byte the same as grid mode's. Bands are sized by predicted cost, since rows near the polar day/night
+ * limits take more iterations than others.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: shard numShards latMin latMax lonMin lonMax step YYYY MM DD numDays outFile [epoch s|ms]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int shardMode(int argc, char *argv[])
+{
+    GridJob job;                   // the raster and dates
+    int numShards;                 // number of processes
+    int bounds[MAXSHARDS + 1];     // first row of each band
+    pid_t pids[MAXSHARDS];         // process of each band
+    char partName[BUFSIZ];         // file name of a band's output
+    char buffer[BUFSIZ];           // copy buffer for joining
+    FILE *outFile;                 // joined output
+    FILE *partFile;                // a band's output
+    size_t numRead;                // bytes read into the buffer
+    int procStatus;                // exit status of a band's process
+    int failed = 0;                // whether any band failed
+    int joined;                    // whether every band was copied into the output
+
+    numShards = argc >= 13 ? atoi(argv[2]) : 0;
+    if ((argc != 13 && !(argc == 15 && strcmp(argv[13], "epoch") == 0)) || !parseGridJob(&job, argv + 3) ||
+        (argc == 15 && !parseEpochUnits(&job, argv[14])) || numShards < 1 || numShards > MAXSHARDS)
+    {
+        fprintf(stderr, "Usage: %s shard numShards latMin latMax lonMin lonMax step YYYY MM DD numDays outFile [epoch s|ms]\n", argv[0]);
+        return 1;
+    }
+    if (numShards > job.numLat)
+    {
+        numShards = job.numLat;
+    }
+
+    planShards(&job, numShards, bounds);
+    fflush(NULL);
+    for (int k = 0; k < numShards; k++)
+    {
+        snprintf(partName, BUFSIZ, "%s.part%d", argv[12], k);
+        fprintf(stderr, "shard %d: rows %d to %d\n", k, bounds[k], bounds[k + 1] - 1);
+        pids[k] = fork();
+        if (pids[k] == 0)
+        {
+            partFile = fopen(partName, "wb");
+            _exit(!partFile || !runGrid(&job, bounds[k], bounds[k + 1], partFile, 0) || fclose(partFile) != 0);
+        }
+        failed |= pids[k] < 0;
+    }
+
+    for (int k = 0; k < numShards; k++)
+    {
+        if (pids[k] > 0 && (waitpid(pids[k], &procStatus, 0) < 0 || !WIFEXITED(procStatus) || WEXITSTATUS(procStatus) != 0))
+        {
+            fprintf(stderr, "shard %d failed\n", k);
+            failed = 1;
+        }
+    }
+
+    // a band that can't be read or copied fails the whole join, rather than leaving a short output behind
+    outFile = failed ? NULL : fopen(argv[12], "wb");
+    joined = outFile != NULL;
+    for (int k = 0; k < numShards; k++)
+    {
+        snprintf(partName, BUFSIZ, "%s.part%d", argv[12], k);
+        partFile = joined ? fopen(partName, "rb") : NULL;
+        if (joined && !partFile)
+        {
+            fprintf(stderr, "Couldn't open %s\n", partName);
+            joined = 0;
+        }
+        while (partFile && joined && (numRead = fread(buffer, 1, BUFSIZ, partFile)) > 0)
+        {
+            joined = fwrite(buffer, 1, numRead, outFile) == numRead;
+        }
+        if (partFile)
+        {
+            if (ferror(partFile))
+            {
+                fprintf(stderr, "Couldn't read %s\n", partName);
+                joined = 0;
+            }
+            fclose(partFile);
+        }
+        remove(partName);
+    }
+    if (outFile && (ferror(outFile) | (fclose(outFile) != 0)))
+    {
+        joined = 0;
+    }
+    if (!joined)
+    {
+        fprintf(stderr, "Couldn't write %s\n", argv[12]);
+        if (outFile)
+        {
+            remove(argv[12]);
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Reads rows of a columnar result file in place, without copying it, and prints them. Any number of these can read
+ * the same file (or shared memory segment) at once.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: colread file [firstRow numRows]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int colReadMode(int argc, char *argv[])
+{
+    const ColHeader *header;      // the file's header
+    const ColEntry *entries;      // the file's column descriptions
+    const unsigned char *base;    // start of the mapped file
+    const unsigned char *bitmap;  // a column's validity bitmap
+    struct stat fileInfo;         // the file's size
+    uint64_t fileSize;            // the file's size in bytes
+    uint64_t width;               // bytes per value of a column
+    uint64_t firstRow = 0;        // first row to print
+    uint64_t numRows = 10;        // number of rows to print
+    int fd;                       // file descriptor
+    int valid;                    // whether every column lies inside the file
+
+    if (argc != 3 && argc != 5)
+    {
+        fprintf(stderr, "Usage: %s colread file [firstRow numRows]\n", argv[0]);
+        return 1;
+    }
+    if (argc == 5)
+    {
+        firstRow = strtoull(argv[3], NULL, 10);
+        numRows = strtoull(argv[4], NULL, 10);
+    }
+
+    fd = open(argv[2], O_RDONLY);
+    if (fd < 0 || fstat(fd, &fileInfo) != 0 || (size_t)fileInfo.st_size < sizeof(ColHeader))
+    {
+        fprintf(stderr, "Couldn't open %s\n", argv[2]);
+        return 1;
+    }
+    base = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    header = (const ColHeader *)base;
+    if (base == MAP_FAILED || memcmp(header->magic, COLMAGIC, sizeof(COLMAGIC)) != 0)
+    {
+        fprintf(stderr, "%s isn't a complete columnar result file\n", argv[2]);
+        if (base != MAP_FAILED)
+        {
+            munmap((void *)base, fileInfo.st_size);
+        }
+        return 1;
+    }
+    entries = (const ColEntry *)(base + sizeof(ColHeader));
+
+    // every buffer must lie inside the file, so a damaged or hostile header can't make the reads run off the map
+    fileSize = fileInfo.st_size;
+    valid = header->numColumns <= (fileSize - sizeof(ColHeader)) / sizeof(ColEntry);
+    for (uint32_t c = 0; c < header->numColumns && valid; c++)
+    {
+        width = entries[c].type == COLINT8 ? 1 : entries[c].type == COLFLOAT32 ? sizeof(float) : 0;
+        valid = width && memchr(entries[c].name, 0, COLNAMELEN) && entries[c].dataOffset % width == 0 &&
+                entries[c].dataOffset <= fileSize && header->numRows <= (fileSize - entries[c].dataOffset) / width &&
+                (!entries[c].nullable ||
+                 (entries[c].validOffset <= fileSize && header->numRows / 8 + 1 <= fileSize - entries[c].validOffset));
+    }
+    if (!valid)
+    {
+        fprintf(stderr, "%s has a bad column description\n", argv[2]);
+        munmap((void *)base, fileInfo.st_size);
+        return 1;
+    }
+
+    printf("%llu rows: %u x %u sites from %g, %g step %g, %u days\nrow", (unsigned long long)header->numRows,
+           header->numLat, header->numLon, header->latMin, header->lonMin, header->step, header->numDays);
+    for (uint32_t c = 0; c < header->numColumns; c++)
+    {
+        printf(" %s", entries[c].name);
+    }
+    printf("\n");
+
+    for (uint64_t r = firstRow; r < firstRow + numRows && r < header->numRows; r++)
+    {
+        printf("%llu", (unsigned long long)r);
+        for (uint32_t c = 0; c < header->numColumns; c++)
+        {
+            bitmap = entries[c].nullable ? base + entries[c].validOffset : NULL;
+            if (bitmap && !(bitmap[r / 8] & (1 << (r % 8))))
+            {
+                printf(" None");
+            }
+            else if (entries[c].type == COLINT8)
+            {
+                printf(" %d", ((const int8_t *)(base + entries[c].dataOffset))[r]);
+            }
+            else
+            {
+                printf(" %.2f", ((const float *)(base + entries[c].dataOffset))[r]);
+            }
+        }
+        printf("\n");
+    }
+
+    munmap((void *)base, fileInfo.st_size);
+
+    return 0;
+}
+
+/**
+ * Builds or runs a horizon catalog
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: horizon build sites.txt catalog, or horizon run catalog YYYY MM DD numDays outFile
+ *
+ *  Output:
+ * Program exit status
+ **/
+int horizonMode(int argc, char *argv[])
+{
+    int year, month, day; // first date
+    int numDays;          // number of days
+
+    if (argc == 5 && strcmp(argv[2], "build") == 0)
+    {
+        if (!buildHorizonCatalog(argv[3], argv[4]))
+        {
+            fprintf(stderr, "Couldn't build %s from %s\n", argv[4], argv[3]);
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc == 9 && strcmp(argv[2], "run") == 0)
+    {
+        year = atoi(argv[4]);
+        month = atoi(argv[5]);
+        day = atoi(argv[6]);
+        numDays = atoi(argv[7]);
+        if (year <= 0 || month < 1 || month > NUMMONTHS || day < 1 || day > monthLen(month, year) || numDays < 1)
+        {
+            fprintf(stderr, "Invalid date\n");
+            return 1;
+        }
+        if (!runHorizonCatalog(argv[3], calcJDate(day, month, year, 0), numDays, argv[8]))
+        {
+            fprintf(stderr, "Couldn't read %s or write %s\n", argv[3], argv[8]);
+            return 1;
+        }
+        return 0;
+    }
+
+    fprintf(stderr, "Usage: %s horizon build sites.txt catalog\n", argv[0]);
+    fprintf(stderr, "       %s horizon run catalog YYYY MM DD numDays outFile\n", argv[0]);
+
+    return 1;
+}
+
+/**
+ * Answers inverse queries: on which dates a site's sunrise, sunset, or amount of sunlight is past a threshold, or
+ * which sites of a file it's past on each date
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments:
+ *  inverse dates latitude longitude YYYY MM DD numDays rise|set|daylen below|above hh:mm [timezone], or
+ *  inverse sites sites.txt YYYY MM DD numDays rise|set|daylen below|above hh:mm [timezone]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int inverseMode(int argc, char *argv[])
+{
+    int sitesQuery;       // 1 for a query over sites, 0 for one over dates
+    int argBase;          // index of the first date argument
+    int year, month, day; // first date
+    int numDays;          // number of days
+    int quantity;         // INVRISE, INVSET, or INVDAYLEN
+    int below;            // 1 to match values below the threshold, 0 above
+    int32_t thresholdSec; // threshold (seconds)
+    const char *parsed;   // end of the parsed threshold
+    double threshold;     // threshold (decimal day)
+    double timeZone = 0;  // time zone in UTC offset
+    double startJDate;    // first day
+    DateQuery query;      // the query over dates
+    unsigned char *dayMatches; // each day's match
+    SiteIndex index;      // the indexed sites
+    DateEphem eph;        // the current date's terms
+    int *siteMatches;     // the matching sites of the current date
+    int numMatches;       // number of matching sites
+    int numEvals = 0;     // number of sites calculated
+    int runStart;         // first day of the current run of matching days
+
+    sitesQuery = argc > 2 && strcmp(argv[2], "sites") == 0;
+    argBase = sitesQuery ? 4 : 5;
+    if (argc < 2 || (!sitesQuery && strcmp(argv[2], "dates") != 0) || (argc != argBase + 7 && argc != argBase + 8))
+    {
+        fprintf(stderr, "Usage: %s inverse dates latitude longitude YYYY MM DD numDays rise|set|daylen below|above hh:mm [timezone]\n", argv[0]);
+        fprintf(stderr, "       %s inverse sites sites.txt YYYY MM DD numDays rise|set|daylen below|above hh:mm [timezone]\n", argv[0]);
+        return 1;
+    }
+
+    year = atoi(argv[argBase]);
+    month = atoi(argv[argBase + 1]);
+    day = atoi(argv[argBase + 2]);
+    numDays = atoi(argv[argBase + 3]);
+    quantity = strcmp(argv[argBase + 4], "rise") == 0 ? INVRISE : strcmp(argv[argBase + 4], "set") == 0 ? INVSET
+             : strcmp(argv[argBase + 4], "daylen") == 0 ? INVDAYLEN : 0;
+    below = strcmp(argv[argBase + 5], "below") == 0;
+    parsed = parseTzOffset(argv[argBase + 6], &thresholdSec);
+    threshold = (double)thresholdSec / SECINDAY;
+    if (argc == argBase + 8)
+    {
+        timeZone = atof(argv[argBase + 7]);
+    }
+    if (year <= 0 || month < 1 || month > NUMMONTHS || day < 1 || day > monthLen(month, year) || numDays < 1 ||
+        quantity == 0 || (!below && strcmp(argv[argBase + 5], "above") != 0) || *parsed != '\0' || fabs(timeZone) > 13)
+    {
+        fprintf(stderr, "Invalid date, quantity, comparison, threshold, or time zone\n");
+        return 1;
+    }
+
+    if (!sitesQuery)
+    {
+        query.latitude = atof(argv[3]);
+        query.longitude = atof(argv[4]);
+        if (fabs(query.latitude) >= LATRANGE || fabs(query.longitude) >= LONGRANGE)
+        {
+            fprintf(stderr, "Invalid coordinates\n");
+            return 1;
+        }
+        query.startJDate = calcJDate(day, month, year, timeZone);
+        query.tZ = timeZone;
+        query.quantity = quantity;
+        query.below = below;
+        query.threshold = threshold;
+        query.numEvals = 0;
+        query.values = malloc(numDays * sizeof(double));
+        dayMatches = malloc(numDays);
+        if (!query.values || !dayMatches)
+        {
+            free(query.values);
+            free(dayMatches);
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        for (int d = 0; d < numDays; d++)
+        {
+            query.values[d] = INVUNKNOWN;
+        }
+
+        fillDateMatches(&query, numDays, dayMatches);
+
+        // matching days are printed as runs: first and last date
+        runStart = -1;
+        for (int d = 0; d <= numDays; d++)
+        {
+            if (d < numDays && dayMatches[d] && runStart < 0)
+            {
+                runStart = d;
+                calcDate(query.startJDate + d, 0, &day, &month, &year);
+                printf("%04d-%02d-%02d ", year, month, day);
+            }
+            else if ((d == numDays || !dayMatches[d]) && runStart >= 0)
+            {
+                calcDate(query.startJDate + d - 1, 0, &day, &month, &year);
+                printf("%04d-%02d-%02d\n", year, month, day);
+                runStart = -1;
+            }
+        }
+        fprintf(stderr, "evaluated %d of %d dates\n", query.numEvals, numDays);
+
+        free(query.values);
+        free(dayMatches);
+        return 0;
+    }
+
+    if (!loadSiteIndex(&index, argv[3]))
+    {
+        fprintf(stderr, "Couldn't read %s\n", argv[3]);
+        return 1;
+    }
+    siteMatches = malloc((index.numSites + 1) * sizeof(int));
+    if (!siteMatches)
+    {
+        freeSiteIndex(&index);
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    startJDate = calcJDate(day, month, year, 0);
+    for (int d = 0; d < numDays; d++)
+    {
+        calcDateEphem(&eph, startJDate + d);
+        numMatches = querySiteIndex(&index, &eph, quantity, below, threshold, timeZone, siteMatches, &numEvals);
+        for (int i = 0; i < numMatches; i++)
+        {
+            printf("%04d-%02d-%02d %d\n", year, month, day, siteMatches[i]);
+        }
+        advanceDate(&day, &month, &year);
+    }
+    fprintf(stderr, "evaluated %d of %lld site-days\n", numEvals, (long long)index.numSites * numDays);
+
+    free(siteMatches);
+    freeSiteIndex(&index);
+
+    return 0;
+}
+
+/**
+ * Compares every engine with a long double reference of the same formulas over a raster of sites, plus rows along
+ * both polar circles and columns at the antimeridian, and prints a table of throughput, maximum and 99th percentile
+ * error, and sunrises/sunsets whose existence (the polar status) disagrees with the reference. An engine passes if
+ * its maximum error is within maxErr seconds and at most maxStatusDiffs statuses disagree.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: accuracy latMin latMax lonMin lonMax step YYYY MM DD numDays [maxErr [maxStatusDiffs]]
+ *
+ *  Output:
+ * Program exit status: 0 if every engine passes
+ **/
+int accuracyMode(int argc, char *argv[])
+{
+    static const char *engineNames[NUMENGINES] = {"calcEvent", "enumerator", "grid", "grid float32", "horizon flat",
+                                                   "calcEvent span"};
+    GridJob job;           // the raster and dates
+    SiteArrays sites;      // raster, polar circle, and antimeridian sites
+    DateEphem *ephs;       // per-date terms
+    double *ref;           // reference events
+    double *out;           // an engine's events
+    float *errs;           // an engine's errors (s)
+    size_t numValues;      // number of site-day events
+    size_t numErrs;        // number of errors
+    int statusDiffs;       // sunrises/sunsets that exist in the engine or the reference but not both
+    double maxErr;         // allowed error (s)
+    int maxStatusDiffs;    // allowed number of status disagreements
+    int passed;            // whether the current engine passed
+    double engineSec;      // time the engine took (s)
+    double value;          // the event that only one of the engine and the reference has
+    int numSites;          // number of sites
+    int site;              // current site
+    int failed = 0;        // whether any engine failed
+    struct timespec start; // start of the timed part
+
+    if (argc < 11 || argc > 13 || !parseGridJob(&job, argv + 2))
+    {
+        fprintf(stderr, "Usage: %s accuracy latMin latMax lonMin lonMax step YYYY MM DD numDays [maxErr [maxStatusDiffs]]\n", argv[0]);
+        return 1;
+    }
+    maxErr = argc >= 12 ? atof(argv[11]) : ACCMAXERR;
+    maxStatusDiffs = argc == 13 ? atoi(argv[12]) : 0;
+
+    numSites = job.numLat * job.numLon + 2 * EDGEROWS * EDGECOLS + 2 * job.numLat;
+    numValues = (size_t)numSites * job.numDays * 3;
+    ephs = malloc(job.numDays * sizeof(DateEphem));
+    ref = malloc(numValues * sizeof(double));
+    out = malloc(numValues * sizeof(double));
+    errs = malloc(numValues * sizeof(float));
+    if (!ephs || !ref || !out || !errs || !allocSiteArrays(&sites, numSites))
+    {
+        free(ephs);
+        free(ref);
+        free(out);
+        free(errs);
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    site = 0;
+    for (int i = 0; i < job.numLat; i++)
+    {
+        for (int j = 0; j < job.numLon; j++, site++)
+        {
+            sites.latitude[site] = job.latMin + i * job.step;
+            sites.longitude[site] = job.lonMin + j * job.step;
+        }
+        // either side of the antimeridian
+        for (int j = 0; j < 2; j++, site++)
+        {
+            sites.latitude[site] = job.latMin + i * job.step;
+            sites.longitude[site] = j == 0 ? -(LONGRANGE - 0.01) : LONGRANGE - 0.01;
+        }
+    }
+    // across the polar circles, where days go from having a sunrise and sunset to having neither
+    for (int r = 0; r < 2 * EDGEROWS; r++)
+    {
+        for (int c = 0; c < EDGECOLS; c++, site++)
+        {
+            sites.latitude[site] = (r < EDGEROWS ? 1 : -1) * (EDGELATMIN + (r % EDGEROWS) * EDGELATSTEP);
+            sites.longitude[site] = -(LONGRANGE - 0.01) + c * (2 * LONGRANGE - 0.02) / (EDGECOLS - 1);
+        }
+    }
+    prepSiteArrays(&sites);
+
+    // the reference isn't one of the timed engines, so it can use every core
+    OMP(parallel for schedule(dynamic, 1))
+    for (int i = 0; i < numSites; i++)
+    {
+        for (int d = 0; d < job.numDays; d++)
+        {
+            for (int e = 0; e < 3; e++)
+            {
+                ref[((size_t)i * job.numDays + d) * 3 + e] = calcEventRef(job.startJDate + d, sites.longitude[i], sites.latitude[i], e + 1);
+            }
+        }
+    }
+    printf("%-14s %14s %10s %12s %12s %12s  %s\n", "engine", "events/s", "compared", "max err (s)", "p99 err (s)", "status diffs", "gate");
+    printf("%-14s %14s %10zu %12s %12s %12s\n", "reference", "-", numValues, "-", "-", "-");
+    for (size_t k = 0; k < numValues; k++)
+    {
+        ref[k] = ref[k] < -1 ? NAN : ref[k];
+    }
+
+    for (int engine = 0; engine < NUMENGINES; engine++)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (engine == ENGGRID || engine == ENGFLOAT32 || engine == ENGHORIZON)
+        {
+            for (int d = 0; d < job.numDays; d++)
+            {
+                calcDateEphem(&ephs[d], job.startJDate + d);
+            }
+        }
+        engineEvents(engine, &sites, ephs, job.startJDate, job.numDays, ref, out);
+        engineSec = elapsedSec(&start);
+
+        numErrs = 0;
+        statusDiffs = 0;
+        for (size_t k = 0; k < numValues; k++)
+        {
+            if (isnan(ref[k]) != isnan(out[k]))
+            {
+                // solar noon only goes missing by convention, and the enumerator always reports it. An event past
+                // midnight is the next day's to the enumerator and this day's to calcEvent, which isn't a disagreement
+                value = isnan(ref[k]) ? out[k] : ref[k];
+                if (k % 3 != 1 && value >= 0 && value < 1 && statusDiffs++ < MAXSTATUSLIST)
+                {
+                    fprintf(stderr, "%s: %s at %.2f, %.2f on day %zu: reference %.5f, engine %.5f\n", engineNames[engine],
+                            k % 3 == 0 ? "sunrise" : "sunset", sites.latitude[k / 3 / job.numDays],
+                            sites.longitude[k / 3 / job.numDays], k / 3 % job.numDays, ref[k], out[k]);
+                }
+            }
+            else if (!isnan(ref[k]))
+            {
+                errs[numErrs++] = fabs(out[k] - ref[k]) * SECINDAY;
+            }
+        }
+        qsort(errs, numErrs, sizeof(float), compareFloats);
+        passed = (numErrs == 0 || errs[numErrs - 1] <= maxErr) && statusDiffs <= maxStatusDiffs;
+        printf("%-14s %14.0f %10zu %12.3f %12.3f %12d  %s\n", engineNames[engine], numValues / engineSec, numErrs,
+               numErrs ? errs[numErrs - 1] : 0.0, numErrs ? errs[(size_t)(ACCPERCENTILE * (numErrs - 1))] : 0.0, statusDiffs,
+               passed ? "PASS" : "FAIL");
+        failed |= !passed;
+    }
+
+    freeSiteArrays(&sites);
+    free(ephs);
+    free(ref);
+    free(out);
+    free(errs);
+
+    return failed;
+}
+
+/**
+ * Generates compact sunrise/sunset tables and their decoder for small devices
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: table sites.txt YYYY numYears out.h
+ *
+ *  Output:
+ * Program exit status
+ **/
+int tableMode(int argc, char *argv[])
+{
+    int firstYear; // first year of the tables
+    int numYears;  // number of years
+
+    if (argc != 6)
+    {
+        fprintf(stderr, "Usage: %s table sites.txt YYYY numYears out.h\n", argv[0]);
+        return 1;
+    }
+    firstYear = atoi(argv[3]);
+    numYears = atoi(argv[4]);
+    if (firstYear <= 0 || numYears < 1)
+    {
+        fprintf(stderr, "Invalid years\n");
+        return 1;
+    }
+
+    return writeSunTables(argv[2], firstYear, numYears, argv[5]) ? 0 : 1;
+}
+
+/**
+ * Searches for the inputs that make calcEvent and calcEventDay iterate the most, or replays a corpus of them. The
+ * search samples at random, then climbs from the most expensive samples with moves that shrink from a degree to
+ * FUZZMINSCALE, keeping any move that costs at least as much. A replay fails if any case now takes more iterations
+ * than recorded.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: fuzz search numSamples seed corpus.txt, or fuzz replay corpus.txt
+ *
+ *  Output:
+ * Program exit status
+ **/
+int fuzzMode(int argc, char *argv[])
+{
+    static FuzzCase cases[MAXCORPUS]; // corpus cases
+    FuzzCase worst[FUZZKEEP];         // the most expensive cases of the current solver
+    FuzzCase sample;                  // current sample
+    FuzzCase best;                    // current climb position
+    int numWorst;                     // number of cases in worst
+    int numCases = 0;                 // number of corpus cases
+    int numSamples;                   // random samples per solver
+    int recorded;                     // a case's recorded iterations
+    int regressions = 0;              // cases that now take more iterations
+    double scale;                     // current move size (deg)
+
+    if (argc == 6 && strcmp(argv[2], "search") == 0)
+    {
+        numSamples = atoi(argv[3]);
+        srand(atoi(argv[4]));
+        for (int solver = FUZZEVENT; solver <= FUZZDAY; solver++)
+        {
+            numWorst = 0;
+            // calcEventDay walks day by day, so fewer of its samples fit the same time
+            for (int i = 0; i < (solver == FUZZEVENT ? numSamples : numSamples / 16 + 1); i++)
+            {
+                randomCase(&sample, solver);
+                keepWorst(worst, &numWorst, &sample);
+            }
+            for (int k = 0; k < numWorst; k++)
+            {
+                best = worst[k];
+                for (int round = 0; round < FUZZROUNDS; round++)
+                {
+                    scale = pow(10, -7.0 * round / FUZZROUNDS);
+                    mutateCase(&sample, &best, fmax(scale, FUZZMINSCALE));
+                    if (sample.iters >= best.iters)
+                    {
+                        best = sample;
+                    }
+                }
+                best.nsPerCall = timeCase(&best);
+                cases[numCases++] = best;
+                printf("%-12s %12.7f %13.7f iterations %5d %10.0f ns\n", solver == FUZZEVENT ? "calcEvent" : "calcEventDay",
+                       best.latitude, best.longitude, best.iters, best.nsPerCall);
+            }
+        }
+        if (!writeCorpus(argv[5], cases, numCases))
+        {
+            fprintf(stderr, "Couldn't write %s\n", argv[5]);
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc == 4 && strcmp(argv[2], "replay") == 0)
+    {
+        numCases = readCorpus(argv[3], cases, MAXCORPUS);
+        if (numCases < 0)
+        {
+            fprintf(stderr, "Couldn't read %s\n", argv[3]);
+            return 1;
+        }
+        printf("%-12s %12s %13s %9s %9s %10s %10s\n", "solver", "latitude", "longitude", "recorded", "iters", "ns", "");
+        for (int i = 0; i < numCases; i++)
+        {
+            recorded = cases[i].iters;
+            fuzzCost(&cases[i]);
+            cases[i].nsPerCall = timeCase(&cases[i]);
+            regressions += cases[i].iters > recorded;
+            printf("%-12s %12.7f %13.7f %9d %9d %10.0f %10s\n", cases[i].solver == FUZZEVENT ? "calcEvent" : "calcEventDay",
+                   cases[i].latitude, cases[i].longitude, recorded, cases[i].iters, cases[i].nsPerCall,
+                   cases[i].iters > recorded ? "REGRESSED" : "ok");
+        }
+        return regressions > 0;
+    }
+
+    fprintf(stderr, "Usage: %s fuzz search numSamples seed corpus.txt\n", argv[0]);
+    fprintf(stderr, "       %s fuzz replay corpus.txt\n", argv[0]);
+
+    return 1;
+}
+
+/**
+ * Classifies telemetry rows as day, twilight, or night. Reads "latitude longitude timestamp" lines from stdin and
+ * prints each row's sun elevation and class, or with "bench", times classifyLight on synthetic rows and checks it
+ * against sunElevation.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: light [epoch s|ms], or light bench numRows [shuffled]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int lightMode(int argc, char *argv[])
+{
+    const char *names[] = {"night", "astronomical", "nautical", "civil", "day"}; // class names
+    char inputStr[BUFSIZ]; // input line
+    GridJob units;         // timestamp units, parsed as for grid mode
+    LightBatch batch;      // rows being classified
+    LightCache cache;      // shared ephemeris nodes
+    double *latitude;      // latitude column
+    double *longitude;     // longitude column
+    int64_t *times;        // timestamp column
+    float *elevation;      // elevation column
+    int8_t *light;         // class column
+    size_t numRows;        // rows in the batch
+    int lineNum = 0;       // input line number
+    int shuffled;          // whether bench rows are in random time order
+    long long timeIn;      // timestamp as read
+    int64_t swapTime;      // timestamp being swapped
+    struct timespec start; // when a timed run started
+    double classSec;       // classifyLight time without elevation (s)
+    double fastSec;        // classifyLight time with elevation (s)
+    int numEvals;          // ephemeris evaluations without elevation
+    double directSec;      // sunElevation time (s)
+    double err;            // a row's elevation error (deg)
+    double maxErr = 0;     // largest elevation error (deg)
+    size_t mismatches = 0; // rows whose class differs from sunElevation's
+    size_t j;              // row to swap with
+
+    initLightCache(&cache);
+    units.epochUnits = SECINDAY;
+    if (argc >= 4 && strcmp(argv[2], "bench") == 0)
+    {
+        numRows = strtoull(argv[3], NULL, 10);
+        shuffled = argc == 5 && strcmp(argv[4], "shuffled") == 0;
+        if (numRows == 0 || argc > 5 || (argc == 5 && !shuffled))
+        {
+            fprintf(stderr, "Usage: %s light bench numRows [shuffled]\n", argv[0]);
+            return 1;
+        }
+    }
+    else if (argc == 2 || (argc == 4 && strcmp(argv[2], "epoch") == 0 && parseEpochUnits(&units, argv[3])))
+    {
+        numRows = LIGHTCHUNK;
+        shuffled = -1;
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s light [epoch s|ms] < rows.txt\n", argv[0]);
+        fprintf(stderr, "       %s light bench numRows [shuffled]\n", argv[0]);
+        return 1;
+    }
+
+    latitude = malloc(numRows * sizeof(double));
+    longitude = malloc(numRows * sizeof(double));
+    times = malloc(numRows * sizeof(int64_t));
+    elevation = malloc(numRows * sizeof(float));
+    light = malloc(numRows * sizeof(int8_t));
+    if (!latitude || !longitude || !times || !elevation || !light)
+    {
+        fprintf(stderr, "Out of memory\n");
+        free(latitude);
+        free(longitude);
+        free(times);
+        free(elevation);
+        free(light);
+        return 1;
+    }
+    batch.latitude = latitude;
+    batch.longitude = longitude;
+    batch.time = times;
+    batch.epochUnits = units.epochUnits;
+    batch.elevation = elevation;
+    batch.light = light;
+
+    if (shuffled < 0)
+    {
+        // classify LIGHTCHUNK lines at a time, so the rows of a chunk share nodes
+        batch.numRows = 0;
+        while (1)
+        {
+            if (fgets(inputStr, BUFSIZ, stdin) != NULL)
+            {
+                lineNum++;
+                if (sscanf(inputStr, "%lf %lf %lld", &latitude[batch.numRows], &longitude[batch.numRows], &timeIn) != 3 ||
+                    fabs(latitude[batch.numRows]) > LATRANGE || fabs(longitude[batch.numRows]) > LONGRANGE)
+                {
+                    fprintf(stderr, "Skipping invalid input on line %d\n", lineNum);
+                    continue;
+                }
+                times[batch.numRows++] = timeIn;
+                if (batch.numRows < numRows)
+                {
+                    continue;
+                }
+            }
+            else if (batch.numRows == 0)
+            {
+                break;
+            }
+            classifyLight(&batch, &cache);
+            for (size_t i = 0; i < batch.numRows; i++)
+            {
+                printf("%g %g %lld %.3f %s\n", latitude[i], longitude[i], (long long)times[i], elevation[i], names[light[i]]);
+            }
+            batch.numRows = 0;
+        }
+    }
+    else
+    {
+        // telemetry-like rows: random sites, timestamps rising over LIGHTBENCHDAYS days from 2024-01-01
+        srand(1);
+        for (size_t i = 0; i < numRows; i++)
+        {
+            latitude[i] = fuzzRandom(-LATRANGE, LATRANGE);
+            longitude[i] = fuzzRandom(-LONGRANGE, LONGRANGE);
+            times[i] = 1704067200 + (int64_t)((double)i / numRows * LIGHTBENCHDAYS * SECINDAY);
+        }
+        for (size_t i = numRows - 1; shuffled && i > 0; i--)
+        {
+            j = (size_t)fuzzRandom(0, i + 1) % (i + 1);
+            swapTime = times[i];
+            times[i] = times[j];
+            times[j] = swapTime;
+        }
+        batch.numRows = numRows;
+
+        batch.elevation = NULL;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        classifyLight(&batch, &cache);
+        classSec = elapsedSec(&start);
+        numEvals = cache.numEvals;
+
+        initLightCache(&cache);
+        batch.elevation = elevation;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        classifyLight(&batch, &cache);
+        fastSec = elapsedSec(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < numRows; i++)
+        {
+            err = sunElevation(latitude[i], longitude[i], times[i], SECINDAY);
+            // keep the result live, and compare it after the timing
+            elevation[i] -= err;
+        }
+        directSec = elapsedSec(&start);
+
+        for (size_t i = 0; i < numRows; i++)
+        {
+            err = elevation[i];
+            maxErr = fmax(maxErr, fabs(err));
+            elevation[i] = sunElevation(latitude[i], longitude[i], times[i], SECINDAY);
+            mismatches += light[i] != (elevation[i] > ASTROANGLE) + (elevation[i] > NAUTICALANGLE) +
+                                      (elevation[i] > CIVILANGLE) + (elevation[i] > TWILIGHTANGLE);
+        }
+        printf("rows                 %zu (%s timestamps over %d days)\n", numRows, shuffled ? "shuffled" : "rising", LIGHTBENCHDAYS);
+        printf("classifyLight        %.2f ns per row, %d ephemeris evaluations\n", classSec * 1e9 / numRows, numEvals);
+        printf("  with elevation     %.2f ns per row\n", fastSec * 1e9 / numRows);
+        printf("sunElevation         %.2f ns per row\n", directSec * 1e9 / numRows);
+        printf("max elevation error  %.2e deg\n", maxErr);
+        printf("class mismatches     %zu\n", mismatches);
+    }
+
+    free(latitude);
+    free(longitude);
+    free(times);
+    free(elevation);
+    free(light);
+
+    return 0;
+}
+
+/**
+ * Answers sunrise/sunset requests from stdin until end of input, each within its own deadline. Requests are
+ * "latitude longitude timezone YYYY MM DD deadline", with the deadline in microseconds after the request is read, and
+ * each answer is flushed as soon as it's ready. An answer starts with its source and its error bound in minutes:
+ * "exact 0" or "cached 0" for exact answers, "estimate N" when the deadline didn't allow an exact one. A day with
+ * events is answered as "R HH:MM N HH:MM S HH:MM". A polar day or night is answered as "day" or "night" followed by
+ * the date and time of the last event before it and the next event after it, or "none" if there isn't one within
+ * MAXEVENTDAYS days. The line "stats" prints the counters, which are also printed to stderr at the end.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: serve
+ *
+ *  Output:
+ * Program exit status
+ **/
+int serveMode(int argc, char *argv[])
+{
+    static ServeState state; // the service state
+    char inputStr[BUFSIZ];   // input line
+    double latitude;         // latitude (deg)
+    double longitude;        // longitude (deg)
+    double timeZone;         // time zone in UTC offset
+    int year;                // year
+    int month;               // month of the year
+    int day;                 // day of the month
+    double deadlineUs;       // time allowed for the answer (microseconds)
+    double start;            // when a request was read (monoSec)
+    double jDate;            // Julian date of a request's day
+    double calibDays;        // days walked by the calibration
+    int lineNum = 0;         // input line number
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s serve < requests.txt\n", argv[0]);
+        return 1;
+    }
+
+    // calibrate the walk's speed on a polar night: from midwinter at SERVECALIBLAT to the first sunrise
+    jDate = calcJDate(21, DEC, 2024, 0);
+    start = monoSec();
+    calibDays = calcEventDay(0, SERVECALIBLAT, 0, jDate, 1) - jDate + 1;
+    state.nsPerDay = (monoSec() - start) * 1e9 / calibDays;
+
+    while (fgets(inputStr, BUFSIZ, stdin) != NULL)
+    {
+        start = monoSec();
+        lineNum++;
+        if (strncmp(inputStr, "stats", 5) == 0)
+        {
+            printServeStats(stdout, &state);
+            fflush(stdout);
+            continue;
+        }
+        if (sscanf(inputStr, "%lf %lf %lf %d %d %d %lf", &latitude, &longitude, &timeZone, &year, &month, &day, &deadlineUs) != 7 ||
+            fabs(latitude) >= LATRANGE || fabs(longitude) >= LONGRANGE || fabs(timeZone) > 13 || year <= 0 || month < 1 ||
+            month > NUMMONTHS || day < 1 || day > monthLen(month, year) || deadlineUs < 0)
+        {
+            printf("error line %d\n", lineNum);
+            fflush(stdout);
+            continue;
+        }
+        jDate = calcJDate(day, month, year, timeZone);
+        serveRequest(&state, jDate, timeZone, longitude, latitude, start, deadlineUs / 1e6);
+    }
+
+    printServeStats(stderr, &state);
+
+    return 0;
+}
+
+/**
+ * Times a grid job calculated by runGridPlaced with 1, 2, 4, ... threads, up to one per CPU the process may run on,
+ * and prints each run's speedup over one thread. Threads are spread over the NUMA nodes round robin (see
+ * planPlacement), so the larger runs span every socket. The output isn't written, so the runs time the calculation and
+ * its memory traffic rather than the disk.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: scale latMin latMax lonMin lonMax step YYYY MM DD numDays [pin] [hugepages]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int scaleMode(int argc, char *argv[])
+{
+    GridJob job;                       // the raster and dates
+    GridPlacement plan;                // where the threads run
+    int pin = 0;                       // whether to pin the threads
+    int hugePages = 0;                 // whether to ask for huge pages
+    int valid;                         // whether the arguments are valid
+    int numThreads;                    // threads in the current run
+    int numNodes;                      // nodes the current run's threads are on
+    unsigned char usedNodes[MAXNODES]; // whether the current run has a thread on each node
+    double start;                      // wall clock time at the start of a run (monoSec)
+    double seconds;                    // time the run took
+    double baseSeconds = 0;            // time the run with one thread took
+
+    valid = argc >= 11 && parseGridJob(&job, argv + 2);
+    for (int i = 11; i < argc && valid; i++)
+    {
+        if (strcmp(argv[i], "pin") == 0)
+        {
+            pin = 1;
+        }
+        else if (strcmp(argv[i], "hugepages") == 0)
+        {
+            hugePages = 1;
+        }
+        else
+        {
+            valid = 0;
+        }
+    }
+    if (!valid)
+    {
+        fprintf(stderr, "Usage: %s scale latMin latMax lonMin lonMax step YYYY MM DD numDays [pin] [hugepages]\n", argv[0]);
+        return 1;
+    }
+
+    planPlacement(&plan, 0, pin, hugePages);
+    printf("%d sites x %d days, %d CPUs\n", job.numLat * job.numLon, job.numDays, plan.numCpus);
+    printf("threads nodes  seconds  ns/site-day  speedup  efficiency\n");
+    for (numThreads = 1;; numThreads *= 2)
+    {
+        numThreads = numThreads < plan.numCpus ? numThreads : plan.numCpus;
+        plan.numThreads = numThreads;
+        memset(usedNodes, 0, sizeof(usedNodes));
+        numNodes = 0;
+        for (int t = 0; t < numThreads; t++)
+        {
+            numNodes += !usedNodes[plan.nodes[t]];
+            usedNodes[plan.nodes[t]] = 1;
+        }
+
+        start = monoSec();
+        if (!runGridPlaced(&job, 0, job.numLat, -1, 0, &plan))
+        {
+            fprintf(stderr, "Couldn't allocate the raster\n");
+            return 1;
+        }
+        seconds = monoSec() - start;
+        baseSeconds = numThreads == 1 ? seconds : baseSeconds;
+        printf("%7d %5d %8.2f %12.1f %8.2f %10.0f%%\n", numThreads, numNodes, seconds,
+               seconds * 1e9 / ((double)job.numLat * job.numLon * job.numDays), baseSeconds / seconds,
+               100 * baseSeconds / seconds / numThreads);
+        fflush(stdout);
+        if (numThreads == plan.numCpus)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Profiles the query pipeline on random queries anywhere getCoords accepts, on days between FUZZFIRSTYEAR and
+ * FUZZYEARS later, and prints the profile to stderr (see printProfile). Each query prints a line like serve mode's: a
+ * day with a sunrise or sunset is solved with calcEvent, and a polar day or night walks to the last and next events
+ * with calcEventDay, so every stage but enumeration is exercised. The answers go to stdout.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: profile numQueries [seed]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int profileMode(int argc, char *argv[])
+{
+    Profile prof;         // stage profile
+    long numQueries;      // number of queries
+    double latitude;      // latitude of a query (deg)
+    double longitude;     // longitude of a query (deg)
+    double jDate;         // Julian date of a query
+    double eventDay;      // Julian date of a polar period's event
+    double eventTime;     // time of an event (decimal day)
+    int dayType;          // the type of day, as calcDayType
+    int lastEvent;        // event code of a polar period's last event
+    int year, month, day; // date of a query
+
+    numQueries = argc >= 3 ? atol(argv[2]) : 0;
+    if (argc < 3 || argc > 4 || numQueries < 1)
+    {
+        fprintf(stderr, "Usage: %s profile numQueries [seed]\n", argv[0]);
+        return 1;
+    }
+#ifndef SOLARPROFILE
+    fprintf(stderr, "%s was built without profiling. Rebuild with -DSOLARPROFILE to use profile mode\n", argv[0]);
+    return 1;
+#endif
+    srand(argc == 4 ? atoi(argv[3]) : 1);
+
+    openProfile(&prof);
+    calibrateProfile(&prof);
+    activeProfile = &prof;
+    for (long q = 0; q < numQueries; q++)
+    {
+        latitude = fuzzRandom(-LATRANGE + 0.1, LATRANGE - 0.1);
+        longitude = fuzzRandom(-LONGRANGE + 0.1, LONGRANGE - 0.1);
+        year = FUZZFIRSTYEAR + rand() % FUZZYEARS;
+        month = 1 + rand() % NUMMONTHS;
+        day = 1 + rand() % monthLen(month, year);
+        jDate = calcJDate(day, month, year, 0);
+        dayType = calcDayType(jDate, 0, longitude, latitude);
+
+        profEnter(PROFOUTPUT);
+        printf("%04d-%02d-%02d %g %g", year, month, day, latitude, longitude);
+        profLeave();
+        if (dayType > 0)
+        {
+            for (int e = 1; e <= 3; e++)
+            {
+                eventTime = calcEvent(jDate, 0, longitude, latitude, e);
+                profEnter(PROFOUTPUT);
+                printf(" %c ", "?RNS"[e]);
+                printClock(eventTime);
+                profLeave();
+            }
+        }
+        else
+        {
+            lastEvent = dayType == -1 ? 1 : 3;
+            for (int k = 0; k < 2; k++)
+            {
+                eventDay = calcEventDay(longitude, latitude, 0, jDate, k == 0 ? -lastEvent : 4 - lastEvent);
+                eventTime = eventDay == NOEVENTDAY ? NAN : calcEvent(eventDay, 0, longitude, latitude, k == 0 ? lastEvent : 4 - lastEvent);
+                profEnter(PROFOUTPUT);
+                printServeEvent(eventDay, eventTime, 0);
+                profLeave();
+            }
+        }
+        profEnter(PROFOUTPUT);
+        printf("\n");
+        profLeave();
+    }
+    profEnter(PROFOUTPUT);
+    fflush(stdout);
+    profLeave();
+    activeProfile = NULL;
+
+    replayLibm(&prof);
+    printProfile(stderr, &prof);
+    closeProfile(&prof);
+
+    return 0;
+}
+
+/**
+ * Finds the sunrises and sunsets a moving observer passes through. Reads a track as "latitude longitude timestamp"
+ * lines from stdin, in time order, and prints each event as "rise" or "set" with its timestamp and the observer's
+ * interpolated position. With "bench", times the track walk on a synthetic flight and checks it against sunElevation
+ * at every sample.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: track [epoch s|ms], or track bench numPoints
+ *
+ *  Output:
+ * Program exit status
+ **/
+int trackMode(int argc, char *argv[])
+{
+    static TrackState track; // the track
+    char inputStr[BUFSIZ];   // input line
+    GridJob units;           // timestamp units, parsed as for grid mode
+    TrackEvent event;        // an event passed through
+    double latitude;         // North/South component of a sample's position
+    double longitude;        // East/west component of a sample's position
+    long long timeIn;        // timestamp as read
+    int lineNum = 0;         // input line number
+    long numPoints;          // bench samples
+    double *eventTimes;      // bench events found by the walk, in order
+    long numEvents = 0;      // bench events found by the walk
+    long maxEvents;          // room in eventTimes
+    double *grown;           // eventTimes after growing
+    struct timespec start;   // when a timed run started
+    double lats[LIGHTCHUNK]; // latitudes of a chunk of bench samples
+    double lons[LIGHTCHUNK]; // longitudes of a chunk of bench samples
+    long numChunk;           // bench samples in the chunk
+    double trackSec = 0;     // walk time (s)
+    double scanSec = 0;      // sunElevation time (s)
+    double arg;              // a sample's elevation above TWILIGHTANGLE (deg)
+    double lastArg = 0;      // the previous sample's elevation above TWILIGHTANGLE (deg)
+    double crossTime;        // where the scan puts a crossing
+    long numCrossings = 0;   // crossings found by the scan
+    double maxErr = 0;       // largest difference between the walk's and the scan's event times (s)
+
+    units.epochUnits = SECINDAY;
+    if (argc == 4 && strcmp(argv[2], "bench") == 0)
+    {
+        numPoints = strtol(argv[3], NULL, 10);
+        if (numPoints < 2)
+        {
+            fprintf(stderr, "Usage: %s track bench numPoints\n", argv[0]);
+            return 1;
+        }
+    }
+    else if (argc == 2 || (argc == 4 && strcmp(argv[2], "epoch") == 0 && parseEpochUnits(&units, argv[3])))
+    {
+        numPoints = 0;
+    }
+    else
+    {
+        fprintf(stderr, "Usage: %s track [epoch s|ms] < track.txt\n", argv[0]);
+        fprintf(stderr, "       %s track bench numPoints\n", argv[0]);
+        return 1;
+    }
+    initTrack(&track, units.epochUnits);
+
+    if (numPoints == 0)
+    {
+        while (fgets(inputStr, BUFSIZ, stdin) != NULL)
+        {
+            lineNum++;
+            if (sscanf(inputStr, "%lf %lf %lld", &latitude, &longitude, &timeIn) != 3 || fabs(latitude) > LATRANGE ||
+                fabs(longitude) > LONGRANGE)
+            {
+                fprintf(stderr, "Skipping invalid input on line %d\n", lineNum);
+                continue;
+            }
+            if (!addTrackSample(&track, latitude, longitude, (double)timeIn))
+            {
+                fprintf(stderr, "Skipping out of order input on line %d\n", lineNum);
+                continue;
+            }
+            while (nextTrackEvent(&track, &event))
+            {
+                printf("%s %lld %.5f %.5f\n", event.type == 1 ? "rise" : "set", (long long)llround(event.time),
+                       event.latitude, event.longitude);
+            }
+        }
+        return 0;
+    }
+
+    maxEvents = 1024;
+    eventTimes = malloc(maxEvents * sizeof(double));
+    if (!eventTimes)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (long first = 0; first < numPoints; first += LIGHTCHUNK)
+        {
+            // a flight along TRACKBENCHSPEED degrees of longitude per second, swinging between TRACKBENCHLAT North and
+            // South every TRACKBENCHDAYS days, sampled every second from 2024-01-01. Made outside the timing
+            numChunk = numPoints - first < LIGHTCHUNK ? numPoints - first : LIGHTCHUNK;
+            for (long k = 0; k < numChunk; k++)
+            {
+                lats[k] = TRACKBENCHLAT * sin(2 * M_PI * (first + k) / (TRACKBENCHDAYS * SECINDAY));
+                lons[k] = fmod(TRACKBENCHSPEED * (first + k) + 180, 360) - 180;
+            }
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (long k = 0; k < numChunk && pass == 0; k++)
+            {
+                addTrackSample(&track, lats[k], lons[k], 1704067200.0 + first + k);
+                while (nextTrackEvent(&track, &event))
+                {
+                    if (numEvents == maxEvents)
+                    {
+                        grown = realloc(eventTimes, 2 * maxEvents * sizeof(double));
+                        if (!grown)
+                        {
+                            fprintf(stderr, "Out of memory\n");
+                            free(eventTimes);
+                            return 1;
+                        }
+                        eventTimes = grown;
+                        maxEvents *= 2;
+                    }
+                    eventTimes[numEvents++] = event.time;
+                }
+            }
+            for (long k = 0; k < numChunk && pass == 1; k++)
+            {
+                // the scan puts each crossing where the elevation, linear between samples, crosses TWILIGHTANGLE
+                arg = sunElevation(lats[k], lons[k], 1704067200 + first + k, SECINDAY) - TWILIGHTANGLE;
+                if (first + k > 0 && (arg > 0) != (lastArg > 0))
+                {
+                    crossTime = 1704067200.0 + first + k - 1 + lastArg / (lastArg - arg);
+                    if (numCrossings < numEvents)
+                    {
+                        maxErr = fmax(maxErr, fabs(eventTimes[numCrossings] - crossTime));
+                    }
+                    numCrossings++;
+                }
+                lastArg = arg;
+            }
+            if (pass == 0)
+            {
+                trackSec += elapsedSec(&start);
+            }
+            else
+            {
+                scanSec += elapsedSec(&start);
+            }
+        }
+    }
+
+    printf("points               %ld (1 s apart, %.1f days)\n", numPoints, (double)numPoints / SECINDAY);
+    printf("track walk           %.2f ns per point, %.2f evaluations per point, %d ephemeris evaluations\n",
+           trackSec * 1e9 / numPoints, (double)track.numEvals / numPoints, track.cache.numEvals);
+    printf("sunElevation scan    %.2f ns per point\n", scanSec * 1e9 / numPoints);
+    printf("events               %ld walk, %ld scan\n", numEvents, numCrossings);
+    printf("max time difference  %.3f s\n", maxErr);
+    free(eventTimes);
+
+    return numEvents != numCrossings;
+}
+
+/**
+ * Times the time-major calcEvent kernel against calcEvent day by day, for every sunrise and sunset at one site over a
+ * run of years, and checks that they give the same minutes
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: span latitude longitude timezone YYYY numYears
+ *
+ *  Output:
+ * Program exit status
+ **/
+int spanMode(int argc, char *argv[])
+{
+    SpanLanes lanes;        // lanes of the kernel
+    double latitude;        // site latitude
+    double longitude;       // site longitude
+    double timeZone;        // site time zone in UTC offset
+    int firstYear;          // first year
+    int numYears;           // number of years
+    int numDays = 0;        // days in the run
+    double startJDate;      // first day
+    double *dayTimes;       // calcEvent's sunrises, then sunsets
+    double *spanTimes;      // the kernel's sunrises, then sunsets
+    struct timespec start;  // when a timed run started
+    double daySec;          // calcEvent time (s)
+    double spanSec;         // kernel time (s)
+    double maxDiff = 0;     // largest difference between the two (s)
+    long mismatches = 0;    // events whose minute differs
+
+    if (argc != 7)
+    {
+        fprintf(stderr, "Usage: %s span latitude longitude timezone YYYY numYears\n", argv[0]);
+        return 1;
+    }
+    latitude = atof(argv[2]);
+    longitude = atof(argv[3]);
+    timeZone = atof(argv[4]);
+    firstYear = atoi(argv[5]);
+    numYears = atoi(argv[6]);
+    if (fabs(latitude) >= LATRANGE || fabs(longitude) >= LONGRANGE || fabs(timeZone) > 13 || firstYear <= 0 ||
+        numYears < 1)
+    {
+        fprintf(stderr, "Invalid coordinates, time zone, or years\n");
+        return 1;
+    }
+    for (int y = firstYear; y < firstYear + numYears; y++)
+    {
+        numDays += DAYSINYEAR + isLeapYear(y);
+    }
+    dayTimes = malloc(2 * (size_t)numDays * sizeof(double));
+    spanTimes = malloc(2 * (size_t)numDays * sizeof(double));
+    if (!dayTimes || !spanTimes)
+    {
+        fprintf(stderr, "Out of memory\n");
+        free(dayTimes);
+        free(spanTimes);
+        return 1;
+    }
+    startJDate = calcJDate(1, JAN, firstYear, timeZone);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int d = 0; d < numDays; d++)
+    {
+        dayTimes[d] = calcEvent(startJDate + d, timeZone, longitude, latitude, 1);
+        dayTimes[numDays + d] = calcEvent(startJDate + d, timeZone, longitude, latitude, 3);
+    }
+    daySec = elapsedSec(&start);
+
+    initSpanLanes(&lanes);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    calcEventSpan(&lanes, startJDate, numDays, timeZone, longitude, latitude, 1, spanTimes);
+    calcEventSpan(&lanes, startJDate, numDays, timeZone, longitude, latitude, 3, spanTimes + numDays);
+    spanSec = elapsedSec(&start);
+
+    for (int k = 0; k < 2 * numDays; k++)
+    {
+        mismatches += tableMinute(dayTimes[k]) != tableMinute(spanTimes[k]);
+        if (dayTimes[k] >= -1 && spanTimes[k] >= -1)
+        {
+            maxDiff = fmax(maxDiff, fabs(dayTimes[k] - spanTimes[k]) * SECINDAY);
+        }
+    }
+    printf("events               %d (sunrise and sunset on %d days, %d-%d)\n", 2 * numDays, numDays, firstYear,
+           firstYear + numYears - 1);
+    printf("calcEvent            %.1f ns per event\n", daySec * 1e9 / (2 * numDays));
+    printf("calcEventSpan        %.1f ns per event (%.1fx)\n", spanSec * 1e9 / (2 * numDays), daySec / spanSec);
+    printf("lane use             %.1f%% of %d lanes over %ld sweeps, %.2f steps per event\n",
+           100.0 * lanes.numSteps / (lanes.numSweeps * SPANLANES), SPANLANES, lanes.numSweeps,
+           (double)lanes.numSteps / (2 * numDays));
+    printf("redone by calcEvent  %ld days\n", lanes.numRedone);
+    printf("max difference       %.2e s\n", maxDiff);
+    printf("minute mismatches    %ld\n", mismatches);
+
+    free(dayTimes);
+    free(spanTimes);
+
+    return mismatches > 0;
+}
+
+/**
+ * Serves XYZ map tiles of sunrise, sunset, and day length for any date over HTTP on localhost. A tile is calculated
+ * the first time it's asked for, unless it can be derived from its four children at the next zoom. Tiles are kept
+ * in an LRU memory cache of numTiles tiles in front of a disk cache in cacheDir. When a date has been asked for
+ * TILEPOPULAR times, its tiles down to zoom TILEPREFETCHZOOM are prefetched while no client is waiting. Runs until
+ * SIGINT or SIGTERM, then prints the counters to stderr.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: tiles port cacheDir [memory numTiles]
+ *
+ *  Output:
+ * Program exit status
+ **/
+int tileMode(int argc, char *argv[])
+{
+    static TileState state;           // the service state
+    struct sockaddr_in addr;          // address to listen on
+    socklen_t addrLen = sizeof(addr); // size of the address
+    struct pollfd listener;           // the listening socket, for poll
+    struct sigaction action;          // handler for SIGINT and SIGTERM
+    struct timeval timeout;           // longest wait for a client's request
+    struct stat dirStat;              // the disk cache directory
+    int listenFd;                     // listening socket
+    int fd;                           // a client's connection
+    int capacity = TILECACHE;         // tiles in the memory cache
+    int port;                         // port to listen on, 0 for any free one
+    int one = 1;                      // option value for SO_REUSEADDR
+
+    if ((argc != 4 && argc != 6) || (argc == 6 && strcmp(argv[4], "memory") != 0))
+    {
+        fprintf(stderr, "Usage: %s tiles port cacheDir [memory numTiles]\n", argv[0]);
+        return 1;
+    }
+    port = atoi(argv[2]);
+    capacity = argc == 6 ? atoi(argv[5]) : capacity;
+    if (port < 0 || port > 65535 || capacity < 1)
+    {
+        fprintf(stderr, "Invalid port or memory cache size\n");
+        return 1;
+    }
+    mkdir(argv[3], 0755);
+    if (stat(argv[3], &dirStat) != 0 || !S_ISDIR(dirStat.st_mode))
+    {
+        fprintf(stderr, "Can't use %s as the disk cache\n", argv[3]);
+        return 1;
+    }
+    if (!initTileState(&state, capacity, argv[3]))
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0 || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, TILEBACKLOG) != 0 ||
+        getsockname(listenFd, (struct sockaddr *)&addr, &addrLen) != 0)
+    {
+        fprintf(stderr, "Can't listen on port %d\n", port);
+        if (listenFd >= 0)
+        {
+            close(listenFd);
+        }
+        return 1;
+    }
+    fprintf(stderr, "listening on http://127.0.0.1:%d\n", ntohs(addr.sin_port));
+
+    // without SA_RESTART, so a signal interrupts poll
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopTiles;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    listener.fd = listenFd;
+    listener.events = POLLIN;
+    timeout.tv_sec = TILETIMEOUT;
+    timeout.tv_usec = 0;
+    while (!tilesStopping)
+    {
+        // clients first: a prefetch only runs when no connection is waiting
+        if (poll(&listener, 1, state.queueLen > 0 ? 0 : -1) > 0)
+        {
+            fd = accept(listenFd, NULL, NULL);
+            if (fd >= 0)
+            {
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                serveTileConnection(&state, fd);
+            }
+        }
+        else if (state.queueLen > 0 && !tilesStopping)
+        {
+            prefetchTile(&state);
+        }
+    }
+
+    close(listenFd);
+    printTileStats(stderr, &state);
+    free(state.entries);
+    free(state.pixels);
+    free(state.buckets);
+
+    return 0;
+}
+
+/**
+ * Prints the day/night terminator and the civil, nautical, and astronomical twilight lines at an instant as a GeoJSON
+ * FeatureCollection, either as polygons of the regions where the sun is below each line or as the lines themselves.
+ * With "bench", times calcTerminator on a year of instants and checks its vertices against sunElevation.
+ *
+ *  Inputs:
+ * argc: number of command line arguments
+ * argv: command line arguments: terminator unixTime numVertices [lines], or terminator bench numVertices
+ *
+ *  Output:
+ * Program exit status
+ **/
+int terminatorMode(int argc, char *argv[])
+{
+    static const char *bandNames[TERMBANDS] = {"terminator", "civil", "nautical", "astronomical"}; // names by band
+    static const double bandAltitudes[TERMBANDS] = {TWILIGHTANGLE, CIVILANGLE, NAUTICALANGLE, ASTROANGLE}; // altitudes by band
+    int bench;                   // whether to benchmark
+    int lines = 0;               // whether to print lines instead of polygons
+    int64_t unixTime = 0;        // the instant (Unix seconds)
+    int numVertices;             // vertices per line
+    double *latitude;            // a line's latitudes
+    double *longitude;           // a line's longitudes
+    double *cutLat;              // the line's pieces' latitudes
+    double *cutLong;             // the line's pieces' longitudes
+    double *ringLat;             // a closed piece's latitudes
+    double *ringLong;            // a closed piece's longitudes
+    int starts[TERMPIECES + 1];  // where each piece starts
+    int numPieces;               // pieces of the line
+    double jDate;                // Julian date of the instant
+    double subLat;               // latitude of the subsolar point
+    double subLong;              // longitude of the subsolar point
+    struct timespec start;       // when the timed run started
+    double termSec = 0;          // calcTerminator time (s)
+    double maxAltErr = 0;        // largest error in a vertex's altitude (deg)
+    double maxGap = 0;           // longest segment of a line (km)
+    double gap;                  // length of a segment (km)
+    long pieceCounts[3] = {0};   // lines by shape: closed, around a pole, cut in two
+    int status = 0;              // exit status
+
+    bench = argc == 4 && strcmp(argv[2], "bench") == 0;
+    lines = argc == 5 && strcmp(argv[4], "lines") == 0;
+    if (!bench && argc != 4 && !lines)
+    {
+        fprintf(stderr, "Usage: %s terminator unixTime numVertices [lines]\n", argv[0]);
+        fprintf(stderr, "       %s terminator bench numVertices\n", argv[0]);
+        return 1;
+    }
+    unixTime = bench ? 0 : strtoll(argv[2], NULL, 10);
+    numVertices = atoi(argv[3]);
+    if (numVertices < 4 || numVertices % 2 != 0)
+    {
+        fprintf(stderr, "numVertices must be even and at least 4\n");
+        return 1;
+    }
+    latitude = malloc(numVertices * sizeof(double));
+    longitude = malloc(numVertices * sizeof(double));
+    cutLat = malloc((numVertices + 2 * TERMPIECES + 4) * sizeof(double));
+    cutLong = malloc((numVertices + 2 * TERMPIECES + 4) * sizeof(double));
+    ringLat = malloc((numVertices + 2 * TERMPIECES + 4) * sizeof(double));
+    ringLong = malloc((numVertices + 2 * TERMPIECES + 4) * sizeof(double));
+    if (!latitude || !longitude || !cutLat || !cutLong || !ringLat || !ringLong)
+    {
+        fprintf(stderr, "Out of memory\n");
+        status = 1;
+    }
+    else if (!bench)
+    {
+        jDate = JDATEUNIX + (double)unixTime / SECINDAY;
+        subsolarPoint(jDate, &subLat, &subLong);
+        printf("{\"type\":\"FeatureCollection\",\"features\":[\n");
+        for (int b = 0; b < TERMBANDS; b++)
+        {
+            calcTerminator(jDate, bandAltitudes[b], numVertices, latitude, longitude);
+            numPieces = cutTerminator(latitude, longitude, numVertices, cutLat, cutLong, starts);
+            printTerminatorFeature(bandNames[b], bandAltitudes[b], subLat, cutLat, cutLong, starts, numPieces, lines,
+                                   ringLat, ringLong);
+            printf("%s\n", b < TERMBANDS - 1 ? "," : "");
+        }
+        printf("]}\n");
+    }
+    else
+    {
+        for (int t = 0; t < TERMBENCHLINES; t++)
+        {
+            unixTime = TERMBENCHSTART + (int64_t)t * TERMBENCHSTEP;
+            jDate = JDATEUNIX + (double)unixTime / SECINDAY;
+            for (int b = 0; b < TERMBANDS; b++)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                calcTerminator(jDate, bandAltitudes[b], numVertices, latitude, longitude);
+                termSec += elapsedSec(&start);
+
+                numPieces = cutTerminator(latitude, longitude, numVertices, cutLat, cutLong, starts);
+                pieceCounts[numPieces > 1 ? 2 : cutLong[0] != cutLong[starts[1] - 1]]++;
+                for (int k = 0; k < numVertices; k += TERMCHECKSTRIDE)
+                {
+                    maxAltErr = fmax(maxAltErr, fabs(sunElevation(latitude[k], longitude[k], unixTime, SECINDAY) - bandAltitudes[b]));
+                }
+                for (int k = 0; k < numVertices; k++)
+                {
+                    int next = (k + 1) % numVertices; // the vertex after k
+
+                    gap = 2 * EARTHRADIUS * asin(sqrt(pow(sind((latitude[next] - latitude[k]) / 2), 2) +
+                          cosd(latitude[k]) * cosd(latitude[next]) * pow(sind((longitude[next] - longitude[k]) / 2), 2)));
+                    maxGap = fmax(maxGap, gap);
+                }
+            }
+        }
+        printf("lines                %d (%d instants through %d, %d bands), %d vertices each\n", TERMBANDS * TERMBENCHLINES,
+               TERMBENCHLINES, 2024, TERMBANDS, numVertices);
+        printf("calcTerminator       %.1f us per line, %.2f ns per vertex\n", termSec * 1e6 / (TERMBANDS * TERMBENCHLINES),
+               termSec * 1e9 / ((double)TERMBANDS * TERMBENCHLINES * numVertices));
+        printf("shapes               %ld closed, %ld around a pole, %ld cut in two\n", pieceCounts[0], pieceCounts[1],
+               pieceCounts[2]);
+        printf("max altitude error   %.2e deg (every %dth vertex against sunElevation)\n", maxAltErr, TERMCHECKSTRIDE);
+        printf("max vertex spacing   %.3f km\n", maxGap);
+        status = maxAltErr > TERMCHECKTOL;
+    }
+
+    free(latitude);
+    free(longitude);
+    free(cutLat);
+    free(cutLong);
+    free(ringLat);
+    free(ringLong);
+
+    return status;
+}
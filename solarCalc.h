@@ -0,0 +1,66 @@
+/**
+ * Batch interface to the sunrise/sunset solver, for calling from other languages. Build it as a shared library:
+ *
+ *  gcc -O2 -fopenmp -fPIC -shared -fvisibility=hidden -DSOLARLIB solarCalc.c -lm -o libsolarcalc.so
+ *
+ * Only the functions declared here are exported, and their signatures and meaning don't change within an ABI
+ * version. Every array is owned by the caller, contiguous, and holds count elements. Nothing is allocated, and no
+ * global state is changed, so any number of threads may call at once.
+ **/
+#ifndef SOLARCALC_H
+#define SOLARCALC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SOLARABIVERSION 1
+
+#if defined(__GNUC__)
+#define SOLARAPI __attribute__((visibility("default")))
+#else
+#define SOLARAPI
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Gives the version of this interface the library was built with
+ *
+ *  Inputs:
+ * None
+ *
+ *  Output:
+ * SOLARABIVERSION
+ **/
+SOLARAPI int solarAbiVersion(void);
+
+/**
+ * Calculates sunrise, solar noon, and sunset for arrays of sites and dates, exactly as calcEvent does for one
+ *
+ *  Inputs:
+ * latitude: latitudes (deg, - is south, + is north)
+ * longitude: longitudes (deg, - is west, + is east)
+ * timeZone: time zones in UTC offset (hrs)
+ * jDate: Julian dates of the beginning of each day, as calcJDate gives
+ * count: number of elements in every array
+ * rise: output sunrise, decimal day in local time. NaN if the sun doesn't rise. May be NULL
+ * noon: output solar noon, as rise. May be NULL
+ * set: output sunset, as rise. May be NULL
+ * status: output day type, as calcDayType: -2 night all 24hrs, -1 day all 24hrs, 1 the sun rises or sets but not
+ *  both, 2 it rises and sets. May be NULL
+ * numThreads: number of threads to calculate with, 0 for one per CPU
+ *
+ *  Output:
+ * 1 if the arguments were valid, 0 if not (nothing is written)
+ **/
+SOLARAPI int solarEvents(const double *latitude, const double *longitude, const double *timeZone, const double *jDate,
+                         size_t count, double *rise, double *noon, double *set, int8_t *status, int numThreads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+"""Python binding for solarCalc's batch interface (see solarCalc.h).
+
+Build the library next to this file first:
+
+    gcc -O2 -fopenmp -fPIC -shared -fvisibility=hidden -DSOLARLIB solarCalc.c -lm -o libsolarcalc.so
+
+or point SOLARCALC_LIB at it. The arrays are passed to the library by address, so NumPy arrays (float64 in,
+C-contiguous) and array.array('d') work without copying, and the results are written straight into the output
+arrays. The call releases the GIL (ctypes does so for every CDLL call), so other Python threads keep running, and
+the library splits the work over its own threads.
+"""
+
+import array
+import ctypes
+import os
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+ABI_VERSION = 1
+
+_lib = ctypes.CDLL(os.environ.get("SOLARCALC_LIB", os.path.join(os.path.dirname(os.path.abspath(__file__)), "libsolarcalc.so")))
+_lib.solarAbiVersion.restype = ctypes.c_int
+_lib.solarAbiVersion.argtypes = []
+_lib.solarEvents.restype = ctypes.c_int
+_lib.solarEvents.argtypes = [ctypes.c_void_p] * 4 + [ctypes.c_size_t] + [ctypes.c_void_p] * 4 + [ctypes.c_int]
+
+if _lib.solarAbiVersion() != ABI_VERSION:
+    raise ImportError("libsolarcalc has ABI version %d, expected %d" % (_lib.solarAbiVersion(), ABI_VERSION))
+
+
+def _address(buf, typeCode, writable):
+    """Gives the address and length of a contiguous buffer of typeCode ('d' double or 'b' int8), without copying
+    unless it's a read-only buffer other than a NumPy array. The third item must be kept until the call is done."""
+    interface = getattr(buf, "__array_interface__", None)
+    if interface is not None:
+        # NumPy: the address is in the interface, so read-only arrays work too
+        if interface["typestr"] != ("<f8" if typeCode == "d" else "|i1") or interface.get("strides") is not None:
+            raise TypeError("expected a C-contiguous %s array" % ("float64" if typeCode == "d" else "int8"))
+        if writable and interface["data"][1]:
+            raise ValueError("output array is read-only")
+        length = 1
+        for dim in interface["shape"]:
+            length *= dim
+        return interface["data"][0], length, buf
+    view = memoryview(buf)
+    if view.format != typeCode or not view.c_contiguous:
+        raise TypeError("expected a contiguous buffer of type '%s'" % typeCode)
+    if view.readonly:
+        if writable:
+            raise ValueError("output buffer is read-only")
+        # ctypes can only take the address of a writable buffer
+        view = memoryview(bytearray(view)).cast(typeCode)
+    if not view.nbytes:
+        return None, 0, view
+    holder = (ctypes.c_char * view.nbytes).from_buffer(view.cast("B"))
+    return ctypes.addressof(holder), len(view), holder
+
+
+def _empty(count, typeCode):
+    """Makes an output array: a NumPy array if NumPy is installed, array.array if not."""
+    if numpy is not None:
+        return numpy.empty(count, numpy.float64 if typeCode == "d" else numpy.int8)
+    return array.array(typeCode, bytes(count * (8 if typeCode == "d" else 1)))
+
+
+def events(latitude, longitude, timeZone, jDate, threads=0, rise=None, noon=None, set=None, status=None):
+    """Calculates sunrise, solar noon, and sunset for arrays of sites and dates, as calcEvent does for one.
+
+    latitude, longitude (deg), timeZone (UTC offset, hrs), and jDate (Julian date of the beginning of the day) are
+    equal-length float64 buffers. Times come back as decimal days in local time, NaN where the event doesn't
+    happen, and status as calcDayType (-2 night all day, -1 day all day, 1 only a sunrise or sunset, 2 both).
+    Output buffers may be passed in to be filled; the rest are allocated. threads is the number of threads, 0 for
+    one per CPU.
+
+    Returns (rise, noon, set, status).
+    """
+    inputs = [_address(buf, "d", False) for buf in (latitude, longitude, timeZone, jDate)]
+    count = inputs[0][1]
+    if any(length != count for _, length, _ in inputs):
+        raise ValueError("latitude, longitude, timeZone, and jDate must have the same length")
+    outputs = [buf if buf is not None else _empty(count, "d") for buf in (rise, noon, set)]
+    outputs.append(status if status is not None else _empty(count, "b"))
+    addresses = [_address(buf, "d" if i < 3 else "b", True) for i, buf in enumerate(outputs)]
+    if any(length != count for _, length, _ in addresses):
+        raise ValueError("output arrays must have the same length as the inputs")
+
+    if not _lib.solarEvents(*[address for address, _, _ in inputs], count, *[address for address, _, _ in addresses], threads):
+        raise ValueError("invalid arguments (threads must be 0 or more)")
+
+    return tuple(outputs)